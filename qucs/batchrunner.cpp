@@ -0,0 +1,534 @@
+/***************************************************************************
+                              batchrunner.cpp
+                             -----------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "batchrunner.h"
+#include "schematic.h"
+#include "module.h"
+#include "subcircuitcache.h"
+#include "main.h"
+#include "extsimkernels/ngspice.h"
+#include "extsimkernels/xyce.h"
+#include "extsimkernels/spicecompat.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QTimer>
+#include <QEventLoop>
+#include <QThread>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <stdio.h>
+#include <algorithm>
+
+/*!
+  \file batchrunner.cpp
+  \brief Implementation of the BatchRunner class
+*/
+
+BatchRunner::BatchRunner(QObject *parent)
+    : QObject(parent)
+{
+    Simulator = spicecompat::simNgspice;
+    MaxJobs = 0;
+    Timeout = 0;
+    CheckScheduled = false;
+    Loop = 0;
+}
+
+BatchRunner::~BatchRunner()
+{
+    qDeleteAll(Jobs);
+}
+
+/*!
+ * \brief BatchRunner::setSimulator Select Ngspice (spicecompat::simNgspice)
+ *        or Xyce (spicecompat::simXyceSer).
+ */
+void BatchRunner::setSimulator(int simulator)
+{
+    Simulator = simulator;
+}
+
+/*!
+ * \brief BatchRunner::setJobs Maximum number of concurrent simulations,
+ *        0 means one per core.
+ */
+void BatchRunner::setJobs(int jobs)
+{
+    MaxJobs = jobs;
+}
+
+/*!
+ * \brief BatchRunner::setTimeout Wall-clock limit of one job in seconds,
+ *        0 means no limit.
+ */
+void BatchRunner::setTimeout(int seconds)
+{
+    Timeout = seconds;
+}
+
+/*!
+ * \brief BatchRunner::setSummaryFile File name of the JSON summary. The
+ *        summary goes to stdout if no file is set.
+ */
+void BatchRunner::setSummaryFile(const QString &file)
+{
+    SummaryFile = file;
+}
+
+/*!
+ * \brief BatchRunner::expandInputs Turn the command line arguments into
+ *        file names. An argument is a file name, a wildcard pattern in
+ *        the file name part (e.g. "tests/amp*.sch") or "@file" with one
+ *        such argument per line. Relative names in a list file are
+ *        relative to the list file.
+ */
+QStringList BatchRunner::expandInputs(const QStringList &patterns)
+{
+    QStringList files;
+    for (const QString &pattern : patterns) {
+        if (pattern.startsWith('@')) {
+            QFile list(pattern.mid(1));
+            if (!list.open(QIODevice::ReadOnly)) {
+                files.append(pattern.mid(1));  // reported as missing input
+                continue;
+            }
+            QDir listDir = QFileInfo(list).absoluteDir();
+            QStringList entries;
+            QTextStream stream(&list);
+            while (!stream.atEnd()) {
+                QString line = stream.readLine().trimmed();
+                if (line.isEmpty() || line.startsWith('#')) continue;
+                entries.append(QDir::isRelativePath(line) ? listDir.filePath(line) : line);
+            }
+            files += expandInputs(entries);
+            continue;
+        }
+
+        QFileInfo info(pattern);
+        QString name = info.fileName();
+        if (name.contains('*') || name.contains('?') || name.contains('[')) {
+            QDir dir = info.absoluteDir();
+            for (const QString &entry : dir.entryList(QStringList(name), QDir::Files, QDir::Name))
+                files.append(dir.absoluteFilePath(entry));
+        } else {
+            files.append(info.absoluteFilePath());
+        }
+    }
+    files.removeDuplicates();
+    return files;
+}
+
+/*!
+ * \brief BatchRunner::addInputs Queue the schematics and netlists given by
+ *        the arguments, see expandInputs().
+ * \return Number of queued jobs
+ */
+int BatchRunner::addInputs(const QStringList &patterns)
+{
+    for (const QString &file : expandInputs(patterns)) {
+        BatchJob *job = new BatchJob;
+        job->input = file;
+        job->isNetlist = !file.endsWith(".sch", Qt::CaseInsensitive);
+        job->sch = 0;
+        job->kernel = 0;
+        job->process = 0;
+        job->timer = 0;
+        job->finished = job->failed = job->timedOut = false;
+        job->loadMs = job->netlistMs = job->simulateMs = job->convertMs = 0;
+        Jobs.append(job);
+    }
+    return Jobs.count();
+}
+
+/*!
+ * \brief BatchRunner::run Simulate all queued jobs and write the summary.
+ * \return 0 if every job succeeded, 1 otherwise
+ */
+int BatchRunner::run()
+{
+    QElapsedTimer total;
+    total.start();
+
+    QucsSettings.DefaultSimulator = Simulator;
+    Module::registerModules();
+
+    // every job gets its own directory below the simulator working directory
+    QString base = QucsSettings.S4Qworkdir + QDir::separator() + "batch";
+    QDir(base).removeRecursively();
+    for (int i = 0; i < Jobs.count(); i++) {
+        Jobs[i]->workdir = base + QDir::separator() + QString::number(i + 1);
+        QDir().mkpath(Jobs[i]->workdir);
+    }
+
+    if (MaxJobs <= 0) MaxJobs = QThread::idealThreadCount();
+    Queue = Jobs;
+
+    // the kernels run analyses and sweep shards concurrently by themselves,
+    // share the cores between the jobs so at most about one simulator
+    // process per core is started
+    unsigned int xyceJobs = QucsSettings.XyceJobs;
+    unsigned int ngspiceShards = QucsSettings.NgspiceShards;
+    unsigned int perJob = std::max(1, QThread::idealThreadCount() / MaxJobs);
+    QucsSettings.XyceJobs = (xyceJobs > 0) ? std::min(xyceJobs, perJob) : perJob;
+    QucsSettings.NgspiceShards = (ngspiceShards > 0) ? std::min(ngspiceShards, perJob) : perJob;
+
+    QEventLoop loop;
+    Loop = &loop;
+    startJobs();
+    if (!Running.isEmpty()) loop.exec();
+    Loop = 0;
+    SubcircuitCache::clear();
+    QucsSettings.XyceJobs = xyceJobs;
+    QucsSettings.NgspiceShards = ngspiceShards;
+
+    bool ok = writeSummary(total.elapsed());
+    for (BatchJob *job : Jobs)
+        if (job->status != "ok") ok = false;
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------
+void BatchRunner::startJobs()
+{
+    while (!Queue.isEmpty() && Running.count() < MaxJobs) {
+        BatchJob *job = Queue.takeFirst();
+        Running.append(job);
+        fprintf(stderr, "[%d/%d] %s\n", (int) Jobs.indexOf(job) + 1, (int) Jobs.count(),
+                job->input.toLocal8Bit().data());
+
+        if (Timeout > 0) {
+            job->timer = new QTimer(this);
+            job->timer->setSingleShot(true);
+            connect(job->timer,SIGNAL(timeout()),this,SLOT(slotTimeout()));
+            job->timer->start(Timeout * 1000);
+        }
+
+        job->clock.start();
+        if (!QFile::exists(job->input)) {
+            job->status = "error";
+            job->message = "File not found";
+            job->finished = true;
+            scheduleCheck();
+        } else if (job->isNetlist) {
+            startNetlistJob(job);
+        } else {
+            startSchematicJob(job);
+        }
+    }
+
+    if (Queue.isEmpty() && Running.isEmpty() && Loop)
+        Loop->quit();
+}
+
+/*!
+ * \brief BatchRunner::startSchematicJob Load the schematic, write its
+ *        netlist and start the simulator. The kernels and the XSPICE code
+ *        model builder take their working directory from the settings, so
+ *        it points to the job directory while the job is set up.
+ */
+void BatchRunner::startSchematicJob(BatchJob *job)
+{
+    job->sch = new Schematic(0, job->input);
+    if (!job->sch->loadDocument()) {
+        job->status = "error";
+        job->message = "Could not load schematic";
+        job->finished = true;
+        scheduleCheck();
+        return;
+    }
+    job->loadMs = job->clock.restart();
+    job->dataset = QFileInfo(job->input).absoluteDir().filePath(job->sch->DataSet);
+
+    QString workdir = QucsSettings.S4Qworkdir;
+    QucsSettings.S4Qworkdir = job->workdir;
+    if (Simulator == spicecompat::simXyceSer) job->kernel = new Xyce(job->sch, this);
+    else job->kernel = new Ngspice(job->sch, this);
+    connect(job->kernel,SIGNAL(finished()),this,SLOT(slotJobFinished()));
+    connect(job->kernel,SIGNAL(errors(QProcess::ProcessError)),
+            this,SLOT(slotJobError(QProcess::ProcessError)));
+    job->kernel->slotSimulate();
+    QucsSettings.S4Qworkdir = workdir;
+    job->netlistMs = job->clock.restart();
+}
+
+/*!
+ * \brief BatchRunner::startNetlistJob Run the simulator on a netlist in
+ *        the directory of the netlist, so relative includes are found.
+ */
+void BatchRunner::startNetlistJob(BatchJob *job)
+{
+    QStringList args;
+    QString cmd = simulatorCommand(args);
+    args.append(job->input);
+
+    job->process = new QProcess(this);
+    job->process->setProcessChannelMode(QProcess::MergedChannels);
+    job->process->setWorkingDirectory(QFileInfo(job->input).absolutePath());
+    connect(job->process,SIGNAL(finished(int,QProcess::ExitStatus)),
+            this,SLOT(slotNetlistFinished(int,QProcess::ExitStatus)));
+    connect(job->process,SIGNAL(errorOccurred(QProcess::ProcessError)),
+            this,SLOT(slotJobError(QProcess::ProcessError)));
+    job->process->start(cmd, args);
+}
+
+// ---------------------------------------------------------------------
+QString BatchRunner::simulatorCommand(QStringList &args)
+{
+    if (Simulator == spicecompat::simXyceSer)
+        return QucsSettings.XyceExecutable;
+
+    args.append("-b");
+    if (QFileInfo(QucsSettings.NgspiceExecutable).isRelative())
+        return QFileInfo(QucsSettings.BinDir + QucsSettings.NgspiceExecutable).absoluteFilePath();
+    return QFileInfo(QucsSettings.NgspiceExecutable).absoluteFilePath();
+}
+
+/*!
+ * \brief BatchRunner::slotJobFinished The simulator of a schematic ended.
+ */
+void BatchRunner::slotJobFinished()
+{
+    BatchJob *job = findJob(sender());
+    if (job == 0) return;
+    job->finished = true;
+    scheduleCheck();
+}
+
+/*!
+ * \brief BatchRunner::slotNetlistFinished The simulator of a netlist ended.
+ */
+void BatchRunner::slotNetlistFinished(int exitCode, QProcess::ExitStatus status)
+{
+    BatchJob *job = findJob(sender());
+    if (job == 0) return;
+    if (status != QProcess::NormalExit || exitCode != 0) {
+        job->failed = true;
+        if (job->message.isEmpty())
+            job->message = QString("Simulator exit code %1").arg(exitCode);
+    }
+    job->finished = true;
+    scheduleCheck();
+}
+
+/*!
+ * \brief BatchRunner::slotJobError A simulator could not be started or
+ *        crashed. Only a failed start ends the job, otherwise the
+ *        finished signal follows.
+ */
+void BatchRunner::slotJobError(QProcess::ProcessError err)
+{
+    BatchJob *job = findJob(sender());
+    if (job == 0) return;
+    job->failed = true;
+    if (job->message.isEmpty()) {
+        switch (err) {
+        case QProcess::FailedToStart: job->message = "Simulator failed to start"; break;
+        case QProcess::Crashed: job->message = "Simulator crashed"; break;
+        default: job->message = "Simulator error"; break;
+        }
+    }
+    if (err == QProcess::FailedToStart) {
+        job->finished = true;
+        scheduleCheck();
+    }
+}
+
+/*!
+ * \brief BatchRunner::slotTimeout A job reached the wall-clock limit and
+ *        its simulator is killed.
+ */
+void BatchRunner::slotTimeout()
+{
+    BatchJob *job = findJob(sender());
+    if (job == 0 || job->finished) return;
+    job->timedOut = true;
+    job->message = QString("Timeout after %1 s").arg(Timeout);
+    if (job->kernel) job->kernel->killThemAll();
+    if (job->process) job->process->kill();
+}
+
+/*!
+ * \brief BatchRunner::slotCheckJobs Complete the finished jobs and start
+ *        the next ones. Runs from the event loop, so the kernel which
+ *        reported the end is not deleted inside its own signal.
+ */
+void BatchRunner::slotCheckJobs()
+{
+    CheckScheduled = false;
+    QList<BatchJob*> running = Running;
+    for (BatchJob *job : running) {
+        if (!job->finished) continue;
+        completeJob(job);
+        Running.removeOne(job);
+    }
+    startJobs();
+}
+
+// ---------------------------------------------------------------------
+void BatchRunner::scheduleCheck()
+{
+    if (CheckScheduled) return;
+    CheckScheduled = true;
+    QTimer::singleShot(0, this, SLOT(slotCheckJobs()));
+}
+
+/*!
+ * \brief BatchRunner::completeJob Save the simulator log, convert the
+ *        results into the dataset and release the job.
+ */
+void BatchRunner::completeJob(BatchJob *job)
+{
+    if (job->timer) job->timer->stop();
+
+    QString output;
+    if (job->kernel) output = job->kernel->getOutput();
+    if (job->process) output = QString::fromLocal8Bit(job->process->readAll());
+    if (job->kernel || job->process) {
+        job->simulateMs = job->clock.restart();
+        job->log = job->workdir + QDir::separator() + "simulator.log";
+        QFile logfile(job->log);
+        if (logfile.open(QIODevice::WriteOnly)) {
+            QTextStream ts(&logfile);
+            ts<<output;
+            logfile.close();
+        }
+    }
+
+    if (!job->status.isEmpty()) {
+        // not started: load error or missing file
+    } else if (job->timedOut) {
+        job->status = "timeout";
+    } else if (job->failed) {
+        job->status = "failed";
+    } else if (job->kernel) {
+        QFile::remove(job->dataset);
+        job->kernel->convertToQucsData(job->dataset);
+        job->convertMs = job->clock.restart();
+        if (job->kernel->hasErrors()) {
+            job->status = "failed";
+            job->message = "Simulator reported errors";
+        } else if (!hasData(job->dataset)) {
+            job->status = "failed";
+            job->message = "No results in the dataset";
+        } else {
+            job->status = "ok";
+        }
+    } else {
+        job->status = "ok";
+    }
+
+    fprintf(stderr, "%s: %s%s%s\n", job->status.toLatin1().data(),
+            job->input.toLocal8Bit().data(),
+            job->message.isEmpty() ? "" : " - ",
+            job->message.toLocal8Bit().data());
+
+    if (job->timer) job->timer->deleteLater();
+    if (job->kernel) job->kernel->deleteLater();
+    if (job->process) job->process->deleteLater();
+    if (job->sch) job->sch->deleteLater();
+    job->timer = 0;
+    job->kernel = 0;
+    job->process = 0;
+    job->sch = 0;
+}
+
+/*!
+ * \brief BatchRunner::hasData Whether a dataset holds at least one
+ *        variable. The conversion writes the header even if the simulator
+ *        left no results.
+ */
+bool BatchRunner::hasData(const QString &dataset)
+{
+    QFile file(dataset);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine();
+        if (line.startsWith("<indep ") || line.startsWith("<dep ")) return true;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------
+BatchRunner::BatchJob *BatchRunner::findJob(QObject *object)
+{
+    for (BatchJob *job : Running) {
+        if (object == job->kernel || object == job->process || object == job->timer)
+            return job;
+    }
+    return 0;
+}
+
+/*!
+ * \brief BatchRunner::writeSummary Write status and phase timings of all
+ *        jobs as JSON.
+ */
+bool BatchRunner::writeSummary(qint64 totalMs)
+{
+    QJsonArray results;
+    int passed = 0;
+    for (BatchJob *job : Jobs) {
+        QJsonObject phases;
+        phases["load_ms"] = (double) job->loadMs;
+        phases["netlist_ms"] = (double) job->netlistMs;
+        phases["simulate_ms"] = (double) job->simulateMs;
+        phases["convert_ms"] = (double) job->convertMs;
+
+        QJsonObject result;
+        result["input"] = job->input;
+        result["type"] = job->isNetlist ? "netlist" : "schematic";
+        result["status"] = job->status;
+        if (!job->message.isEmpty()) result["message"] = job->message;
+        if (!job->dataset.isEmpty() && job->status == "ok") result["dataset"] = job->dataset;
+        if (!job->log.isEmpty()) result["log"] = job->log;
+        result["phases"] = phases;
+        result["total_ms"] = (double) (job->loadMs + job->netlistMs +
+                                       job->simulateMs + job->convertMs);
+        results.append(result);
+        if (job->status == "ok") passed++;
+    }
+
+    QJsonObject summary;
+    summary["simulator"] = Simulator == spicecompat::simXyceSer ? "xyce" : "ngspice";
+    summary["jobs"] = MaxJobs;
+    summary["timeout_s"] = Timeout;
+    summary["passed"] = passed;
+    summary["failed"] = (int) Jobs.count() - passed;
+    summary["total_ms"] = (double) totalMs;
+    summary["results"] = results;
+    QByteArray json = QJsonDocument(summary).toJson();
+
+    if (SummaryFile.isEmpty()) {
+        fwrite(json.constData(), 1, json.size(), stdout);
+        return true;
+    }
+    QFile file(SummaryFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        fprintf(stderr, "Error: Could not write summary %s\n", SummaryFile.toLocal8Bit().data());
+        return false;
+    }
+    file.write(json);
+    file.close();
+    return true;
+}
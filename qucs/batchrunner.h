@@ -0,0 +1,119 @@
+/***************************************************************************
+                               batchrunner.h
+                              ---------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QProcess>
+#include <QElapsedTimer>
+
+class QEventLoop;
+class QTimer;
+class Schematic;
+class AbstractSpiceKernel;
+
+/*!
+  \file batchrunner.h
+  \brief Declaration of the BatchRunner class
+*/
+
+/*!
+ * \brief The BatchRunner class simulates a list of schematics and SPICE
+ *        netlists from the command line (qucs-s --batch).
+ *
+ *        Schematics are loaded and netlisted one after another in the main
+ *        thread. The simulators run as concurrent processes, at most
+ *        setJobs() of them, each job in its own working directory. A job
+ *        exceeding the wall-clock timeout is killed. The dataset of a
+ *        schematic is written next to it, as the GUI does. Netlists are
+ *        passed to the simulator unchanged and only their exit status is
+ *        checked.
+ *
+ *        When all jobs are done, a JSON summary with the status and the
+ *        phase timings (load, netlist, simulate, convert) of every job is
+ *        written.
+ */
+class BatchRunner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BatchRunner(QObject *parent = 0);
+    ~BatchRunner();
+
+    void setSimulator(int simulator);
+    void setJobs(int jobs);
+    void setTimeout(int seconds);
+    void setSummaryFile(const QString &file);
+    int addInputs(const QStringList &patterns);
+    int run();
+
+    static QStringList expandInputs(const QStringList &patterns);
+
+private slots:
+    void slotJobFinished();
+    void slotJobError(QProcess::ProcessError err);
+    void slotNetlistFinished(int exitCode, QProcess::ExitStatus status);
+    void slotTimeout();
+    void slotCheckJobs();
+
+private:
+    //! One schematic or netlist of the batch
+    struct BatchJob {
+        QString input;       //!< absolute file name of the schematic or netlist
+        QString dataset;     //!< dataset written next to the schematic
+        QString workdir;     //!< netlist and simulator outputs of the job
+        QString log;         //!< simulator output
+        bool isNetlist;      //!< SPICE netlist, run without conversion
+        Schematic *sch;
+        AbstractSpiceKernel *kernel;
+        QProcess *process;   //!< simulator of a netlist job
+        QTimer *timer;       //!< wall-clock timeout
+        bool finished;       //!< simulator ended, waiting for completion
+        bool failed;
+        bool timedOut;
+        QString status;      //!< ok, failed, timeout or error
+        QString message;
+        qint64 loadMs, netlistMs, simulateMs, convertMs;
+        QElapsedTimer clock;
+    };
+
+    void startJobs();
+    void startSchematicJob(BatchJob *job);
+    void startNetlistJob(BatchJob *job);
+    void completeJob(BatchJob *job);
+    static bool hasData(const QString &dataset);
+    BatchJob *findJob(QObject *object);
+    void scheduleCheck();
+    QString simulatorCommand(QStringList &args);
+    bool writeSummary(qint64 totalMs);
+
+    int Simulator;
+    int MaxJobs;
+    int Timeout;           // seconds, 0 = no limit
+    QString SummaryFile;   // empty = stdout
+    bool CheckScheduled;
+
+    QList<BatchJob*> Jobs;     // all jobs in input order
+    QList<BatchJob*> Queue;    // jobs not started yet
+    QList<BatchJob*> Running;
+    QEventLoop *Loop;
+};
+
+#endif // BATCHRUNNER_H
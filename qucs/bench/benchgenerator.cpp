@@ -0,0 +1,270 @@
+/***************************************************************************
+                             benchgenerator.cpp
+                            --------------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "benchgenerator.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+
+#include <cmath>
+
+/*!
+  \file benchgenerator.cpp
+  \brief Implementation of the BenchGenerator class
+*/
+
+// elements per row of the generated grids
+#define LADDER_COLUMNS  50
+#define MOS_COLUMNS     40
+#define DIAGRAM_COLUMNS  8
+
+static const char *DCSimulation =
+  "<.DC DC1 1 0 -100 0 47 0 0 \"26.85\" 0 \"0.001\" 0 \"1 pA\" 0 \"1 uV\" 0"
+  " \"no\" 0 \"150\" 0 \"no\" 0 \"none\" 0 \"CroutLU\" 0>";
+
+BenchGenerator::BenchGenerator(const QString &dir) : Dir(dir)
+{
+  QDir().mkpath(Dir);
+  Cnt.components = Cnt.wires = Cnt.diagrams = Cnt.instances = 0;
+}
+
+/*!
+ * \brief BenchGenerator::resistorLadder Rows of resistor ladders,
+ *        each fed by its own DC source.
+ * \param resistors Number of resistors (series and shunt)
+ * \return Absolute file name of the schematic
+ */
+QString BenchGenerator::resistorLadder(int resistors)
+{
+  QString comps, wires;
+  Cnt.components = Cnt.wires = Cnt.diagrams = 0;
+  comps += component(DCSimulation);
+
+  int placed = 0;
+  for (int row = 0; placed < resistors; row++) {
+    int y = 100 + row * 200;
+    comps += component(QString("<Vdc V%1 1 100 %2 18 -26 0 1 \"1 V\" 1>").
+                       arg(row + 1).arg(y + 60));
+    comps += component(QString("<GND * 1 100 %1 0 0 0 0>").arg(y + 90));
+    wires += wire(100, y, 100, y + 30);
+
+    for (int col = 0; col < LADDER_COLUMNS && placed < resistors; col++) {
+      int x = 100 + col * 120;
+      int node = x + 120;
+      comps += component(QString("<R R%1 1 %2 %3 -26 15 0 0 \"1k\" 1 \"26.85\" 0"
+                         " \"0.0\" 0 \"0.0\" 0 \"26.85\" 0 \"european\" 0>").
+                         arg(++placed).arg(x + 30).arg(y));
+      wires += wire(x + 60, y, node, y);
+      if (placed >= resistors) break;
+
+      comps += component(QString("<R R%1 1 %2 %3 15 -26 0 1 \"1k\" 1 \"26.85\" 0"
+                         " \"0.0\" 0 \"0.0\" 0 \"26.85\" 0 \"european\" 0>").
+                         arg(++placed).arg(node).arg(y + 60));
+      comps += component(QString("<GND * 1 %1 %2 0 0 0 0>").arg(node).arg(y + 90));
+      wires += wire(node, y, node, y + 30);
+    }
+  }
+  Cnt.instances = Cnt.components;
+  return writeSchematic("bench_ladder.sch", comps, wires);
+}
+
+/*!
+ * \brief BenchGenerator::mosArray Grid of MOSFETs with common gate and
+ *        drain nets, connected by wire labels.
+ * \param transistors Number of transistors
+ * \return Absolute file name of the schematic
+ */
+QString BenchGenerator::mosArray(int transistors)
+{
+  QString comps, wires;
+  Cnt.components = Cnt.wires = Cnt.diagrams = 0;
+  comps += component(DCSimulation);
+  comps += component("<Vdc VG 1 40 100 18 -26 0 1 \"1.5 V\" 1>");
+  comps += component("<GND * 1 40 130 0 0 0 0>");
+  wires += wire(40, 40, 40, 70, "vg");
+  comps += component("<Vdc VD 1 40 300 18 -26 0 1 \"3.3 V\" 1>");
+  comps += component("<GND * 1 40 330 0 0 0 0>");
+  wires += wire(40, 210, 40, 270, "vd");
+
+  for (int i = 0; i < transistors; i++) {
+    int x = 200 + (i % MOS_COLUMNS) * 120;
+    int y = 100 + (i / MOS_COLUMNS) * 160;
+    comps += component(QString("<_MOSFET T%1 1 %2 %3 8 -26 0 0 \"nfet\" 0"
+                       " \"1.0 V\" 1 \"2e-5\" 1>").arg(i + 1).arg(x).arg(y));
+    comps += component(QString("<GND * 1 %1 %2 0 0 0 0>").arg(x).arg(y + 30));
+    wires += wire(x - 60, y, x - 30, y, "vg");
+    wires += wire(x, y - 60, x, y - 30, "vd");
+  }
+  Cnt.instances = Cnt.components;
+  return writeSchematic("bench_mos.sch", comps, wires);
+}
+
+/*!
+ * \brief BenchGenerator::subcircuitHierarchy Subcircuits nested "depth"
+ *        levels deep, every level instantiating the next one "fanout"
+ *        times. Each level holds a resistor between its two ports.
+ * \return Absolute file name of the top level schematic
+ */
+QString BenchGenerator::subcircuitHierarchy(int depth, int fanout)
+{
+  int instances = 0, perLevel = 1;
+  for (int level = 1; level <= depth; level++) {
+    QString comps, wires;
+    comps += component("<Port P1 1 100 100 -23 12 0 0 \"1\" 1 \"analog\" 0 \"v\" 0 \"\" 0>");
+    comps += component("<R R1 1 160 100 -26 15 0 0 \"1k\" 1 \"26.85\" 0"
+                       " \"0.0\" 0 \"0.0\" 0 \"26.85\" 0 \"european\" 0>");
+    comps += component("<Port P2 1 220 100 4 12 1 2 \"2\" 1 \"analog\" 0 \"v\" 0 \"\" 0>");
+    wires += wire(100, 100, 130, 100);
+    wires += wire(190, 100, 220, 100);
+    if (level < depth)
+      for (int i = 0; i < fanout; i++)
+        comps += component(QString("<Sub SUB%1 1 %2 300 -26 40 0 0 \"bench_hier_%3.sch\" 0>").
+                           arg(i + 1).arg(100 + i * 200).arg(level + 1));
+    writeSchematic(QString("bench_hier_%1.sch").arg(level), comps, wires);
+
+    perLevel *= fanout;
+    instances += perLevel * (level < depth ? 3 + fanout : 3);
+  }
+
+  QString comps, wires;
+  Cnt.components = Cnt.wires = Cnt.diagrams = 0;
+  comps += component(DCSimulation);
+  for (int i = 0; i < fanout; i++)
+    comps += component(QString("<Sub SUB%1 1 %2 100 -26 40 0 0 \"bench_hier_1.sch\" 0>").
+                       arg(i + 1).arg(100 + i * 200));
+  Cnt.instances = Cnt.components + instances;
+  return writeSchematic("bench_hierarchy.sch", comps, wires);
+}
+
+/*!
+ * \brief BenchGenerator::diagramPage A page full of cartesian diagrams
+ *        showing the variables of a dataset.
+ * \param diagrams Number of diagrams
+ * \param graphs Number of graphs per diagram
+ * \param dataSet Dataset file name relative to the schematic
+ * \param vars Dataset variables the graphs show, used round robin
+ * \return Absolute file name of the schematic
+ */
+QString BenchGenerator::diagramPage(int diagrams, int graphs, const QString &dataSet,
+                                    const QStringList &vars)
+{
+  static const char *colors[] = { "0000ff", "ff0000", "00ff00", "ff00ff" };
+  QString diags;
+  Cnt.components = Cnt.wires = Cnt.diagrams = 0;
+  int var = 0;
+  for (int i = 0; i < diagrams; i++) {
+    int x = 50 + (i % DIAGRAM_COLUMNS) * 450;
+    int y = 350 + (i / DIAGRAM_COLUMNS) * 350;
+    diags += QString("  <Rect %1 %2 400 300 3 #c0c0c0 1 00 1 0 0.2 1 1 -0.1 0.5"
+                     " 1.1 1 -0.1 0.5 1.1 315 0 225 \"\" \"\" \"\">\n").arg(x).arg(y);
+    for (int g = 0; g < graphs && !vars.isEmpty(); g++) {
+      diags += QString("\t<\"%1\" #%2 0 3 0 0 0>\n").
+               arg(vars.at(var++ % vars.size())).arg(colors[g % 4]);
+    }
+    diags += "  </Rect>\n";
+    Cnt.diagrams++;
+  }
+  Cnt.instances = 0;
+  return writeSchematic("bench_diagrams.sch", "", "", diags, dataSet);
+}
+
+/*!
+ * \brief BenchGenerator::ngspiceRawFile Transient output in the ASCII
+ *        rawfile format Ngspice writes for Qucs-S ("set filetype=ascii").
+ * \param variables Number of variables including the time
+ * \param points Number of time points
+ * \return File name relative to the output directory
+ */
+QString BenchGenerator::ngspiceRawFile(int variables, int points)
+{
+  QString name = "bench_tran.plot";
+  QFile file(Dir + "/" + name);
+  if (!file.open(QIODevice::WriteOnly)) return QString();
+
+  QTextStream stream(&file);
+  stream << "Title: qucs-bench\n"
+         << "Date: Mon Jan  1 00:00:00  2024\n"
+         << "Plotname: Transient Analysis\n"
+         << "Flags: real\n"
+         << "No. Variables: " << variables << "\n"
+         << "No. Points: " << points << "\n"
+         << "Variables:\n"
+         << "\t0\ttime\ttime\n";
+  for (int v = 1; v < variables; v++)
+    stream << "\t" << v << "\tv(n" << v << ")\tvoltage\n";
+  stream << "Values:\n";
+
+  for (int p = 0; p < points; p++) {
+    double t = p * 1e-9;
+    stream << " " << p << "\t" << QString::number(t, 'e', 15) << "\n";
+    for (int v = 1; v < variables; v++)
+      stream << "\t" << QString::number(std::sin(2e7 * t + v), 'e', 15) << "\n";
+    stream << "\n";
+  }
+  file.close();
+  return name;
+}
+
+// ---------------------------------------------------------------------
+QString BenchGenerator::writeSchematic(const QString &name, const QString &components,
+                                       const QString &wires, const QString &diagrams,
+                                       const QString &dataSet)
+{
+  QString fileName = Dir + "/" + name;
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly)) return QString();
+
+  QString base = name.left(name.length() - 4);
+  QTextStream stream(&file);
+  stream << "<Qucs Schematic " PACKAGE_VERSION ">\n"
+         << "<Properties>\n"
+         << "  <View=0,-200,4000,3000,1,0,0>\n"
+         << "  <Grid=10,10,1>\n"
+         << "  <DataSet=" << (dataSet.isEmpty() ? base + ".dat" : dataSet) << ">\n"
+         << "  <DataDisplay=" << base << ".dpl>\n"
+         << "  <OpenDisplay=0>\n"
+         << "  <showFrame=0>\n"
+         << "</Properties>\n"
+         << "<Symbol>\n</Symbol>\n"
+         << "<Components>\n" << components << "</Components>\n"
+         << "<Wires>\n" << wires << "</Wires>\n"
+         << "<Diagrams>\n" << diagrams << "</Diagrams>\n"
+         << "<Paintings>\n</Paintings>\n";
+  file.close();
+  return fileName;
+}
+
+// ---------------------------------------------------------------------
+QString BenchGenerator::component(const QString &line)
+{
+  Cnt.components++;
+  return "  " + line + "\n";
+}
+
+// ---------------------------------------------------------------------
+QString BenchGenerator::wire(int x1, int y1, int x2, int y2, const QString &label)
+{
+  Cnt.wires++;
+  if (label.isEmpty())
+    return QString("  <%1 %2 %3 %4 \"\" 0 0 0 \"\">\n").arg(x1).arg(y1).arg(x2).arg(y2);
+  return QString("  <%1 %2 %3 %4 \"%5\" %6 %7 0 \"\">\n").arg(x1).arg(y1).arg(x2).
+         arg(y2).arg(label).arg(x1 + 10).arg(y1 - 20);
+}
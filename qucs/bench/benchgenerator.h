@@ -0,0 +1,67 @@
+/***************************************************************************
+                              benchgenerator.h
+                             ------------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef BENCHGENERATOR_H
+#define BENCHGENERATOR_H
+
+#include <QString>
+#include <QStringList>
+
+/*!
+  \file benchgenerator.h
+  \brief Declaration of the BenchGenerator class
+*/
+
+/*!
+ * \brief The BenchGenerator class writes synthetic schematics and simulator
+ *        output files of configurable size for qucs-bench. All files are
+ *        created in one directory, so that subcircuits and datasets are
+ *        found relative to the schematics.
+ */
+class BenchGenerator
+{
+public:
+  //! Number of elements in the last generated schematic
+  struct Counts {
+    int components;
+    int wires;
+    int diagrams;
+    int instances;   //!< components including all subcircuit levels
+  };
+
+  explicit BenchGenerator(const QString &dir);
+
+  QString resistorLadder(int resistors);
+  QString mosArray(int transistors);
+  QString subcircuitHierarchy(int depth, int fanout);
+  QString diagramPage(int diagrams, int graphs, const QString &dataSet,
+                      const QStringList &vars);
+  QString ngspiceRawFile(int variables, int points);
+
+  const Counts& counts() const { return Cnt; }
+
+private:
+  QString writeSchematic(const QString &name, const QString &components,
+                         const QString &wires, const QString &diagrams = "",
+                         const QString &dataSet = "");
+  QString component(const QString &line);
+  QString wire(int x1, int y1, int x2, int y2, const QString &label = "");
+
+  QString Dir;
+  Counts Cnt;
+};
+
+#endif // BENCHGENERATOR_H
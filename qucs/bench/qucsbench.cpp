@@ -0,0 +1,560 @@
+/***************************************************************************
+                                qucsbench.cpp
+                               ---------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+/*!
+ * \file qucsbench.cpp
+ * \brief Benchmark of the schematic core on generated schematics.
+ *
+ * qucs-bench generates resistor ladders, MOSFET arrays, a subcircuit
+ * hierarchy and a page of diagrams (see BenchGenerator) and times
+ * loading, undo snapshots, selection, drawing and netlisting of them as
+ * well as the conversion and loading of a simulator rawfile. The results
+ * are written as JSON, so that they can be compared between releases.
+ * With glibc, the heap taken by a loaded schematic is measured as well,
+ * with all memory savings, without shared symbol geometry and without
+ * interned strings. For the subcircuit hierarchy, the loading of all
+ * subcircuit documents is timed with and without the background reads
+ * of SubcircuitCache::prefetch().
+ *
+ * The program is not built by default: "make qucs-bench".
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <locale.h>
+#ifdef __GLIBC__
+# include <malloc.h>
+#endif
+#include <algorithm>
+#include <vector>
+
+#include <QApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QPlainTextEdit>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include "main.h"
+#include "misc.h"
+#include "module.h"
+#include "schematic.h"
+#include "subcircuitcache.h"
+#include "viewpainter.h"
+#include "components/symbolcache.h"
+#include "diagrams/rectdiagram.h"
+#include "diagrams/graph.h"
+#include "extsimkernels/ngspice.h"
+
+#include "benchgenerator.h"
+
+// the globals of main.cpp, which is not part of this program
+tQucsSettings QucsSettings;
+QucsApp *QucsMain = 0;
+QString lastDir;
+QStringList qucsPathList;
+VersionTriplet QucsVersion;
+
+// The benchmark must not change the settings of the user.
+bool saveApplSettings()
+{
+  return true;
+}
+
+/*!
+ * \brief The BenchKernel class gives access to the dataset conversion of
+ *        the Ngspice kernel for an existing output file.
+ */
+class BenchKernel : public Ngspice
+{
+public:
+  BenchKernel(Schematic *sch, const QString &dir, const QString &output)
+    : Ngspice(sch)
+  {
+    workdir = dir;
+    output_files = QStringList(output);
+    DC_OP_only = false;
+  }
+};
+
+// Collects the run times of the timed operations of one case.
+class Timings
+{
+public:
+  void start() { Timer.start(); }
+  void stop(const QString &op)
+  {
+    double ms = Timer.nsecsElapsed() / 1e6;
+    if (!Runs.contains(op)) Order.append(op);
+    Runs[op].push_back(ms);
+  }
+
+  QJsonObject toJson() const
+  {
+    QJsonObject json;
+    for (const QString &op : Order) {
+      std::vector<double> v = Runs.value(op);
+      std::sort(v.begin(), v.end());
+      QJsonObject o;
+      o["runs"] = int(v.size());
+      o["min_ms"] = v.front();
+      o["median_ms"] = v[v.size() / 2];
+      o["max_ms"] = v.back();
+      json[op] = o;
+    }
+    return json;
+  }
+
+private:
+  QElapsedTimer Timer;
+  QStringList Order;
+  QHash<QString, std::vector<double> > Runs;
+};
+
+// ---------------------------------------------------------------------
+static void initSettings(const QString &workDir)
+{
+  QucsVersion = VersionTriplet(PACKAGE_VERSION);
+
+  QucsSettings.DefaultSimulator = spicecompat::simNgspice;
+  QucsSettings.largeFontSize = 16.0;
+  QucsSettings.maxUndo = 20;
+  QucsSettings.NodeWiring = 0;
+  QucsSettings.font = QApplication::font();
+  QucsSettings.font.setPointSize(12);
+  QucsSettings.appFont = QucsSettings.font;
+  QucsSettings.sysDefaultFont = QucsSettings.font;
+  QucsSettings.BGColor.setRgb(255, 250, 225);
+  QucsSettings.GraphAntiAliasing = false;
+  QucsSettings.TextAntiAliasing = false;
+  QucsSettings.IgnoreFutureVersion = false;
+  QucsSettings.fullTraceName = false;
+  QucsSettings.NProcs = 1;
+  QucsSettings.panelIconsTheme = qucs::autoIcons;
+  QucsSettings.compIconsTheme = qucs::autoIcons;
+  QucsSettings.spiceExtensions << "*.sp" << "*.cir" << "*.spc" << "*.spi";
+
+  // caches and simulator files go to the scratch directory, so every
+  // run starts cold and nothing of the user is touched
+  QDir().mkpath(workDir + "/home");
+  QucsSettings.QucsHomeDir.setPath(workDir + "/home");
+  QucsSettings.QucsWorkDir.setPath(workDir);
+  QucsSettings.S4Qworkdir = workDir + "/spice4qucs";
+
+  QDir QucsDir(QCoreApplication::applicationDirPath());
+  QucsDir.cdUp();
+  QucsSettings.BinDir = QucsDir.absolutePath() + "/bin/";
+  QucsSettings.LibDir = QucsDir.canonicalPath() + "/share/" QUCS_NAME "/library/";
+  QucsSettings.Qucsator = QucsSettings.BinDir + "qucsator";
+  QucsSettings.Qucsconv = QucsSettings.BinDir + "qucsconv";
+  QucsSettings.NgspiceExecutable = "ngspice";
+}
+
+// ---------------------------------------------------------------------
+// Bytes allocated on the heap, or -1 if the C library cannot tell.
+static qint64 heapInUse()
+{
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || (__GLIBC_MINOR__ >= 33))
+  return qint64(mallinfo2().uordblks);
+#elif defined(__GLIBC__)
+  return qint64((unsigned int) mallinfo().uordblks);
+#else
+  return -1;
+#endif
+}
+
+// ---------------------------------------------------------------------
+// Heap taken by the loaded schematic, with or without shared symbols
+// and interned strings.
+static qint64 loadedHeap(const QString &file, bool shareSymbols, bool intern)
+{
+  SymbolCache::setEnabled(shareSymbols);
+  qucs::setInterning(intern);
+  qint64 before = heapInUse();
+  Schematic *sch = new Schematic(0, file);
+  bool ok = sch->loadDocument();
+  qint64 after = heapInUse();
+  delete sch;
+  SymbolCache::setEnabled(true);
+  qucs::setInterning(true);
+  if (!ok || (before < 0)) return -1;
+  return after - before;
+}
+
+// ---------------------------------------------------------------------
+// Loads the documents of all subcircuits below "top" through the cache,
+// in the order of netlisting. Returns the number of documents.
+static int loadHierarchy(Schematic *top)
+{
+  QStringList files;
+  QList<Schematic*> docs;
+  docs.append(top);
+  while (!docs.isEmpty()) {
+    Schematic *doc = docs.takeFirst();
+    for (Component *pc = doc->DocComps.first(); pc != 0; pc = doc->DocComps.next()) {
+      if (pc->Model != "Sub") continue;
+      pc->setSchematic(doc);
+      QString f = pc->getSubcircuitFile();
+      if (f.isEmpty() || files.contains(f)) continue;
+      files.append(f);
+      Schematic *d = SubcircuitCache::document(f);
+      if (d) docs.append(d);
+    }
+  }
+  return files.count();
+}
+
+// ---------------------------------------------------------------------
+// Times the loading of the subcircuit documents with an empty cache.
+// With prefetch, the files are read on worker threads while the GUI
+// thread parses the files read before; the parsing itself is not
+// parallel, schematics are widgets.
+static QJsonObject runHierarchyLoad(Schematic *top, int repeat)
+{
+  QJsonObject json;
+  Timings t;
+  int documents = 0;
+  for (int i = 0; i < repeat; i++) {
+    SubcircuitCache::clear();
+    t.start();
+    documents = loadHierarchy(top);
+    t.stop("loadSubcircuits");
+
+    SubcircuitCache::clear();
+    t.start();
+    SubcircuitCache::prefetch(top);
+    loadHierarchy(top);
+    SubcircuitCache::dropPrefetched();
+    t.stop("loadSubcircuitsPrefetch");
+  }
+  SubcircuitCache::clear();
+  json["documents"] = documents;
+  json["timings"] = t.toJson();
+  return json;
+}
+
+// ---------------------------------------------------------------------
+// Draws the whole schematic like the image export, scaled to at most
+// 2048 pixels.
+static void drawImage(Schematic *sch)
+{
+  int xmin, ymin, xmax, ymax;
+  sch->sizeOfAll(xmin, ymin, xmax, ymax);
+  int w = std::max(xmax - xmin, 1);
+  int h = std::max(ymax - ymin, 1);
+  float scale = std::min(1.0f, 2048.0f / std::max(w, h));
+
+  QImage img(int(w * scale) + 20, int(h * scale) + 20, QImage::Format_RGB888);
+  QPainter p(&img);
+  p.fillRect(0, 0, img.width(), img.height(), Qt::white);
+  ViewPainter vp(&p);
+  vp.init(&p, scale, 0, 0, int(xmin * scale) - 10, int(ymin * scale) - 10, scale, scale);
+  sch->paintSchToViewpainter(&vp, true, true);
+}
+
+// ---------------------------------------------------------------------
+static QJsonObject runCase(const QString &name, const QString &file,
+                           const BenchGenerator::Counts &counts, int repeat,
+                           const QString &workDir)
+{
+  QJsonObject json;
+  json["name"] = name;
+  json["file_bytes"] = double(QFileInfo(file).size());
+  json["components"] = counts.components;
+  json["wires"] = counts.wires;
+  json["diagrams"] = counts.diagrams;
+  json["instances"] = counts.instances;
+
+  Timings t;
+  Schematic *sch = 0;
+  for (int i = 0; i < repeat; i++) {
+    delete sch;
+    sch = new Schematic(0, file);
+    t.start();
+    bool ok = sch->loadDocument();
+    t.stop("loadDocument");
+    if (!ok) {
+      json["error"] = QString("cannot load %1").arg(file);
+      delete sch;
+      return json;
+    }
+  }
+  sch->Nodes = &(sch->DocNodes);
+  sch->Wires = &(sch->DocWires);
+  sch->Diagrams = &(sch->DocDiags);
+  sch->Paintings = &(sch->DocPaints);
+  sch->Components = &(sch->DocComps);
+
+  SymbolCache::Statistics st = SymbolCache::statistics();
+  QJsonObject symbols;
+  symbols["symbols"] = st.symbols;
+  symbols["instances"] = st.instances;
+  symbols["shared_bytes"] = double(st.sharedBytes);
+  symbols["private_bytes"] = double(st.privateBytes);
+  json["symbol_cache"] = symbols;
+
+  // measured, the widget and everything else of the document included
+  qint64 shared = loadedHeap(file, true, true);
+  qint64 unshared = loadedHeap(file, false, true);
+  qint64 uninterned = loadedHeap(file, true, false);
+  if (shared >= 0 && unshared >= 0 && uninterned >= 0) {
+    QJsonObject heap;
+    heap["loaded_bytes"] = double(shared);
+    heap["private_symbols_bytes"] = double(unshared);
+    heap["symbols_saved_bytes"] = double(unshared - shared);
+    heap["private_strings_bytes"] = double(uninterned);
+    heap["strings_saved_bytes"] = double(uninterned - shared);
+    json["heap"] = heap;
+  }
+
+  if (counts.instances > counts.components)  // has subcircuits
+    json["subcircuit_load"] = runHierarchyLoad(sch, repeat);
+
+  int xmin, ymin, xmax, ymax;
+  sch->sizeOfAll(xmin, ymin, xmax, ymax);
+  for (int i = 0; i < repeat; i++) {
+    if (counts.diagrams) {
+      t.start();
+      sch->reloadGraphs();
+      t.stop("reloadGraphs");
+    }
+
+    t.start();
+    sch->setChanged(true, true);   // takes an undo snapshot
+    t.stop("createUndoString");
+
+    t.start();
+    sch->selectElements(xmin, ymin, (xmin + xmax) / 2, ymax, false);
+    t.stop("selectElements");
+    sch->deselectElements(0);
+
+    t.start();
+    drawImage(sch);
+    t.stop("drawImage");
+
+    if (counts.components == 0) continue;
+
+    QucsSettings.DefaultSimulator = spicecompat::simQucsator;
+    QString netlist;
+    QTextStream stream(&netlist);
+    QStringList collect;
+    QPlainTextEdit errText;
+    t.start();
+    int ports = sch->prepareNetlist(stream, collect, &errText);
+    t.stop("prepareNetlist");
+    if (ports < -5) {
+      json["error"] = errText.toPlainText();
+      break;
+    }
+    t.start();
+    sch->createNetlist(stream, ports);
+    t.stop("createNetlist");
+
+    QucsSettings.DefaultSimulator = spicecompat::simNgspice;
+    Ngspice ngspice(sch);
+    t.start();
+    ngspice.SaveNetlist(workDir + "/" + name + ".cir");
+    t.stop("ngspiceSaveNetlist");
+  }
+  delete sch;
+
+  json["timings"] = t.toJson();
+  return json;
+}
+
+// ---------------------------------------------------------------------
+// Converts the rawfile into a dataset and loads its variables into
+// graphs. The variable names of the dataset are returned in "vars".
+static QJsonObject runRawFile(const QString &workDir, const QString &raw,
+                              int variables, int points, int repeat,
+                              QStringList &vars)
+{
+  QJsonObject json;
+  json["name"] = "ngspice_rawfile";
+  json["variables"] = variables;
+  json["points"] = points;
+  json["file_bytes"] = double(QFileInfo(workDir + "/" + raw).size());
+
+  Timings t;
+  QString dataSet = workDir + "/bench_diagrams.dat";
+  Schematic sch(0, "");
+  for (int i = 0; i < repeat; i++) {
+    BenchKernel kernel(&sch, workDir, raw);
+    t.start();
+    kernel.convertToQucsData(dataSet);
+    t.stop("convertToQucsData");
+  }
+
+  QFile file(dataSet);
+  if (!file.open(QIODevice::ReadOnly)) {
+    json["error"] = QString("no dataset created");
+    return json;
+  }
+  QRegularExpression dep("<dep (\\S+) ");
+  QRegularExpressionMatchIterator it = dep.globalMatch(QString::fromUtf8(file.readAll()));
+  file.close();
+  vars.clear();
+  while (it.hasNext())
+    vars.append(it.next().captured(1));
+
+  RectDiagram diagram;
+  for (int i = 0; i < repeat; i++) {
+    t.start();
+    for (const QString &var : vars) {
+      Graph g(&diagram, var);
+      g.loadDatFile(dataSet);
+    }
+    t.stop("loadDatFile");
+  }
+
+  json["timings"] = t.toJson();
+  return json;
+}
+
+// ---------------------------------------------------------------------
+static void usage(const char *prog)
+{
+  fprintf(stdout,
+  "Usage: %s [options]\n\n"
+  "  -h, --help          display this help and exit\n"
+  "  --size N            resistors and transistors per schematic (default 10000)\n"
+  "  --depth N           subcircuit hierarchy depth (default 6)\n"
+  "  --fanout N          subcircuits instantiated per level (default 3)\n"
+  "  --diagrams N        diagrams on the diagram page (default 64)\n"
+  "  --variables N       rawfile variables including time (default 33)\n"
+  "  --points N          rawfile time points (default 20000)\n"
+  "  --repeat N          runs of every timed operation (default 3)\n"
+  "  --workdir DIR       keep the generated files in DIR\n"
+  "  -o FILE             write the JSON results to FILE instead of stdout\n"
+  , prog);
+}
+
+int main(int argc, char *argv[])
+{
+  // run without display
+  if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  QApplication a(argc, argv);
+  setlocale(LC_NUMERIC, "C");
+
+  int size = 10000, depth = 6, fanout = 3, diagrams = 64;
+  int variables = 33, points = 20000, repeat = 3;
+  QString workDir, output;
+
+  for (int i = 1; i < argc; ++i) {
+    QString arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "-h" || arg == "--help") {
+      usage(argv[0]);
+      return 0;
+    }
+    else if (arg == "--size" && hasValue) size = atoi(argv[++i]);
+    else if (arg == "--depth" && hasValue) depth = atoi(argv[++i]);
+    else if (arg == "--fanout" && hasValue) fanout = atoi(argv[++i]);
+    else if (arg == "--diagrams" && hasValue) diagrams = atoi(argv[++i]);
+    else if (arg == "--variables" && hasValue) variables = atoi(argv[++i]);
+    else if (arg == "--points" && hasValue) points = atoi(argv[++i]);
+    else if (arg == "--repeat" && hasValue) repeat = atoi(argv[++i]);
+    else if (arg == "--workdir" && hasValue) workDir = argv[++i];
+    else if (arg == "-o" && hasValue) output = argv[++i];
+    else {
+      fprintf(stderr, "Error: Unknown option: %s\n", argv[i]);
+      return -1;
+    }
+  }
+  if (size < 1 || depth < 1 || fanout < 1 || diagrams < 0 ||
+      variables < 2 || points < 1 || repeat < 1) {
+    fprintf(stderr, "Error: Invalid benchmark size.\n");
+    return -1;
+  }
+
+  QTemporaryDir tmpDir;
+  if (workDir.isEmpty()) {
+    if (!tmpDir.isValid()) {
+      fprintf(stderr, "Error: Cannot create temporary directory.\n");
+      return 1;
+    }
+    workDir = tmpDir.path();
+  }
+  workDir = QDir(workDir).absolutePath();
+
+  initSettings(workDir);
+  Module::registerModules();
+
+  BenchGenerator gen(workDir);
+  QJsonArray cases;
+  QString file;
+
+  file = gen.resistorLadder(size);
+  cases.append(runCase("resistor_ladder", file, gen.counts(), repeat, workDir));
+  file = gen.mosArray(size);
+  cases.append(runCase("mos_array", file, gen.counts(), repeat, workDir));
+  file = gen.subcircuitHierarchy(depth, fanout);
+  cases.append(runCase("subcircuit_hierarchy", file, gen.counts(), repeat, workDir));
+
+  QStringList vars;
+  QString raw = gen.ngspiceRawFile(variables, points);
+  cases.append(runRawFile(workDir, raw, variables, points, repeat, vars));
+  file = gen.diagramPage(diagrams, 4, "bench_diagrams.dat", vars);
+  cases.append(runCase("diagram_page", file, gen.counts(), repeat, workDir));
+
+  QJsonObject params;
+  params["size"] = size;
+  params["depth"] = depth;
+  params["fanout"] = fanout;
+  params["diagrams"] = diagrams;
+  params["variables"] = variables;
+  params["points"] = points;
+  params["repeat"] = repeat;
+
+  QJsonObject json;
+  json["program"] = "qucs-bench";
+  json["version"] = PACKAGE_VERSION;
+#ifdef GIT
+  json["git"] = GIT;
+#endif
+  json["qt"] = qVersion();
+  json["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+  json["parameters"] = params;
+  json["cases"] = cases;
+
+  QByteArray text = QJsonDocument(json).toJson();
+  if (output.isEmpty()) {
+    fwrite(text.constData(), 1, text.size(), stdout);
+  } else {
+    QFile out(output);
+    if (!out.open(QIODevice::WriteOnly)) {
+      fprintf(stderr, "Error: Cannot write %s\n", output.toLocal8Bit().constData());
+      return 1;
+    }
+    out.write(text);
+    out.close();
+  }
+  return 0;
+}
@@ -0,0 +1,140 @@
+/***************************************************************************
+                            componenticons.cpp
+                           --------------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "componenticons.h"
+#include "module.h"
+#include "main.h"
+#include "misc.h"
+
+#include <QFileInfo>
+#include <QPixmapCache>
+
+/*!
+  \file componenticons.cpp
+  \brief Implementation of the ComponentIcons class
+*/
+
+QMutex ComponentIcons::Mutex;
+QHash<QString, QImage> ComponentIcons::Images;
+QHash<QString, QString> ComponentIcons::Paths;
+quint64 ComponentIcons::Generation = 0;
+
+/*!
+ * \brief ComponentIcons::snapshot Collect the icon files of all registered
+ *        modules which are not known yet. Must be called on the GUI
+ *        thread, which owns the module registry.
+ */
+ComponentIcons::Snapshot ComponentIcons::snapshot()
+{
+    Snapshot snap;
+    Mutex.lock();
+    snap.generation = Generation;
+    Mutex.unlock();
+
+    QStringList cats = Category::getCategories();
+    for (const QString &cat : cats) {
+        QList<Module *> Comps = Category::getModules(cat);
+        for (const Module *m : Comps) {
+            QString k = key(m);
+            Mutex.lock();
+            bool known = Paths.contains(k);
+            Mutex.unlock();
+            if (!known) snap.icons.append(qMakePair(k, iconPath(m)));
+        }
+    }
+    return snap;
+}
+
+/*!
+ * \brief ComponentIcons::warm Decode the icons of a snapshot. May be
+ *        called on a worker thread. Results are dropped if clear() was
+ *        called since the snapshot was taken.
+ */
+void ComponentIcons::warm(const Snapshot &snap)
+{
+    for (const auto &icon : snap.icons) {
+        QImage image;
+        if (!icon.second.isEmpty()) image.load(icon.second);
+        QMutexLocker locker(&Mutex);
+        if (Generation != snap.generation) return;
+        Paths.insert(icon.first, icon.second);
+        if (!image.isNull()) Images.insert(icon.first, image);
+    }
+}
+
+/*!
+ * \brief ComponentIcons::pixmap Return the palette icon of a module.
+ *        Must be called on the GUI thread.
+ * \return Icon or a null pixmap if the icon file does not exist
+ */
+QPixmap ComponentIcons::pixmap(const Module *m)
+{
+    QString k = key(m);
+    QPixmap pm;
+    if (QPixmapCache::find(k, &pm)) return pm;
+
+    QImage image;
+    QString path;
+    bool known;
+    Mutex.lock();
+    known = Paths.contains(k);
+    path = Paths.value(k);
+    image = Images.value(k);
+    Mutex.unlock();
+
+    if (!known) {
+        path = iconPath(m);
+        QMutexLocker locker(&Mutex);
+        Paths.insert(k, path);
+    }
+    if (path.isEmpty()) return QPixmap();
+
+    if (image.isNull()) pm = QPixmap(path);
+    else pm = QPixmap::fromImage(image);
+    QPixmapCache::insert(k, pm);
+    return pm;
+}
+
+/*!
+ * \brief ComponentIcons::clear Forget all icons, e.g. after the Verilog-A
+ *        modules or the icon theme have changed.
+ */
+void ComponentIcons::clear()
+{
+    QMutexLocker locker(&Mutex);
+    Images.clear();
+    Paths.clear();
+    Generation++;
+    QPixmapCache::clear();
+}
+
+// ---------------------------------------------------------------------
+QString ComponentIcons::key(const Module *m)
+{
+    return QString(m->infoVA ? "qucs-va:" : "qucs-comp:") + m->bitmap;
+}
+
+// ---------------------------------------------------------------------
+// Icon file of a module, empty if a Verilog-A module has no icon.
+QString ComponentIcons::iconPath(const Module *m)
+{
+    if (m->infoVA) {
+        // bitmap defined in the JSON symbol file
+        QString path = QucsSettings.QucsWorkDir.filePath(m->bitmap + ".png");
+        return QFileInfo::exists(path) ? path : QString();
+    }
+    return misc::getIconPath(m->bitmap + ".png", qucs::compIcons);
+}
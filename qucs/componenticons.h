@@ -0,0 +1,68 @@
+/***************************************************************************
+                             componenticons.h
+                            ------------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef COMPONENTICONS_H
+#define COMPONENTICONS_H
+
+#include <QString>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QImage>
+#include <QPixmap>
+#include <QMutex>
+
+class Module;
+
+/*!
+  \file componenticons.h
+  \brief Declaration of the ComponentIcons class
+*/
+
+/*!
+ * \brief The ComponentIcons class caches the palette icons of the
+ *        registered modules. At startup, the GUI thread takes a snapshot()
+ *        of the icon files and warm() decodes them on a worker thread, so
+ *        the worker never touches the module registry. pixmap() turns the
+ *        icons into pixmaps on first use and keeps those in QPixmapCache,
+ *        so switching palette pages or searching does not read or decode
+ *        image files again.
+ */
+class ComponentIcons
+{
+public:
+    //! Icon files of the registered modules, taken on the GUI thread
+    struct Snapshot {
+        QList<QPair<QString, QString> > icons;  //!< key and icon file
+        quint64 generation;                     //!< see clear()
+    };
+
+    static Snapshot snapshot();
+    static void warm(const Snapshot &snap);
+    static QPixmap pixmap(const Module *m);
+    static void clear();
+
+private:
+    static QString key(const Module *m);
+    static QString iconPath(const Module *m);
+
+    static QMutex Mutex;
+    static QHash<QString, QImage> Images;  //!< decoded icons
+    static QHash<QString, QString> Paths;  //!< key -> icon file, empty if missing
+    static quint64 Generation;             //!< counts clear() calls
+};
+
+#endif // COMPONENTICONS_H
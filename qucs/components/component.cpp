@@ -25,6 +25,7 @@
 #include "viewpainter.h"
 #include "module.h"
 #include "misc.h"
+#include "linetokenizer.h"
 
 #include <QPen>
 #include <QString>
@@ -47,6 +48,8 @@ Component::Component()
   Type = isAnalogComponent;
 
   SpiceModel = "";
+  cachedSpiceFlags = -1;  // no SPICE netlist fragment cached
+  cachedSpiceFileTime = 0;
   isSimulation = false;
   isProbe = false;
   isEquation = false;
@@ -66,6 +69,11 @@ Component::Component()
   containingSchematic = NULL;
 }
 
+Component::~Component()
+{
+  clearSymbol();
+}
+
 // -------------------------------------------------------
 Component* Component::newOne()
 {
@@ -402,6 +410,7 @@ void Component::rotate()
        && (Model != "SpLib")) // skip port count
     if(Ports.count() < 1) return;  // do not rotate components without ports
   int tmp, dx, dy;
+  detachSymbol();
 
   // rotate all lines
   for (qucs::Line *p1 : Lines) {
@@ -502,6 +511,7 @@ void Component::mirrorX()
   if ((Model != "Sub") && (Model !="VHDL") && (Model != "Verilog")
        && (Model != "SpLib")) // skip port count
     if(Ports.count() < 1) return;  // do not rotate components without ports
+  detachSymbol();
 
   // mirror all lines
   for (qucs::Line *p1 : Lines) {
@@ -565,6 +575,7 @@ void Component::mirrorY()
   if ((Model != "Sub") && (Model !="VHDL") && (Model != "Verilog")
        && (Model != "SpLib")) // skip port count
     if(Ports.count() < 1) return;  // do not rotate components without ports
+  detachSymbol();
 
   // mirror all lines
   for (qucs::Line *p1 : Lines) {
@@ -701,7 +712,84 @@ QString Component::getNetlist()
   return s;
 }
 
+/*!
+ * \brief Component::spiceNetlistValid Check if the cached SPICE netlist
+ *        fragment is still valid. The strings the fragment was built from
+ *        are kept as shared copies: a string that is assigned a new value
+ *        or modified in place gets new data, so comparing the data
+ *        pointers finds every change without building a key. The node
+ *        names are assigned anew for each netlist and compared by value.
+ *        If the component refers to an external file its modification
+ *        time is compared too.
+ * \param isXyce Xyce or Ngspice dialect.
+ */
+bool Component::spiceNetlistValid(bool isXyce)
+{
+    int flags = (QucsSettings.DefaultSimulator << 4) | (isActive << 1) | (isXyce ? 1 : 0);
+    if (flags != cachedSpiceFlags) return false;
+    if (cachedSpiceInputs.count() != Props.count() + 3) return false;
+    if ((Model.constData() != cachedSpiceInputs.at(0).constData()) ||
+        (Name.constData() != cachedSpiceInputs.at(1).constData()) ||
+        (SpiceModel.constData() != cachedSpiceInputs.at(2).constData())) return false;
+    int i = 3;
+    for (Property *pp : Props) {
+        if (pp->Value.constData() != cachedSpiceInputs.at(i++).constData()) return false;
+    }
+
+    if (cachedSpiceNodes.count() != Ports.count()) return false;
+    i = 0;
+    for (Port *pp : Ports) {
+        const QString &node = cachedSpiceNodes.at(i++);
+        if (pp->Connection == nullptr) {
+            if (!node.isNull()) return false;
+        } else if (pp->Connection->Name != node) return false;
+    }
+
+    if (cachedSpiceFile.isEmpty()) return true;
+    return QFileInfo(cachedSpiceFile).lastModified().toMSecsSinceEpoch() == cachedSpiceFileTime;
+}
+
+/*!
+ * \brief Component::storeSpiceNetlist Keep a netlist fragment together
+ *        with the inputs it was built from, see spiceNetlistValid().
+ */
+void Component::storeSpiceNetlist(const QString &netlist, bool isXyce)
+{
+    cachedSpiceNetlist = netlist;
+    cachedSpiceFlags = (QucsSettings.DefaultSimulator << 4) | (isActive << 1) | (isXyce ? 1 : 0);
+    cachedSpiceInputs.clear();
+    cachedSpiceInputs.reserve(Props.count() + 3);
+    cachedSpiceInputs << Model << Name << SpiceModel;
+    for (Property *pp : Props) cachedSpiceInputs.append(pp->Value);
+    cachedSpiceNodes.clear();
+    for (Port *pp : Ports)
+        cachedSpiceNodes.append(pp->Connection ? pp->Connection->Name : QString());
+    cachedSpiceFile = getSubcircuitFile();
+    cachedSpiceFileTime = 0;
+    if (!cachedSpiceFile.isEmpty())
+        cachedSpiceFileTime = QFileInfo(cachedSpiceFile).lastModified().toMSecsSinceEpoch();
+}
+
+/*!
+ * \brief Component::getSpiceNetlist Return the SPICE netlist fragment of
+ *        this component. The fragment is re-emitted only if properties or
+ *        connectivity have changed since the previous call; otherwise the
+ *        cached text is returned. Simulations and equations are never
+ *        cached, because their output depends on other components.
+ * \param isXyce Xyce or Ngspice dialect.
+ */
 QString Component::getSpiceNetlist(bool isXyce)
+{
+    if (isSimulation || isEquation) {
+        return getSpiceNetlistUncached(isXyce);
+    }
+    if (!spiceNetlistValid(isXyce)) {
+        storeSpiceNetlist(getSpiceNetlistUncached(isXyce), isXyce);
+    }
+    return cachedSpiceNetlist;
+}
+
+QString Component::getSpiceNetlistUncached(bool isXyce)
 {
     QString s;
     switch(isActive) {
@@ -891,18 +979,17 @@ bool Component::load(const QString& _s)
 {
   bool ok;
   int  ttx, tty, tmp;
-  QString s = _s;
 
-  if(s.at(0) != '<') return false;
-  if(s.at(s.length()-1) != '>') return false;
-  s = s.mid(1, s.length()-2);   // cut off start and end character
+  if(_s.at(0) != '<') return false;
+  if(_s.at(_s.length()-1) != '>') return false;
+  // cut off start and end character
+  LineTokenizer s(_s, 1, _s.length()-2);
 
   QString n;
-  Name = s.section(' ',1,1);    // Name
+  Name = s.field(1);    // Name
   if(Name == "*") Name = "";
 
-  n  = s.section(' ',2,2);      // isActive
-  tmp = n.toInt(&ok);
+  tmp = s.toInt(2, &ok);      // isActive
   if(!ok) return false;
   isActive = tmp & 3;
 
@@ -911,30 +998,24 @@ bool Component::load(const QString& _s)
   else
     showName = true;
 
-  n  = s.section(' ',3,3);    // cx
-  cx = n.toInt(&ok);
+  cx = s.toInt(3, &ok);    // cx
   if(!ok) return false;
 
-  n  = s.section(' ',4,4);    // cy
-  cy = n.toInt(&ok);
+  cy = s.toInt(4, &ok);    // cy
   if(!ok) return false;
 
-  n  = s.section(' ',5,5);    // tx
-  ttx = n.toInt(&ok);
+  ttx = s.toInt(5, &ok);    // tx
   if(!ok) return false;
 
-  n  = s.section(' ',6,6);    // ty
-  tty = n.toInt(&ok);
+  tty = s.toInt(6, &ok);    // ty
   if(!ok) return false;
 
   if(Model.at(0) != '.') {  // is simulation component (dc, ac, ...) ?
 
-    n  = s.section(' ',7,7);    // mirroredX
-    if(n.toInt(&ok) == 1) mirrorX();
+    if(s.toInt(7, &ok) == 1) mirrorX();    // mirroredX
     if(!ok) return false;
 
-    n  = s.section(' ',8,8);    // rotated
-    tmp = n.toInt(&ok);
+    tmp = s.toInt(8, &ok);    // rotated
     if(!ok) return false;
     if(rotated > tmp)  // necessary because of historical flaw in ...
       tmp += 4;        // ... components like "volt_dc"
@@ -943,8 +1024,10 @@ bool Component::load(const QString& _s)
   }
 
   tx = ttx; ty = tty; // restore text position (was changed by rotate/mirror)
+  shareSymbol();
+  internStrings();
 
-  unsigned int z=0, counts = s.count('"');
+  unsigned int z=0, counts = s.quotes();
   if(Model == "Sub")
     tmp = 2;   // first property (File) already exists
   else if(Model == "Lib")
@@ -966,7 +1049,7 @@ bool Component::load(const QString& _s)
   Property *p1;
   for(p1 = Props.first(); p1 != 0; p1 = Props.next()) {
     z++;
-    n = s.section('"',z,z);    // property value
+    n = s.section(z);    // property value
     n.replace("\\n","\n");
     n.replace("''","\"");
     z++;
@@ -1041,9 +1124,10 @@ bool Component::load(const QString& _s)
         Props.getLast()->Value = n;
         return true;
       }
-    p1->Value = n;
+    if(p1->Value != n)  // keeps the interned default value if unchanged
+      p1->Value = n;
 
-    n  = s.section('"',z,z);    // display
+    n  = s.sectionView(z);    // display
     p1->display = (n.at(1) == '1');
   }
 
@@ -1377,11 +1461,98 @@ void Component::copyComponent(Component *pc)
 
   Props  = pc->Props;
   Ports  = pc->Ports;
+
+  // take over the symbol, "pc" is deleted afterwards
+  clearSymbol();
   Lines  = pc->Lines;
   Arcs   = pc->Arcs;
   Rects  = pc->Rects;
   Ellips = pc->Ellips;
   Texts  = pc->Texts;
+  SharedSymbol = pc->SharedSymbol;
+  pc->Lines.clear();
+  pc->Arcs.clear();
+  pc->Rects.clear();
+  pc->Ellips.clear();
+  pc->Texts.clear();
+  pc->SharedSymbol.clear();
+}
+
+// ---------------------------------------------------------------------
+// Replaces the painting primitives by the ones of the shared symbol with
+// the same geometry, so that equal components keep only one copy.
+void Component::shareSymbol()
+{
+  if(SharedSymbol)  return;   // already shared
+  if(!SymbolCache::enabled())  return;
+  if(Lines.isEmpty() && Arcs.isEmpty() && Rects.isEmpty() &&
+     Ellips.isEmpty() && Texts.isEmpty())  return;
+
+  SymbolGeometryPtr g = SymbolCache::acquire(Lines, Arcs, Rects, Ellips, Texts);
+  clearSymbol();
+  // the shared geometry is immutable, the primitives must not be
+  // modified before detachSymbol() was called
+  SymbolGeometry *geo = const_cast<SymbolGeometry*>(g.data());
+  for (qucs::Line &l : geo->Lines)  Lines.append(&l);
+  for (qucs::Arc &a : geo->Arcs)  Arcs.append(&a);
+  for (qucs::Area &a : geo->Rects)  Rects.append(&a);
+  for (qucs::Area &a : geo->Ellips)  Ellips.append(&a);
+  for (Text &t : geo->Texts)  Texts.append(&t);
+  SharedSymbol = g;
+}
+
+// ---------------------------------------------------------------------
+// Lets the model strings and the property names, descriptions and
+// values point into the string pool, so that they are held only once
+// for all components of the same model. Done on load and placement
+// only, the constructors do not pay for the pool.
+void Component::internStrings()
+{
+  Model = qucs::intern(Model);
+  SpiceModel = qucs::intern(SpiceModel);
+  Description = qucs::intern(Description);
+  for(Property *p = Props.first(); p != 0; p = Props.next()) {
+    p->Name = qucs::intern(p->Name);
+    p->Value = qucs::intern(p->Value);
+    p->Description = qucs::intern(p->Description);
+  }
+}
+
+// ---------------------------------------------------------------------
+// Gives the component private copies of its painting primitives again,
+// necessary before they are changed.
+void Component::detachSymbol()
+{
+  if(!SharedSymbol)  return;
+  for (qucs::Line *&p : Lines)  p = new qucs::Line(*p);
+  for (qucs::Arc *&p : Arcs)  p = new qucs::Arc(*p);
+  for (qucs::Area *&p : Rects)  p = new qucs::Area(*p);
+  for (qucs::Area *&p : Ellips)  p = new qucs::Area(*p);
+  for (Text *&p : Texts)  p = new Text(*p);
+  SymbolCache::release(SharedSymbol);
+  SharedSymbol.clear();
+}
+
+// ---------------------------------------------------------------------
+// Removes all painting primitives (not the ports).
+void Component::clearSymbol()
+{
+  if(SharedSymbol) {
+    SymbolCache::release(SharedSymbol);
+    SharedSymbol.clear();
+  }
+  else {
+    qDeleteAll(Lines);
+    qDeleteAll(Arcs);
+    qDeleteAll(Rects);
+    qDeleteAll(Ellips);
+    qDeleteAll(Texts);
+  }
+  Lines.clear();
+  Arcs.clear();
+  Rects.clear();
+  Ellips.clear();
+  Texts.clear();
 }
 
 
@@ -1397,12 +1568,8 @@ void MultiViewComponent::recreate(Schematic *Doc)
     Doc->deleteComp(this);
   }
 
-  Ellips.clear();
-  Texts.clear();
+  clearSymbol();
   Ports.clear();
-  Lines.clear();
-  Rects.clear();
-  Arcs.clear();
   createSymbol();
 
   bool mmir = mirroredX;
@@ -1418,6 +1585,7 @@ void MultiViewComponent::recreate(Schematic *Doc)
 
   rotated = rrot;   // restore properties (were changed by rotate/mirror)
   mirroredX = mmir;
+  shareSymbol();
 
   if(Doc) {
     Doc->insertRawComponent(this);
@@ -1713,8 +1881,10 @@ Component* getComponentFromName(QString& Line, Schematic* p)
     return 0;
   }
 
-  QString cstr = Line.section (' ',0,0); // component type
-  cstr.remove (0,1);    // remove leading "<"
+  // component type without the leading "<"; only the first field is
+  // needed, so don't split the whole line as section() would do
+  int end = Line.indexOf(' ');
+  QString cstr = Line.mid(1, end < 0 ? -1 : end - 1);
   if (cstr == "Lib") c = new LibComp ();
   else if (cstr == "Eqn") c = new Equation ();
   else if (cstr == "SPICE") c = new SpiceFile();
@@ -23,6 +23,7 @@
 #include "qt3_compat/qt_compat.h"
 
 #include "element.h"
+#include "symbolcache.h"
 
 class Schematic;
 class ViewPainter;
@@ -33,7 +34,7 @@ class QPen;
 class Component : public Element {
 public:
   Component();
-  virtual ~Component() {};
+  virtual ~Component();
 
   virtual Component* newOne();
   virtual void recreate(Schematic*) {};
@@ -65,6 +66,9 @@ public:
   void    rotate();
   void    mirrorX();  // mirror about X axis
   void    mirrorY();  // mirror about Y axis
+  void    shareSymbol();
+  void    detachSymbol();
+  void    internStrings();
   QString save();
   bool    load(const QString&);
 
@@ -113,8 +117,26 @@ protected:
   bool getBrush(const QString&, QBrush&, int);
 
   void copyComponent(Component*);
+  void clearSymbol();
   Property * getProperty(const QString&);
   Schematic* containingSchematic;
+
+private:
+  // shared geometry the painting primitives point into, null while
+  // the component owns its primitives
+  SymbolGeometryPtr SharedSymbol;
+
+  bool spiceNetlistValid(bool isXyce);
+  void storeSpiceNetlist(const QString &netlist, bool isXyce);
+  QString getSpiceNetlistUncached(bool isXyce);
+
+  // last emitted SPICE netlist fragment and the inputs it was built from
+  QString cachedSpiceNetlist;
+  QVector<QString> cachedSpiceInputs;  // model, name, SPICE model, property values
+  QStringList cachedSpiceNodes;
+  QString cachedSpiceFile;
+  qint64 cachedSpiceFileTime;
+  int cachedSpiceFlags;                // simulator, state and dialect
 };
 
 
@@ -74,7 +74,7 @@ ComponentDialog::ComponentDialog(Component *c, Schematic *d)
      (Comp->Model != ".FOURIER") && (Comp->Model != ".FFT") &&
      (Comp->Model != ".PZ") && (Comp->Model != ".SENS") &&
      (Comp->Model != ".SENS_AC") && (Comp->Model != ".SENS_XYCE") &&
-     (Comp->Model != ".SENS_TR_XYCE")) {
+     (Comp->Model != ".SENS_TR_XYCE") && (Comp->Model != ".MC")) {
     QTabWidget *t = new QTabWidget(this);
     all->addWidget(t);
 
@@ -20,6 +20,7 @@
 #include "main.h"
 #include "schematic.h"
 #include "misc.h"
+#include "librarycache.h"
 #include "extsimkernels/qucs2spice.h"
 #include "extsimkernels/spicecompat.h"
 
@@ -27,7 +28,6 @@
 
 #include <QTextStream>
 #include <QDir>
-#include <QRegularExpression>
 #include <QDebug>
 
 LibComp::LibComp()
@@ -85,112 +85,15 @@ void LibComp::createSymbol()
 
 // ---------------------------------------------------------------------
 // Loads the section with name "Name" from library file into "Section".
+// The library is parsed only once and shared by all instances, see
+// LibraryCache.
 int LibComp::loadSection(const QString& Name, QString& Section,
              QStringList *Includes, QStringList *Attach)
 {
   QDir Directory(QucsSettings.LibDir);
-  QFile file(Directory.absoluteFilePath(Props.first()->Value + ".lib"));
-  if(!file.open(QIODevice::ReadOnly))
-    return -1;
-
-  QString libDefaultSymbol;
-
-  QTextStream ReadWhole(&file);
-  Section = ReadWhole.readAll();
-  file.close();
-
-
-  if(Section.left(14) != "<Qucs Library ")  // wrong file type ?
-    return -2;
-
-  int Start, End = Section.indexOf(' ', 14);
-  if(End < 15) return -3;
-  QString Line = Section.mid(14, End-14); // extract version string
-  VersionTriplet LibVersion = VersionTriplet(Line);
-  if (LibVersion > QucsVersion) {// wrong version number ?
-      if (!QucsSettings.IgnoreFutureVersion) {
-          return -3;
-      }
-  }
-
-  if(Name == "Symbol") {
-    Start = Section.indexOf("\n<", 14); // library has default symbol
-    if(Start > 0)
-      if(Section.mid(Start+2, 14) == "DefaultSymbol>") {
-        Start += 16;
-        End = Section.indexOf("\n</DefaultSymbol>", Start);
-        if(End < 0)  return -9;
-        libDefaultSymbol = Section.mid(Start, End-Start);
-      }
-  }
-
-  // search component
-  Line = "\n<Component " + Props.next()->Value + ">";
-  Start = Section.indexOf(Line);
-  if(Start < 0)  return -4;  // component not found
-  Start = Section.indexOf('\n', Start);
-  if(Start < 0)  return -5;  // file corrupt
-  Start++;
-  End = Section.indexOf("\n</Component>", Start);
-  if(End < 0)  return -6;  // file corrupt
-  Section = Section.mid(Start, End-Start+1);
-  
-  // search model includes
-  if(Includes) {
-    int StartI, EndI;
-    StartI = Section.indexOf("<"+Name+"Includes");
-    if(StartI >= 0) {  // includes found
-      StartI = Section.indexOf('"', StartI);
-      if(StartI < 0)  return -10;  // file corrupt
-      EndI = Section.indexOf('>', StartI);
-      if(EndI < 0)  return -11;  // file corrupt
-      StartI++; EndI--;
-      QString inc = Section.mid(StartI, EndI-StartI);
-      QStringList f = inc.split(QRegularExpression("\"\\s+\""));
-      for(QStringList::Iterator it = f.begin(); it != f.end(); ++it ) {
-	Includes->append(*it);
-      }
-    }
-  }
-
-  // search attached files
-  if(Attach) {
-    int StartI, EndI;
-    StartI = Section.indexOf("<"+Name+"Attach");
-    if(StartI >= 0) {  // includes found
-      StartI = Section.indexOf('"', StartI);
-      if(StartI < 0)  return -10;  // file corrupt
-      EndI = Section.indexOf('>', StartI);
-      if(EndI < 0)  return -11;  // file corrupt
-      StartI++; EndI--;
-      QString inc = Section.mid(StartI, EndI-StartI);
-      QStringList f = inc.split(QRegularExpression("\"\\s+\""));
-      for(QStringList::Iterator it = f.begin(); it != f.end(); ++it ) {
-    Attach->append(*it);
-      }
-    }
-  }
-
-  // search model
-  Start = Section.indexOf("<"+Name+">");
-  if(Start < 0) {
-    if((Name == "Symbol") && (!libDefaultSymbol.isEmpty())) {
-      // component does not define its own symbol but the library defines a default symbol
-      Section = libDefaultSymbol;
-      return 0;
-    } else {
-      return -7;  // symbol not found
-    }
-  }
-  Start = Section.indexOf('\n', Start);
-  if(Start < 0)  return -8;  // file corrupt
-  while(Section.at(++Start) == ' ') ;
-  End = Section.indexOf("</"+Name+">", Start);
-  if(End < 0)  return -9;  // file corrupt
-
-  // snip actual model
-  Section = Section.mid(Start, End-Start);
-  return 0;
+  QString FileName = Directory.absoluteFilePath(Props.first()->Value + ".lib");
+  return LibraryCache::section(FileName, Props.at(1)->Value, Name, Section,
+                               Includes, Attach);
 }
 
 // ---------------------------------------------------------------------
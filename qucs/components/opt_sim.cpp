@@ -38,6 +38,7 @@ Optimize_Sim::Optimize_Sim()
   ty = y2+1;
   Model = ".Opt";
   Name  = "Opt";
+  SpiceModel = ".Opt";
 
   Props.append(new Property("Sim", "", false, ""));
   Props.append(new Property("DE", "3|50|2|20|0.85|1|3|1e-6|10|100", false, ""));
@@ -61,6 +62,12 @@ Element* Optimize_Sim::info(QString& Name, char* &BitmapFile, bool getNewOne)
   return 0;
 }
 
+// -------------------------------------------------------
+QString Optimize_Sim::spice_netlist(bool)
+{
+  return QString(""); // SPICE optimization is run by the SpiceOptimizer class
+}
+
 // -------------------------------------------------------
 QString Optimize_Sim::netlist()
 {
@@ -298,3 +305,22 @@ bool Optimize_Sim::loadASCOout()
   }
   return changed;
 }
+
+// -----------------------------------------------------------
+// Sets the initial values of the optimization variables, e.g. to the
+// results of an optimization. Returns true if a value is changed.
+bool Optimize_Sim::setVarValues(const QHash<QString, QString> &values)
+{
+  bool changed = false;
+  Property* pp;
+  for(pp = Props.at(2); pp != 0; pp = Props.next()) {
+    if(pp->Name != "Var") continue;
+    QStringList val = pp->Value.split('|');
+    if(val.count() < 3 || !values.contains(val[0])) continue;
+    if(val[2] == values.value(val[0])) continue;
+    val[2] = values.value(val[0]);
+    pp->Value = val.join("|");
+    changed = true;
+  }
+  return changed;
+}
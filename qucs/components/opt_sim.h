@@ -20,6 +20,8 @@
 
 #include "component.h"
 
+#include <QHash>
+
 
 class Optimize_Sim : public Component  {
 public:
@@ -30,9 +32,11 @@ public:
   bool createASCOFiles();
   bool createASCOnetlist();
   bool loadASCOout();
+  bool setVarValues(const QHash<QString, QString> &values);
 
 protected:
   QString netlist();
+  QString spice_netlist(bool isXyce);
 };
 
 #endif
@@ -41,6 +41,8 @@ Param_Sweep::Param_Sweep()
   Name  = "SW";
   SpiceModel = "*";
   isSimulation = true;
+  ShardIndex = 0;
+  ShardCount = 1;
 
   // The index of the first 6 properties must not changed. Used in recreate().
   Props.append(new Property("Sim", "", true,
@@ -98,22 +100,15 @@ void Param_Sweep::recreate(Schematic*)
   }
 }
 
-QString Param_Sweep::getNgspiceBeforeSim(QString sim, int lvl)
+/*!
+ * \brief Param_Sweep::getSweepValues Values of the swept parameter in the
+ *        order Ngspice steps through them.
+ */
+QStringList Param_Sweep::getSweepValues()
 {
-    if (isActive != COMP_IS_ACTIVE) return QString("");
-
-    QString s,unit;
-    QStringList parameter_list = getProperty("Param")->Value.split( this->param_split_str );
-    QStringList::const_iterator constListIterator;
+    QString unit;
+    QStringList values;
     QString type = getProperty("Type")->Value;
-    QString step_var = parameter_list.begin()->toLower();// use first element name as variable name
-    step_var.remove(QRegularExpression("[\\.\\[\\]@:]"));
-	
-    s = QString("let number_%1 = 0\n").arg(step_var);
-    if (lvl==0) s += QString("echo \"STEP %1.%2\" > spice4qucs.%3.cir.res\n").arg(sim).arg(step_var).arg(sim);
-    else s += QString("echo \"STEP %1.%2\" > spice4qucs.%3.cir.res%4\n").arg(sim).arg(step_var).arg(sim).arg(lvl);
-
-    s += QString("foreach  %1_act ").arg(step_var);
 
     if((type == "list") || (type == "const")) {
         QStringList List;
@@ -121,7 +116,7 @@ QString Param_Sweep::getNgspiceBeforeSim(QString sim, int lvl)
 
         for(int i = 0; i < List.length(); i++) {
             List[i].remove(QRegularExpression("[A-Z a-z [\\] s/' '//g]"));
-            s += QString("%1 ").arg(List[i]);
+            values.append(List[i]);
         }
     } else {
         double start,stop,step,fac,points;
@@ -135,7 +130,7 @@ QString Param_Sweep::getNgspiceBeforeSim(QString sim, int lvl)
         if(type == "lin") {
             step = (stop-start)/points;
             for (; start <= stop; start += step) {
-                s += QString("%1 ").arg(start);
+                values.append(QString("%1").arg(start));
             }
         } else {
             start = log10(start);
@@ -143,53 +138,126 @@ QString Param_Sweep::getNgspiceBeforeSim(QString sim, int lvl)
             step = (stop - start)/points;
 
             for(; start <= stop; start += step) {
-                s += QString("%1 ").arg(pow(10, start));
+                values.append(QString("%1").arg(pow(10, start)));
             }
 
             if (start - step < stop) {
-                s += QString("%1 ").arg(pow(10, stop));
+                values.append(QString("%1").arg(pow(10, stop)));
             }
         }
     }
+    return values;
+}
+
+/*!
+ * \brief Param_Sweep::setShard Restrict the Ngspice sweep loop to one of
+ *        "count" equal parts of the sweep values. Parts are numbered from 0.
+ */
+void Param_Sweep::setShard(int index, int count)
+{
+    ShardIndex = index;
+    ShardCount = count;
+}
+
+/*!
+ * \brief Param_Sweep::getLoopStart Ngspice script opening the sweep loop.
+ *        The sweep points are numbered in the counter variable and listed
+ *        in the .res file of the simulation.
+ * \param step_var Name of the loop variable, it takes the sweep values
+ */
+QString Param_Sweep::getLoopStart(const QString &sim, int lvl, const QString &step_var)
+{
+    QString s;
+    s = QString("let number_%1 = 0\n").arg(step_var);
+    if (lvl==0) s += QString("echo \"STEP %1.%2\" > spice4qucs.%3.cir.res\n").arg(sim).arg(step_var).arg(sim);
+    else s += QString("echo \"STEP %1.%2\" > spice4qucs.%3.cir.res%4\n").arg(sim).arg(step_var).arg(sim).arg(lvl);
+
+    s += QString("foreach  %1_act ").arg(step_var);
+
+    QStringList values = getSweepValues();
+    if (ShardCount > 1) { // this process runs a contiguous part of the sweep
+        int first = ShardIndex*values.count()/ShardCount;
+        int last = (ShardIndex+1)*values.count()/ShardCount;
+        values = values.mid(first, last-first);
+    }
+    for (const QString &val : values) {
+        s += QString("%1 ").arg(val);
+    }
     s += "\n"; // newline after step listing
-    QString nline_char('\n');
-    for(constListIterator=parameter_list.begin(); constListIterator!=parameter_list.end();++constListIterator)
-    {
-        QString par = *constListIterator;
-
-        bool modelsweep = false; // Find component and its modelstring
-        bool compfound = false;
-        QString mod,mod_par;
-
-        if (!par.contains('@')) {
-            QStringList par_lst = par.split('.',qucs::SkipEmptyParts);
-            if (par_lst.count()>1) {
-                mod_par = par_lst.at(1);
-                // Schematic *sch = (Schematic *) QucsMain->DocumentTab->currentPage();
-                Schematic *sch = getSchematic();
-                Component *pc = sch->getComponentByName(par_lst.at(0));
-                if (pc != NULL) {
-                    mod = pc->getSpiceNetlist().section('\n',1,1,QString::SectionSkipEmpty)
-                                            .section(' ',1,1,QString::SectionSkipEmpty);
-                    if (!mod.isEmpty()) modelsweep = true;
-                }
+    return s;
+}
+
+/*!
+ * \brief Param_Sweep::getAlterScript Ngspice command setting a parameter
+ *        inside the sweep loop.
+ * \param par Component, model parameter (component.parameter) or circuit
+ *        parameter
+ * \param value Value or variable reference to set
+ * \param comp Name looked up as component for "alter"
+ * \param sweep_model Alter the model named by "par"
+ */
+QString Param_Sweep::getAlterScript(const QString &par, const QString &value,
+                                    const QString &comp, bool sweep_model)
+{
+    bool modelsweep = false; // Find component and its modelstring
+    QString mod,mod_par;
+    Schematic *sch = getSchematic();
+
+    if (!par.contains('@')) {
+        QStringList par_lst = par.split('.',qucs::SkipEmptyParts);
+        if (par_lst.count()>1) {
+            mod_par = par_lst.at(1);
+            Component *pc = sch->getComponentByName(par_lst.at(0));
+            if (pc != NULL) {
+                mod = pc->getSpiceNetlist().section('\n',1,1,QString::SectionSkipEmpty)
+                                        .section(' ',1,1,QString::SectionSkipEmpty);
+                if (!mod.isEmpty()) modelsweep = true;
             }
         }
+    }
 
-        Schematic *sch = getSchematic();
-        Component *pc = sch->getComponentByName(getProperty("Param")->Value);
-        if (pc != NULL) compfound = true;
-        else compfound = false;
+    bool compfound = (sch->getComponentByName(comp) != NULL);
 
-        if (modelsweep) { // Model parameter sweep
-            s += QString("altermod %1 %2 = $%3_act%4").arg(mod).arg(mod_par).arg(step_var).arg(nline_char);
-        } else {
-            QString mswp = getProperty("SweepModel")->Value;
-            if (mswp == "true")
-                s += QString("altermod %1 = $%2_act%3").arg(par).arg(step_var).arg(nline_char);
-            else if (compfound) s += QString("alter %1 = $%2_act%3").arg(par).arg(step_var).arg(nline_char);
-            else s += QString("alterparam %1 = $%2_act%3reset%3").arg(par).arg(step_var).arg(nline_char);
-        }
+    if (modelsweep) // Model parameter sweep
+        return QString("altermod %1 %2 = %3\n").arg(mod).arg(mod_par).arg(value);
+    if (sweep_model)
+        return QString("altermod %1 = %2\n").arg(par).arg(value);
+    if (compfound)
+        return QString("alter %1 = %2\n").arg(par).arg(value);
+    return QString("alterparam %1 = %2\nreset\n").arg(par).arg(value);
+}
+
+/*!
+ * \brief Param_Sweep::getLoopEnd Ngspice script closing the sweep loop
+ *        opened by getLoopStart().
+ */
+QString Param_Sweep::getLoopEnd(const QString &sim, int lvl, const QString &step_var)
+{
+    QString s;
+    s = "set appendwrite\n";
+
+    if (lvl==0) s += QString("echo \"$&number_%1  $%2_act\">> spice4qucs.%3.cir.res\n").arg(step_var).arg(step_var).arg(sim);
+    else s += QString("echo \"$&number_%1\" $%1_act >> spice4qucs.%2.cir.res%3\n").arg(step_var).arg(sim).arg(lvl);
+    s += QString("let number_%1 = number_%1 + 1\n").arg(step_var);
+
+    s += "end\n";
+    s += "unset appendwrite\n";
+    return s;
+}
+
+QString Param_Sweep::getNgspiceBeforeSim(QString sim, int lvl)
+{
+    if (isActive != COMP_IS_ACTIVE) return QString("");
+
+    QStringList parameter_list = getProperty("Param")->Value.split( this->param_split_str );
+    QString step_var = parameter_list.begin()->toLower();// use first element name as variable name
+    step_var.remove(QRegularExpression("[\\.\\[\\]@:]"));
+
+    QString s = getLoopStart(sim,lvl,step_var);
+    bool sweep_model = (getProperty("SweepModel")->Value == "true");
+    for (const QString &par : parameter_list) {
+        s += getAlterScript(par, QString("$%1_act").arg(step_var),
+                            getProperty("Param")->Value, sweep_model);
     }
     return s;
 }
@@ -198,21 +266,10 @@ QString Param_Sweep::getNgspiceAfterSim(QString sim, int lvl)
 {
     if (isActive != COMP_IS_ACTIVE) return QString("");
 
-    QString s;
     QStringList parameter_list = getProperty("Param")->Value.split( this->param_split_str );
     QString par = parameter_list.begin()->toLower();
-    QString type = getProperty("Type")->Value;
     par.remove(QRegularExpression("[\\.\\[\\]@:]"));
-
-    s = "set appendwrite\n";
-
-    if (lvl==0) s += QString("echo \"$&number_%1  $%2_act\">> spice4qucs.%3.cir.res\n").arg(par).arg(par).arg(sim);
-    else s += QString("echo \"$&number_%1\" $%1_act >> spice4qucs.%2.cir.res%3\n").arg(par).arg(sim).arg(lvl);
-    s += QString("let number_%1 = number_%1 + 1\n").arg(par);
-
-    s += "end\n";
-    s += "unset appendwrite\n";
-    return s;
+    return getLoopEnd(sim,lvl,par);
 }
 
 QString Param_Sweep::getCounterVar()
@@ -31,12 +31,21 @@ public:
 
   QString getNgspiceBeforeSim(QString sim, int lvl=0);
   QString getNgspiceAfterSim(QString sim, int lvl=0);
-  QString getCounterVar();
+  virtual QString getCounterVar();
+  virtual QStringList getSweepValues();
+  void setShard(int index, int count);
 
 protected:
   QString spice_netlist(bool isXyce);
   QString netlist();
+  QString getLoopStart(const QString &sim, int lvl, const QString &step_var);
+  QString getLoopEnd(const QString &sim, int lvl, const QString &step_var);
+  QString getAlterScript(const QString &par, const QString &value,
+                         const QString &comp, bool sweep_model);
   QString param_split_str=";";
+
+private:
+  int ShardIndex, ShardCount;   // part of the sweep written by getNgspiceBeforeSim()
 };
 
 #endif
@@ -0,0 +1,392 @@
+/***************************************************************************
+                            spiceconvcache.cpp
+                           --------------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "spiceconvcache.h"
+#include "spicefile.h"
+#include "schematic.h"
+#include "subcircuitcache.h"
+#include "main.h"
+#include "qucs.h"
+#include "misc.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QProcess>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSet>
+#include <QElapsedTimer>
+#include <QProgressDialog>
+#include <QApplication>
+#include <QThread>
+#include <QMutex>
+#include <QDateTime>
+#include <QDebug>
+
+/*!
+  \file spiceconvcache.cpp
+  \brief Implementation of the SpiceConvCache class
+*/
+
+QAtomicInt SpiceConvCache::Aborted;
+
+/*!
+ * \brief The SpiceConvJob class converts one SPICE file on a pool thread.
+ *        The results stay in the job, which is owned by the caller.
+ */
+class SpiceConvJob : public QRunnable
+{
+public:
+    explicit SpiceConvJob(const SpiceConvCache::Request &req) : Req(req), Ok(false)
+    {
+        setAutoDelete(false);
+    }
+    void run()
+    {
+        if (SpiceConvCache::lookup(Req, Text)) {
+            Ok = true;
+            return;
+        }
+        QString k = SpiceConvCache::key(Req);
+        if (k.isEmpty())
+            Errors += QObject::tr("ERROR: Cannot open SPICE file \"%1\".").arg(Req.file);
+        else
+            Ok = SpiceConvCache::runConversion(Req, k, Text, Errors);
+    }
+
+    SpiceConvCache::Request Req;
+    QString Text, Errors;
+    bool Ok;
+};
+
+/*!
+ * \brief SpiceConvCache::lookup Read a previously converted netlist.
+ * \param req Conversion request
+ * \param text Converted netlist text
+ * \return true if the cache holds a conversion of the current contents
+ */
+bool SpiceConvCache::lookup(const Request &req, QString &text)
+{
+    QString k = key(req);
+    if (k.isEmpty()) return false;
+    QFile file(cacheDir() + "/" + k + ".lst");
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    text = QString::fromUtf8(file.readAll());
+    // the modification time tells trim() when the entry was used last
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    file.close();
+    return true;
+}
+
+/*!
+ * \brief SpiceConvCache::convert Run the preprocessor and qucsconv on a
+ *        SPICE file and store the result in the cache. Blocks until the
+ *        conversion is finished, so it may be called on worker threads;
+ *        on the GUI thread it can be aborted.
+ * \param req Conversion request
+ * \param text Converted netlist text
+ * \param errors Error output of the programs is appended here
+ * \return false if a program could not be started, did not finish in
+ *         time, was aborted, crashed or reported an error. Only the
+ *         results of successful runs are used and cached.
+ */
+bool SpiceConvCache::convert(const Request &req, QString &text, QString &errors)
+{
+    SpiceConvJob job(req);
+    if (QucsMain && (QThread::currentThread() == qApp->thread()))
+        runJobs(QList<SpiceConvJob*>() << &job);
+    else
+        job.run();
+    text = job.Text;
+    errors += job.Errors;
+    return job.Ok;
+}
+
+/*!
+ * \brief SpiceConvCache::saveListing Write the converted netlist next to
+ *        the SPICE file as "<file>.lst", unless it holds this text already.
+ *        The text also depends on the ports and the preprocessor, so the
+ *        contents are compared, not the file times.
+ */
+void SpiceConvCache::saveListing(const Request &req, const QString &text)
+{
+    QByteArray data = text.toUtf8();
+    QString name = req.file + ".lst";
+    QFile old(name);
+    if ((old.size() == data.size()) && old.open(QIODevice::ReadOnly)) {
+        bool same = (old.readAll() == data);
+        old.close();
+        if (same) return;
+    }
+
+    QSaveFile file(name);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(data);
+        file.commit();
+    }
+}
+
+/*!
+ * \brief SpiceConvCache::prefetch Convert all SPICE files of the hierarchy
+ *        below "top" which are not cached yet concurrently. Returns when
+ *        all conversions are finished.
+ * \param top Schematic which is about to be netlisted
+ */
+void SpiceConvCache::prefetch(Schematic *top)
+{
+    QList<Request> requests;
+    QSet<QString> seen;     // distinct requests
+    QSet<QString> visited;  // subcircuit files
+    QList<Schematic*> docs;
+    docs.append(top);
+
+    while (!docs.isEmpty()) {
+        Schematic *doc = docs.takeFirst();
+        for (Component *pc : doc->DocComps) {
+            if (pc->Model == "Sub") {
+                pc->setSchematic(doc);
+                QString f = pc->getSubcircuitFile();
+                if (f.isEmpty() || visited.contains(f)) continue;
+                visited.insert(f);
+                Schematic *d = SubcircuitCache::document(f);
+                if (d) docs.append(d);
+            } else if (pc->Model == "SPICE") {
+                if (pc->Props.first()->Value.isEmpty()) continue;
+                pc->setSchematic(doc);
+                Request req = ((SpiceFile*)pc)->conversionRequest();
+                QString id = req.file + '\n' + req.ports + '\n' +
+                             req.preprocessor + (req.insertSim ? "\n1" : "\n0");
+                if (seen.contains(id)) continue;
+                seen.insert(id);
+                requests.append(req);
+            }
+        }
+    }
+    if (requests.isEmpty()) return;
+
+    QList<SpiceConvJob*> jobs;
+    for (const Request &req : requests)
+        jobs.append(new SpiceConvJob(req));
+    runJobs(jobs);
+    // errors are dropped here; a failed conversion is not cached and is
+    // run again (and reported) by SpiceFile::createSubNetlist()
+    qDeleteAll(jobs);
+}
+
+// ---------------------------------------------------------------------
+// Runs the jobs on a pool. With the GUI, a modal progress dialog is shown
+// after a moment, its Abort button stops all running programs. Events are
+// only processed while the dialog is shown, so the user cannot edit,
+// close or simulate documents during the netlisting.
+void SpiceConvCache::runJobs(const QList<SpiceConvJob*> &jobs)
+{
+    Aborted = 0;
+    QThreadPool pool;
+    for (SpiceConvJob *job : jobs)
+        pool.start(job);
+    if (!QucsMain || (QThread::currentThread() != qApp->thread())) {
+        pool.waitForDone();
+        return;
+    }
+    if (pool.waitForDone(500)) return;
+
+    QProgressDialog progress(QObject::tr("Converting SPICE files..."),
+                             QObject::tr("Abort"), 0, 0, QucsMain);
+    progress.setWindowModality(Qt::ApplicationModal);
+    progress.setMinimumDuration(0);
+    progress.show();
+    while (!pool.waitForDone(50)) {
+        qApp->processEvents();
+        if (progress.wasCanceled()) Aborted = 1;
+    }
+}
+
+// ---------------------------------------------------------------------
+// Waits for a program, kills it on timeout or abort.
+bool SpiceConvCache::waitForProcess(QProcess &proc, const QString &what,
+                                    QString &errors)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!proc.waitForFinished(100)) {
+        if (proc.state() == QProcess::NotRunning) break;
+        bool timedOut = (timer.elapsed() > Timeout);
+        if (timedOut || Aborted.loadAcquire()) {
+            proc.kill();
+            proc.waitForFinished();
+            if (timedOut)
+                errors += QObject::tr("ERROR: \"%1\" did not finish within %2 s.")
+                          .arg(what).arg(Timeout/1000);
+            else
+                errors += QObject::tr("ERROR: \"%1\" aborted.").arg(what);
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------
+// Hash of the file contents and of everything else the result depends on.
+QString SpiceConvCache::key(const Request &req)
+{
+    QFile file(req.file);
+    if (!file.open(QIODevice::ReadOnly)) return QString();
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(&file);
+    file.close();
+
+    QString options = req.preprocessor + '\n' + req.ports + '\n' +
+                      (req.insertSim ? "sim\n" : "nosim\n") +
+                      misc::properName(misc::properFileName(req.file)) + '\n' +
+                      QucsSettings.Qucsconv + '\n' + PACKAGE_VERSION;
+    hash.addData(options.toUtf8());
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+// ---------------------------------------------------------------------
+QString SpiceConvCache::cacheDir()
+{
+    QString dir = QucsSettings.QucsHomeDir.absoluteFilePath("spiceconv");
+    QDir().mkpath(dir);
+    return dir;
+}
+
+// ---------------------------------------------------------------------
+bool SpiceConvCache::runConversion(const Request &req, const QString &key,
+                                   QString &text, QString &errors)
+{
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    QString source = req.file;
+    QString prepName;
+
+    // preprocessor run if necessary
+    if (req.preprocessor != "none") {
+#ifdef __MINGW32__
+        QString interpreter = "tinyperl.exe";
+#else
+        QString interpreter = "perl";
+#endif
+        prepName = cacheDir() + "/" + key + ".pre";
+        QStringList args;
+        args << "-S";
+        QProcess prep;
+        prep.setProcessEnvironment(env);
+        if (req.preprocessor == "spiceprm") {
+            args << "spiceprm" << source << prepName;
+            prep.setStandardOutputFile(QProcess::nullDevice());
+        } else {
+            args << (req.preprocessor == "ps2sp" ? "ps2sp" : "spicepp.pl") << source;
+            prep.setStandardOutputFile(prepName);
+        }
+        prep.start(interpreter, args);
+        if (!prep.waitForStarted()) {
+            errors += QObject::tr("ERROR: Cannot execute \"%1\".").
+                      arg(interpreter + " " + args.join(" "));
+            return false;
+        }
+        if (!waitForProcess(prep, interpreter + " " + args.join(" "), errors)) {
+            QFile::remove(prepName);
+            return false;
+        }
+        errors += QString(prep.readAllStandardError());
+        if ((prep.exitStatus() != QProcess::NormalExit) || (prep.exitCode() != 0)) {
+            errors += QObject::tr("ERROR: \"%1\" failed.").arg(interpreter + " " + args.join(" "));
+            QFile::remove(prepName);
+            return false;
+        }
+        source = prepName;
+    }
+
+    // begin command line construction
+    bool makeSubcircuit = !req.ports.isEmpty();
+    QStringList com;
+    if (makeSubcircuit) com << "-g" << "_ref";
+    com << "-if" << "spice" << "-of" << "qucs";
+    com << "-i" << source;
+
+    QProcess conv;
+    conv.setProcessEnvironment(env);
+    qDebug() << "SpiceConvCache::runConversion :Command:" << QucsSettings.Qucsconv << com.join(" ");
+    conv.start(QucsSettings.Qucsconv, com);
+    if (!conv.waitForStarted()) {
+        errors += QObject::tr("COMP ERROR: Cannot start QucsConv!");
+        if (!prepName.isEmpty()) QFile::remove(prepName);
+        return false;
+    }
+    bool finished = waitForProcess(conv, QucsSettings.Qucsconv, errors);
+    if (!prepName.isEmpty()) QFile::remove(prepName);
+    if (!finished) return false;
+    errors += QString(conv.readAllStandardError());
+    if (conv.exitStatus() != QProcess::NormalExit) {
+        errors += QObject::tr("COMP ERROR: QucsConv crashed!");
+        return false;
+    }
+    if (conv.exitCode() != 0) {
+        errors += QObject::tr("COMP ERROR: QucsConv failed with exit code %1!")
+                  .arg(conv.exitCode());
+        return false;
+    }
+
+    // begin netlist text creation
+    text = "\n";
+    if (makeSubcircuit) {
+        QString PortNames = req.ports;
+        PortNames.replace(',', ' ');
+        text += ".Def:" + misc::properName(misc::properFileName(req.file)) +
+                " " + PortNames + " _ref\n";
+    }
+
+    QString SimText;
+    QStringList lines = QString(conv.readAllStandardOutput()).split('\n');
+    if (!lines.isEmpty()) lines.removeLast(); // unterminated rest
+    for (QString s : lines) {
+        s = s.trimmed();
+        if (s.isEmpty() || s.at(0) == '#') continue;
+        if (s.at(0) == '.' && !s.startsWith(".Def:")) {
+            if (req.insertSim) SimText += s + "\n";
+            continue;
+        }
+        if (makeSubcircuit) text += "  ";
+        text += s + "\n";
+    }
+
+    if (makeSubcircuit) text += ".Def:End\n\n";
+    text += SimText;
+
+    QSaveFile file(cacheDir() + "/" + key + ".lst");
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(text.toUtf8());
+        file.commit();
+    }
+    trim();
+    return true;
+}
+
+// ---------------------------------------------------------------------
+// Removes the conversions used longest ago, see lookup(), when the cache
+// holds more than MaxEntries of them.
+void SpiceConvCache::trim()
+{
+    static QMutex mutex;  // conversions finish on several threads
+    QMutexLocker lock(&mutex);
+    QDir dir(cacheDir());
+    QFileInfoList entries = dir.entryInfoList(QStringList("*.lst"), QDir::Files, QDir::Time);
+    for (int i = MaxEntries; i < entries.count(); i++)  // newest first
+        QFile::remove(entries.at(i).filePath());
+}
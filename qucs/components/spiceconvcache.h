@@ -0,0 +1,85 @@
+/***************************************************************************
+                             spiceconvcache.h
+                            ------------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SPICECONVCACHE_H
+#define SPICECONVCACHE_H
+
+#include <QString>
+#include <QList>
+#include <QAtomicInt>
+
+class Schematic;
+class QProcess;
+class SpiceConvJob;
+
+/*!
+  \file spiceconvcache.h
+  \brief Declaration of the SpiceConvCache class
+*/
+
+/*!
+ * \brief The SpiceConvCache class converts SPICE files into Qucs subcircuit
+ *        netlists (optional perl preprocessor and qucsconv) and caches the
+ *        results in the "spiceconv" directory of the Qucs home directory.
+ *        The cache key is the SHA-256 of the SPICE file contents together
+ *        with all options which influence the result, so a conversion is
+ *        run only once per content change, independent of file times.
+ *
+ *        Before a Qucsator netlist is created, prefetch() collects all
+ *        SPICE components of the hierarchy and runs the missing conversions
+ *        concurrently.
+ *
+ *        Every program run is limited to Timeout. When Qucs is running
+ *        and the conversions take longer than a moment, the GUI thread
+ *        waits behind a modal progress dialog whose Abort button stops all
+ *        running conversions. The converted netlist is also written next
+ *        to the SPICE file as "<file>.lst", where the library dialog picks
+ *        it up. The cache keeps the MaxEntries conversions used last.
+ */
+class SpiceConvCache
+{
+public:
+    struct Request {
+        QString file;          //!< absolute SPICE file name
+        QString ports;         //!< "Ports" property, empty: no subcircuit
+        QString preprocessor;  //!< "none", "ps2sp", "spicepp" or "spiceprm"
+        bool insertSim;        //!< copy simulation commands into the netlist
+    };
+
+    static const int Timeout = 60000;    //!< ms, per program run
+    static const int MaxEntries = 512;   //!< conversions kept in the cache
+
+    static bool lookup(const Request &req, QString &text);
+    static bool convert(const Request &req, QString &text, QString &errors);
+    static void prefetch(Schematic *top);
+    static void saveListing(const Request &req, const QString &text);
+
+private:
+    friend class SpiceConvJob;
+
+    static QString key(const Request &req);
+    static QString cacheDir();
+    static bool runConversion(const Request &req, const QString &key,
+                              QString &text, QString &errors);
+    static bool waitForProcess(QProcess &proc, const QString &what,
+                               QString &errors);
+    static void runJobs(const QList<SpiceConvJob*> &jobs);
+    static void trim();
+
+    static QAtomicInt Aborted;   // set by the Abort button of runJobs()
+};
+
+#endif // SPICECONVCACHE_H
@@ -19,10 +19,8 @@
 # include <unistd.h>
 #endif
 #include <QRegularExpression>
-#include <QProcess>
 #include <QString>
 #include <QStringList>
-#include <QMessageBox>
 #include <QTextStream>
 #include <QFile>
 #include <QDir>
@@ -52,7 +50,6 @@ SpiceFile::SpiceFile()
   Model = "SPICE";
   SpiceModel = "X";
   Name  = "X";
-  changed = false;
 
   // Do NOT call createSymbol() here. But create port to let it rotate.
   Ports.append(new Port(0, 0));
@@ -147,7 +144,6 @@ void SpiceFile::createSymbol()
   tx = x1+4;
   ty = y1 - fHeight - 4;
   if(Props.first()->display) ty -= fHeight;
-  changed = true;
 }
 
 // ---------------------------------------------------
@@ -272,9 +268,22 @@ QString SpiceFile::getSubcircuitFile()
 
 }
 
+// -------------------------------------------------------------------------
+SpiceConvCache::Request SpiceFile::conversionRequest()
+{
+  SpiceConvCache::Request req;
+  req.file = getSubcircuitFile();
+  req.ports = Props.at(1)->Value;
+  req.insertSim = (Props.at(2)->Value == "yes");
+  req.preprocessor = Props.at(3)->Value;
+  return req;
+}
+
 // -------------------------------------------------------------------------
 bool SpiceFile::createSubNetlist(QTextStream *stream)
 {
+  ErrText = "";
+
   // check file name
   QString FileName = Props.first()->Value;
   if(FileName.isEmpty()) {
@@ -283,51 +292,36 @@ bool SpiceFile::createSubNetlist(QTextStream *stream)
     return false;
   }
 
-  // check input and output file
-  QFile SpiceFile, ConvFile;
-  FileName = getSubcircuitFile();
-  SpiceFile.setFileName(FileName);
+  // check input file
+  SpiceConvCache::Request req = conversionRequest();
+  QFile SpiceFile(req.file);
   if(!SpiceFile.open(QIODevice::ReadOnly)) {
     ErrText += QObject::tr("ERROR: Cannot open SPICE file \"%1\".").
-      arg(FileName);
+      arg(req.file);
     return false;
   }
   SpiceFile.close();
-  QString ConvName = SpiceFile.fileName() + ".lst";
-  ConvFile.setFileName(ConvName);
-  QFileInfo Info(ConvName);
-
-  // re-create converted file if necessary
-  if(changed || !ConvFile.exists() ||
-     (lastLoaded.isValid() && lastLoaded < Info.lastModified())) {
-    if(!ConvFile.open(QIODevice::WriteOnly)) {
-      ErrText += QObject::tr("ERROR: Cannot save converted SPICE file \"%1\".").
-                          arg(FileName + ".lst");
-      return false;
+
+  // converted netlists are cached by content, convert only if necessary
+  QString NetText;
+  if(!SpiceConvCache::lookup(req, NetText)) {
+    // only interact with the GUI if it was launched
+    if (QucsMain) {
+      QucsMain->statusBar()->showMessage(tr("Converting SPICE file \"%1\".").arg(req.file), 2000);
     }
-    outstream = stream;
-    filstream = new QTextStream(&ConvFile);
-    QString SpiceName = SpiceFile.fileName();
-    bool ret = recreateSubNetlist(&SpiceName, &FileName);
-    ConvFile.close();
-    delete filstream;
-    return ret;
-  }
+    else
+      qDebug() << QObject::tr("Converting SPICE file \"%1\".").arg(req.file);
 
-  // load old file and stuff into stream
-  if(!ConvFile.open(QIODevice::ReadOnly)) {
-    ErrText += QObject::tr("ERROR: Cannot open converted SPICE file \"%1\".").
-                        arg(FileName + ".lst");
-    return false;
+    if(!SpiceConvCache::convert(req, NetText, ErrText))
+      return false;
   }
-  QByteArray FileContent = ConvFile.readAll();
-  ConvFile.close();
-  //? stream->writeRawBytes(FileContent.data(), FileContent.size());
-  (*stream) << FileContent.data();
+  // the library dialog includes the converted file
+  SpiceConvCache::saveListing(req, NetText);
+
+  (*stream) << NetText;
   return true;
 }
 
-
 bool SpiceFile::createSpiceSubckt(QTextStream *stream)
 {
     (*stream)<<"\n";
@@ -341,245 +335,6 @@ bool SpiceFile::createSpiceSubckt(QTextStream *stream)
     return true;
 }
 
-// -------------------------------------------------------------------------
-bool SpiceFile::recreateSubNetlist(QString *SpiceFile, QString *FileName)
-{
-  // initialize collectors
-  ErrText = "";
-  NetText = "";
-  SimText = "";
-  NetLine = "";
-
-  // evaluate properties
-  if(Props.at(1)->Value != "")
-    makeSubcircuit = true;
-  else
-    makeSubcircuit = false;
-  if(Props.at(2)->Value == "yes")
-    insertSim = true;
-  else
-    insertSim = false;
-
-  // preprocessor run if necessary
-  QString preprocessor = Props.at(3)->Value;
-  if (preprocessor != "none") {
-    bool piping = true;
-    QStringList script;
-#ifdef __MINGW32__
-    QString interpreter = "tinyperl.exe";
-#else
-    QString interpreter = "perl";
-#endif
-    if (preprocessor == "ps2sp") {
-      script << "ps2sp";
-    } else if (preprocessor == "spicepp") {
-      script << "spicepp.pl";
-    } else if (preprocessor == "spiceprm") {
-      script << "spiceprm";
-      piping = false;
-    }
-    SpicePrep = new QProcess(this);
-    script << interpreter;
-    script << script;
-    script << *SpiceFile;
-
-    QFile PrepFile;
-    QString PrepName = *SpiceFile + ".pre";
-
-    if (!piping) {
-      script << PrepName;
-      connect(SpicePrep, SIGNAL(readyReadStandardOutput()), SLOT(slotSkipOut()));
-      connect(SpicePrep, SIGNAL(readyReadStandardError()), SLOT(slotGetPrepErr()));
-    } else {
-      connect(SpicePrep, SIGNAL(readyReadStandardOutput()), SLOT(slotGetPrepOut()));
-      connect(SpicePrep, SIGNAL(readyReadStandardError()), SLOT(slotGetPrepErr()));
-    }
-
-    QMessageBox *MBox = 
-      new QMessageBox(QMessageBox::NoIcon,
-                      QObject::tr("Info"),
-                      QObject::tr("Preprocessing SPICE file \"%1\".").arg(*SpiceFile),
-                      QMessageBox::Abort);
-    MBox->setAttribute(Qt::WA_DeleteOnClose);
-    connect(SpicePrep, SIGNAL(finished(int)), MBox, SLOT(close()));
-
-    if (piping) {
-      PrepFile.setFileName(PrepName);
-      if(!PrepFile.open(QIODevice::WriteOnly)) {
-        ErrText +=
-          QObject::tr("ERROR: Cannot save preprocessed SPICE file \"%1\".").
-          arg(PrepName);
-        return false;
-      }
-      prestream = new QTextStream(&PrepFile);
-    }
-
-    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-    env.insert("PATH", env.value("PATH") );
-    SpicePrep->setProcessEnvironment(env);
-    QString cmd = script.at(0);
-    QStringList script_args = script;
-    script_args.removeAt(0);
-    SpicePrep->start(cmd,script_args);
-    //QucsHelp->setCommunication(0);
-
-    if(SpicePrep->state()!=QProcess::Running&&
-            SpicePrep->state()!=QProcess::Starting) {
-      ErrText += QObject::tr("ERROR: Cannot execute \"%1\".").
-              arg(interpreter + " " + script.join(" ") + "\".");
-      if (piping) {
-        PrepFile.close();
-        delete prestream;
-      }
-      return false;
-    }
-    //SpicePrep->closeStdin();
-
-    MBox->exec();
-    delete SpicePrep;
-    if (piping) {
-      PrepFile.close();
-      delete prestream;
-    }
-    *SpiceFile = PrepName;
-  }
-
-  // begin command line construction
-  QString prog;
-  QStringList com;
-  //prog =  QucsSettings.BinDir + "qucsconv"  + executableSuffix;
-  prog =  QucsSettings.Qucsconv;
-
-  if(makeSubcircuit) com << "-g" << "_ref";
-  com << "-if" << "spice" << "-of" << "qucs";
-  com << "-i" << *SpiceFile;
-
-  // begin netlist text creation
-  if(makeSubcircuit) {
-    QString f = misc::properFileName(*FileName);
-    NetText += "\n.Def:" + misc::properName(f) + " ";
-    QString PortNames = Props.at(1)->Value;
-    PortNames.replace(',', ' ');
-    NetText += PortNames;
-    if(makeSubcircuit) NetText += " _ref";
-  }
-  NetText += "\n";
-
-  // startup SPICE conversion process
-  QucsConv = new QProcess(this);
-  QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-  env.insert("PATH", env.value("PATH") );
-  QucsConv->setProcessEnvironment(env);
-
-  qDebug() << "SpiceFile::recreateSubNetlist :Command:" << prog << com.join(" ");
-//  QucsConv->start(com.join(" "));
-  QucsConv->start(prog, com);
-
-  /// these slots might write into NetText, ErrText, outstream, filstream
-  connect(QucsConv, SIGNAL(readyReadStandardOutput()), SLOT(slotGetNetlist()));
-  connect(QucsConv, SIGNAL(readyReadStandardError()), SLOT(slotGetError()));
-  connect(QucsConv, SIGNAL(finished(int,QProcess::ExitStatus)), SLOT(slotExited()));
-
-  if(QucsConv->state()!=QProcess::Running&&
-          QucsConv->state()!=QProcess::Starting) {
-    ErrText += QObject::tr("COMP ERROR: Cannot start QucsConv!");
-    return false;
-  }
-  (*outstream) << NetText;
-  (*filstream) << NetText;
-
-  // only interact with the GUI if it was launched
-  if (QucsMain) {
-    QucsMain->statusBar()->showMessage(tr("Converting SPICE file \"%1\".").arg(*SpiceFile), 2000);
-  }
-  else
-    qDebug() << QObject::tr("Converting SPICE file \"%1\".").arg(*SpiceFile);
-
-  // finish
-  QucsConv->waitForFinished();
-  delete QucsConv;
-  lastLoaded = QDateTime::currentDateTime();
-  return true;
-}
-
-// -------------------------------------------------------------------------
-void SpiceFile::slotSkipErr()
-{
-  SpicePrep->readAllStandardError();
-}
-
-// -------------------------------------------------------------------------
-void SpiceFile::slotSkipOut()
-{
-    SpicePrep->readAllStandardOutput();
-}
-
-// -------------------------------------------------------------------------
-void SpiceFile::slotGetPrepErr()
-{
-  ErrText += QString(SpicePrep->readAllStandardError());
-}
-
-// -------------------------------------------------------------------------
-void SpiceFile::slotGetPrepOut()
-{
-  (*prestream) << QString(SpicePrep->readAllStandardOutput());
-}
-
-// -------------------------------------------------------------------------
-void SpiceFile::slotGetError()
-{
-  ErrText += QString(QucsConv->readAllStandardError());
-}
-
-// -------------------------------------------------------------------------
-void SpiceFile::slotGetNetlist()
-{
-  int i;
-  QString s;
-  NetLine += QString(QucsConv->readAllStandardOutput());
-
-  while((i = NetLine.indexOf('\n')) >= 0) {
-    s = NetLine.left(i);
-    NetLine.remove(0, i+1);
-    s = s.trimmed();
-    if(s.size()>0&&s.at(0) == '#') {
-      continue;
-    } else if(s.isEmpty()) {
-      continue;
-    } else if(s.size()>0&&s.at(0) == '.') {
-      if(s.left(5) != ".Def:") {
-        if(insertSim) SimText += s + "\n";
-        continue;
-      }
-    }
-    if(makeSubcircuit) {
-      (*outstream) << "  ";
-      (*filstream) << "  ";
-    }
-    (*outstream) << s << "\n";
-    (*filstream) << s << "\n";
-  }
-}
-
-// -------------------------------------------------------------------------
-void SpiceFile::slotExited()
-{
-  if (QucsConv->exitStatus() != QProcess::NormalExit) {
-    NetText = "";
-  }
-  else {
-    if(makeSubcircuit) {
-      (*outstream) << ".Def:End\n\n";
-      (*filstream) << ".Def:End\n\n";
-    }
-    if(!SimText.isEmpty()) {
-      (*outstream) << SimText;
-      (*filstream) << SimText;
-    }
-  }
-}
-
 QString SpiceFile::spice_netlist(bool)
 {
     QStringList ports_lst = Props.at(1)->Value.split(",");
@@ -587,8 +342,9 @@ QString SpiceFile::spice_netlist(bool)
         if (it.startsWith("_net")) it.remove(0,4);
     }
     QStringList nod_lst;
-    QString compname = spicecompat::getSubcktName(getSubcircuitFile());
-    spicecompat::getPins(getSubcircuitFile(),compname,nod_lst);
+    QString subfile = getSubcircuitFile();
+    QString compname = spicecompat::getSubcktName(subfile);
+    spicecompat::getPins(subfile,compname,nod_lst);
 
     QList<int> seq;
     seq.clear();
@@ -602,6 +358,6 @@ QString SpiceFile::spice_netlist(bool)
         s += " "+Ports.at(i)->Connection->Name;   // node names
     }
 
-    s += " " + spicecompat::getSubcktName(getSubcircuitFile()) + "\n";
+    s += " " + compname + "\n";
     return s;
 }
@@ -18,11 +18,10 @@
 #ifndef SPICEFILE_H
 #define SPICEFILE_H
 #include "component.h"
+#include "spiceconvcache.h"
 
 #include <QObject>
-#include <QDateTime>
 
-class QProcess;
 class QTextStream;
 class QString;
 
@@ -39,30 +38,15 @@ public:
   bool createSpiceSubckt(QTextStream * stream);
   QString getErrorText() { return ErrText; }
   QString getSubcircuitFile();
+  SpiceConvCache::Request conversionRequest();
 
 private:
-  bool makeSubcircuit;
-  bool insertSim;
-  bool changed;
-  QProcess *QucsConv, *SpicePrep;
-  QString NetText, ErrText, NetLine, SimText;
-  QTextStream *outstream, *filstream, *prestream;
-  QDateTime lastLoaded;
-  bool recreateSubNetlist(QString *, QString *);
+  QString ErrText;
 
 protected:
   QString netlist();
   void createSymbol();
   QString spice_netlist(bool isXyce);
-
-private slots:
-  void slotGetNetlist();
-  void slotGetError();
-  void slotExited();
-  void slotSkipOut();
-  void slotSkipErr();
-  void slotGetPrepOut();
-  void slotGetPrepErr();
 };
 
 #endif
@@ -0,0 +1,135 @@
+/***************************************************************************
+                              symbolcache.cpp
+                             -----------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "symbolcache.h"
+
+#include <QDataStream>
+
+/*!
+  \file symbolcache.cpp
+  \brief Implementation of the SymbolCache class
+*/
+
+bool SymbolCache::Enabled = true;
+QMutex SymbolCache::Mutex;
+QHash<QByteArray, QWeakPointer<const SymbolGeometry> > SymbolCache::Symbols;
+int SymbolCache::Instances = 0;
+qint64 SymbolCache::PrivateBytes = 0;
+
+// approximate heap overhead of one allocation
+#define ALLOC_OVERHEAD (2 * (qint64) sizeof(void *))
+
+/*!
+ * \brief SymbolCache::acquire Return the shared geometry equal to the
+ *        given primitives, creating it on the first request. Every call
+ *        must be balanced by release().
+ */
+SymbolGeometryPtr SymbolCache::acquire(const QList<qucs::Line *> &lines,
+                                       const QList<qucs::Arc *> &arcs,
+                                       const QList<qucs::Area *> &rects,
+                                       const QList<qucs::Area *> &ellips,
+                                       const QList<Text *> &texts)
+{
+  // the serialized primitives are the key, so equal symbols are found
+  // independent of the component which created them
+  QByteArray key;
+  QDataStream stream(&key, QIODevice::WriteOnly);
+  stream << int(lines.size());
+  for (qucs::Line *p : lines)
+    stream << p->x1 << p->y1 << p->x2 << p->y2 << p->style;
+  stream << int(arcs.size());
+  for (qucs::Arc *p : arcs)
+    stream << p->x << p->y << p->w << p->h << p->angle << p->arclen << p->style;
+  stream << int(rects.size());
+  for (qucs::Area *p : rects)
+    stream << p->x << p->y << p->w << p->h << p->Pen << p->Brush;
+  stream << int(ellips.size());
+  for (qucs::Area *p : ellips)
+    stream << p->x << p->y << p->w << p->h << p->Pen << p->Brush;
+  stream << int(texts.size());
+  for (Text *p : texts)
+    stream << p->x << p->y << p->s << p->Color << p->Size << p->mSin
+           << p->mCos << p->over << p->under;
+
+  QMutexLocker locker(&Mutex);
+  SymbolGeometryPtr geometry = Symbols.value(key).toStrongRef();
+  if (geometry.isNull()) {
+    SymbolGeometry *g = new SymbolGeometry;
+    g->Bytes = 0;
+    g->Lines.reserve(lines.size());
+    for (qucs::Line *p : lines) g->Lines.push_back(*p);
+    g->Arcs.reserve(arcs.size());
+    for (qucs::Arc *p : arcs) g->Arcs.push_back(*p);
+    g->Rects.reserve(rects.size());
+    for (qucs::Area *p : rects) g->Rects.push_back(*p);
+    g->Ellips.reserve(ellips.size());
+    for (qucs::Area *p : ellips) g->Ellips.push_back(*p);
+    g->Texts.reserve(texts.size());
+    for (Text *p : texts) {
+      g->Texts.push_back(*p);
+      g->Bytes += p->s.size() * (qint64) sizeof(QChar);
+    }
+    g->Bytes += lines.size() * (sizeof(qucs::Line) + ALLOC_OVERHEAD)
+              + arcs.size() * (sizeof(qucs::Arc) + ALLOC_OVERHEAD)
+              + (rects.size() + ellips.size()) * (sizeof(qucs::Area) + ALLOC_OVERHEAD)
+              + texts.size() * (sizeof(Text) + ALLOC_OVERHEAD);
+    geometry = SymbolGeometryPtr(g);
+
+    // drop the keys of geometries no component uses anymore
+    if (Symbols.size() > 256 && Symbols.size() % 256 == 0) {
+      QMutableHashIterator<QByteArray, QWeakPointer<const SymbolGeometry> > it(Symbols);
+      while (it.hasNext()) {
+        it.next();
+        if (it.value().isNull()) it.remove();
+      }
+    }
+    Symbols.insert(key, geometry);
+  }
+  Instances++;
+  PrivateBytes += geometry->Bytes;
+  return geometry;
+}
+
+/*!
+ * \brief SymbolCache::release A component stops using a geometry.
+ */
+void SymbolCache::release(const SymbolGeometryPtr &geometry)
+{
+  if (geometry.isNull()) return;
+  QMutexLocker locker(&Mutex);
+  Instances--;
+  PrivateBytes -= geometry->Bytes;
+}
+
+/*!
+ * \brief SymbolCache::statistics Memory use of the shared symbols.
+ */
+SymbolCache::Statistics SymbolCache::statistics()
+{
+  QMutexLocker locker(&Mutex);
+  Statistics s;
+  s.symbols = 0;
+  s.sharedBytes = 0;
+  for (auto it = Symbols.constBegin(); it != Symbols.constEnd(); ++it) {
+    SymbolGeometryPtr g = it.value().toStrongRef();
+    if (g.isNull()) continue;
+    s.symbols++;
+    s.sharedBytes += g->Bytes;
+  }
+  s.instances = Instances;
+  s.privateBytes = PrivateBytes;
+  return s;
+}
@@ -0,0 +1,94 @@
+/***************************************************************************
+                               symbolcache.h
+                              ---------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SYMBOLCACHE_H
+#define SYMBOLCACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+
+#include <vector>
+
+#include "element.h"
+
+/*!
+  \file symbolcache.h
+  \brief Declaration of the SymbolGeometry and SymbolCache classes
+*/
+
+/*!
+ * \brief The SymbolGeometry struct holds the painting primitives of one
+ *        component symbol in one orientation in contiguous arrays. It is
+ *        immutable once created and shared by all components which show
+ *        the same symbol.
+ */
+struct SymbolGeometry {
+  std::vector<qucs::Line> Lines;
+  std::vector<qucs::Arc>  Arcs;
+  std::vector<qucs::Area> Rects;
+  std::vector<qucs::Area> Ellips;
+  std::vector<Text>       Texts;
+  qint64 Bytes;   //!< memory one private copy of the primitives takes
+};
+
+typedef QSharedPointer<const SymbolGeometry> SymbolGeometryPtr;
+
+/*!
+ * \brief The SymbolCache class interns component symbol geometry. Symbols
+ *        are compared by content, i.e. model, variant (e.g. the european
+ *        or US resistor), rotation and mirroring are all covered by the
+ *        primitives themselves. A geometry lives as long as a component
+ *        uses it.
+ *
+ *        Components keep their primitive lists, which then point into the
+ *        shared arrays; see Component::shareSymbol(). The byte counts of
+ *        statistics() are computed from the object sizes; qucs-bench
+ *        measures the actual heap use with and without sharing.
+ */
+class SymbolCache
+{
+public:
+  struct Statistics {
+    int symbols;          //!< distinct geometries alive
+    int instances;        //!< components using a shared geometry
+    qint64 sharedBytes;   //!< memory of the shared primitives
+    qint64 privateBytes;  //!< memory the instances would use without sharing
+  };
+
+  static SymbolGeometryPtr acquire(const QList<qucs::Line *> &lines,
+                                   const QList<qucs::Arc *> &arcs,
+                                   const QList<qucs::Area *> &rects,
+                                   const QList<qucs::Area *> &ellips,
+                                   const QList<Text *> &texts);
+  static void release(const SymbolGeometryPtr &geometry);
+  static Statistics statistics();
+
+  //! Sharing can be switched off to measure its effect, see qucs-bench.
+  static void setEnabled(bool on) { Enabled = on; }
+  static bool enabled() { return Enabled; }
+
+private:
+  static bool Enabled;
+  static QMutex Mutex;
+  static QHash<QByteArray, QWeakPointer<const SymbolGeometry> > Symbols;
+  static int Instances;
+  static qint64 PrivateBytes;
+};
+
+#endif // SYMBOLCACHE_H
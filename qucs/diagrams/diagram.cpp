@@ -47,6 +47,7 @@
 
 #include "rect3ddiagram.h"
 #include "misc.h"
+#include "linetokenizer.h"
 
 #include <QTextStream>
 #include <QMessageBox>
@@ -1278,123 +1279,123 @@ QString Diagram::save() {
 // ------------------------------------------------------------
 bool Diagram::load(const QString &Line, QTextStream *stream) {
     bool ok;
-    QString s = Line;
 
-    if (s.at(0) != '<') return false;
-    if (s.at(s.length() - 1) != '>') return false;
-    s = s.mid(1, s.length() - 2);   // cut off start and end character
+    if (Line.at(0) != '<') return false;
+    if (Line.at(Line.length() - 1) != '>') return false;
+    // cut off start and end character
+    LineTokenizer tok(Line, 1, Line.length() - 2);
 
     QString n;
-    n = s.section(' ', 1, 1);    // cx
+    n = tok.fieldView(1);    // cx
     cx = n.toInt(&ok);
     if (!ok) return false;
 
-    n = s.section(' ', 2, 2);    // cy
+    n = tok.fieldView(2);    // cy
     cy = n.toInt(&ok);
     if (!ok) return false;
 
-    n = s.section(' ', 3, 3);    // x2
+    n = tok.fieldView(3);    // x2
     x2 = n.toInt(&ok);
     if (!ok) return false;
 
-    n = s.section(' ', 4, 4);    // y2
+    n = tok.fieldView(4);    // y2
     y2 = n.toInt(&ok);
     if (!ok) return false;
 
     char c;
-    n = s.section(' ', 5, 5);    // GridOn
+    n = tok.fieldView(5);    // GridOn
     c = n.at(0).toLatin1() - '0';
     xAxis.GridOn = yAxis.GridOn = (c & 1) != 0;
     hideLines = (c & 2) != 0;
 
-    n = s.section(' ', 6, 6);    // color for GridPen
+    n = tok.fieldView(6);    // color for GridPen
     QColor co;
     co.setNamedColor(n);
     GridPen.setColor(co);
     if (!GridPen.color().isValid()) return false;
 
-    n = s.section(' ', 7, 7);    // line style
+    n = tok.fieldView(7);    // line style
     GridPen.setStyle((Qt::PenStyle) n.toInt(&ok));
     if (!ok) return false;
 
-    n = s.section(' ', 8, 8);    // xlog, ylog
+    n = tok.fieldView(8);    // xlog, ylog
     xAxis.log = n.at(0) != '0';
     c = n.at(1).toLatin1();
     yAxis.log = ((c - '0') & 1) == 1;
     zAxis.log = ((c - '0') & 2) == 2;
 
-    n = s.section(' ', 9, 9);   // xAxis.autoScale
+    n = tok.fieldView(9);   // xAxis.autoScale
     if (n.at(0) != '"') {      // backward compatible
         if (n == "1") xAxis.autoScale = true;
         else xAxis.autoScale = false;
 
-        n = s.section(' ', 10, 10);    // xAxis.limit_min
+        n = tok.fieldView(10);    // xAxis.limit_min
         xAxis.limit_min = n.toDouble(&ok);
         if (!ok) return false;
 
-        n = s.section(' ', 11, 11);  // xAxis.step
+        n = tok.fieldView(11);  // xAxis.step
         xAxis.step = n.toDouble(&ok);
         if (!ok) return false;
 
-        n = s.section(' ', 12, 12);  // xAxis.limit_max
+        n = tok.fieldView(12);  // xAxis.limit_max
         xAxis.limit_max = n.toDouble(&ok);
         if (!ok) return false;
 
-        n = s.section(' ', 13, 13);    // yAxis.autoScale
+        n = tok.fieldView(13);    // yAxis.autoScale
         if (n == "1") yAxis.autoScale = true;
         else yAxis.autoScale = false;
 
-        n = s.section(' ', 14, 14);    // yAxis.limit_min
+        n = tok.fieldView(14);    // yAxis.limit_min
         yAxis.limit_min = n.toDouble(&ok);
         if (!ok) return false;
 
-        n = s.section(' ', 15, 15);    // yAxis.step
+        n = tok.fieldView(15);    // yAxis.step
         yAxis.step = n.toDouble(&ok);
         if (!ok) return false;
 
-        n = s.section(' ', 16, 16);    // yAxis.limit_max
+        n = tok.fieldView(16);    // yAxis.limit_max
         yAxis.limit_max = n.toDouble(&ok);
         if (!ok) return false;
 
-        n = s.section(' ', 17, 17);    // zAxis.autoScale
+        n = tok.fieldView(17);    // zAxis.autoScale
         if (n == "1") zAxis.autoScale = true;
         else zAxis.autoScale = false;
 
-        n = s.section(' ', 18, 18);    // zAxis.limit_min
+        n = tok.fieldView(18);    // zAxis.limit_min
         zAxis.limit_min = n.toDouble(&ok);
         if (!ok) return false;
 
-        n = s.section(' ', 19, 19);    // zAxis.step
+        n = tok.fieldView(19);    // zAxis.step
         zAxis.step = n.toDouble(&ok);
         if (!ok) return false;
 
-        n = s.section(' ', 20, 20);    // zAxis.limit_max
+        n = tok.fieldView(20);    // zAxis.limit_max
         zAxis.limit_max = n.toDouble(&ok);
         if (!ok) return false;
 
-        n = s.section(' ', 21, 21); // rotX
+        n = tok.fieldView(21); // rotX
         if (n.at(0) != '"') {      // backward compatible
             rotX = n.toInt(&ok);
             if (!ok) return false;
 
-            n = s.section(' ', 22, 22); // rotY
+            n = tok.fieldView(22); // rotY
             rotY = n.toInt(&ok);
             if (!ok) return false;
 
-            n = s.section(' ', 23, 23); // rotZ
+            n = tok.fieldView(23); // rotZ
             rotZ = n.toInt(&ok);
             if (!ok) return false;
 
-            n = s.section(' ', 24, 24);
+            n = tok.fieldView(24);
             if (n.at(0) != '"') {
                 if (n == "1") engineeringNotation = true;
                 else engineeringNotation = false;
-                n = s.section(' ', 25, 25);
+                n = tok.fieldView(25);
                 if (n.at(0) != '"') {
                     yAxis.Units = n.toInt(&ok);
                     if (!ok) return false;
 
-                    n = s.section(' ', 26, 26);
+                    n = tok.fieldView(26);
                     zAxis.Units = n.toInt(&ok);
                     if (!ok) return false;
                 }
@@ -1402,10 +1403,11 @@ bool Diagram::load(const QString &Line, QTextStream *stream) {
         }
     }
 
-    xAxis.Label = s.section('"', 1, 1);   // xLabel
-    yAxis.Label = s.section('"', 3, 3);   // yLabel left
-    zAxis.Label = s.section('"', 5, 5);   // yLabel right
+    xAxis.Label = tok.section(1);   // xLabel
+    yAxis.Label = tok.section(3);   // yLabel left
+    zAxis.Label = tok.section(5);   // yLabel right
 
+    QString s;
     Graph *pg;
     // .......................................................
     // load graphs of the diagram
@@ -15,6 +15,7 @@
  *                                                                         *
  ***************************************************************************/
 #include "graph.h"
+#include "linetokenizer.h"
 
 #include <cstdlib>
 #include <iostream>
@@ -113,38 +114,38 @@ QString Graph::save()
 bool Graph::load(const QString& _s)
 {
   bool ok;
-  QString s = _s;
 
-  if(s.at(0) != '<') return false;
-  if(s.at(s.length()-1) != '>') return false;
-  s = s.mid(1, s.length()-2);   // cut off start and end character
+  if(_s.at(0) != '<') return false;
+  if(_s.at(_s.length()-1) != '>') return false;
+  // cut off start and end character
+  LineTokenizer s(_s, 1, _s.length()-2);
 
-  Var = s.section('"',1,1);  // Var
+  Var = s.section(1);  // Var
 
   QString n;
-  n  = s.section(' ',1,1);    // Color
+  n  = s.fieldView(1);    // Color
   Color.setNamedColor(n);
   if(!Color.isValid()) return false;
 
-  n  = s.section(' ',2,2);    // Thick
+  n  = s.fieldView(2);    // Thick
   Thick = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',3,3);    // Precision
+  n  = s.fieldView(3);    // Precision
   Precision = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',4,4);    // numMode
+  n  = s.fieldView(4);    // numMode
   numMode = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',5,5);    // Style
+  n  = s.fieldView(5);    // Style
   int st = n.toInt(&ok);
   if(!ok) return false;
   Style = toGraphStyle(st);
   if(Style==GRAPHSTYLE_INVALID) return false;
 
-  n  = s.section(' ',6,6);    // yAxisNo
+  n  = s.fieldView(6);    // yAxisNo
   if(n.isEmpty()) return true;   // backward compatible
   yAxisNo = n.toInt(&ok);
   if(!ok) return false;
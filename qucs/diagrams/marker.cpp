@@ -35,6 +35,7 @@
 #include <stdlib.h>
 
 #include "misc.h"
+#include "linetokenizer.h"
 
 static double default_Z0=50;
 
@@ -485,16 +486,16 @@ QString Marker::save()
 bool Marker::load(const QString& Line)
 {
   bool ok;
-  QString s = Line;
 
-  if(s.at(0) != '<') return false;
-  if(s.at(s.length()-1) != '>') return false;
-  s = s.mid(1, s.length()-2);   // cut off start and end character
+  if(Line.at(0) != '<') return false;
+  if(Line.at(Line.length()-1) != '>') return false;
+  // cut off start and end character
+  LineTokenizer s(Line, 1, Line.length()-2);
 
-  if(s.section(' ',0,0) != "Mkr") return false;
+  if(s.fieldView(0) != "Mkr") return false;
 
   int i=0, j;
-  QString n = s.section(' ',1,1);    // VarPos
+  QString n = s.fieldView(1);    // VarPos
 
   unsigned nVarPos = 0;
   j = (n.count('/') + 3);
@@ -507,23 +508,23 @@ bool Marker::load(const QString& Line)
     i = j+1;
   } while(j >= 0);
 
-  n  = s.section(' ',2,2);    // x1
+  n  = s.fieldView(2);    // x1
   x1 = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',3,3);    // y1
+  n  = s.fieldView(3);    // y1
   y1 = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',4,4);      // Precision
+  n  = s.fieldView(4);      // Precision
   Precision = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',5,5);      // numMode
+  n  = s.fieldView(5);      // numMode
   numMode = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',6,6);      // transparent
+  n  = s.fieldView(6);      // transparent
   if(n.isEmpty()) return true;  // is optional
   if(n == "0")  transparent = false;
   else  transparent = true;
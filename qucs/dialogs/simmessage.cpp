@@ -36,6 +36,7 @@
 #include <QProgressBar>
 #include <QDebug>
 #include <QMessageBox>
+#include <QHash>
 
 #include "simmessage.h"
 #include "main.h"
@@ -43,6 +44,8 @@
 #include "qucs.h"
 #include "textdoc.h"
 #include "schematic.h"
+#include "simresultcache.h"
+#include "simlog.h"
 #include "components/opt_sim.h"
 #include "components/vhdlfile.h"
 #include "misc.h"
@@ -93,6 +96,15 @@ SimMessage::SimMessage(QWidget *w, QWidget *parent)
   ProgText->setReadOnly(true);
   //ProgText->setWordWrapMode(QTextOption::NoWrap);
   ProgText->setMinimumSize(400,80);
+  Log = new SimLog(this);  // the view is updated once per frame
+  // one log per document, simulations may run side by side; it is
+  // removed when the dialog closes
+  Log->setFileName(QucsSettings.QucsHomeDir.filePath(
+      QString("simulator.%1.%2.log").arg(Info.completeBaseName().isEmpty() ?
+                                         QString("untitled") : Info.completeBaseName())
+                                    .arg(qHash(DocName),8,16,QChar('0'))));
+  Log->setView(ProgText);
+  connect(this, SIGNAL(finished(int)), this, SLOT(slotRemoveLog()));
   wasLF = false;
   simKilled = false;
 
@@ -143,14 +155,26 @@ SimMessage::SimMessage(QWidget *w, QWidget *parent)
 SimMessage::~SimMessage()
 {
   if(SimProcess.state()==QProcess::Running)  SimProcess.kill();
+  slotRemoveLog();
   delete all;
 }
 
+// ------------------------------------------------------------------------
+// Is called when the dialog closes. The log file is deleted and output
+// arriving later is kept in memory only.
+void SimMessage::slotRemoveLog()
+{
+  if(Log->fileName().isEmpty())  return;
+  Log->clear();
+  Log->setFileName(QString());
+}
+
 // ------------------------------------------------------------------------
 bool SimMessage::startProcess()
 {
   Abort->setText(tr("Abort simulation"));
   Display->setDisabled(true);
+  Log->clear();
 
   QString txt = tr("Starting new simulation on %1 at %2").
     arg(QDate::currentDate().toString("ddd dd. MMM yyyy")).
@@ -359,7 +383,9 @@ void SimMessage::startSimulator()
   QString QucsVeri = "qucsveri";
 #endif
   SimOpt = NULL;
+  ResultKey.clear();
   bool isVerilog = false;
+  bool isVerilogA = false;
   QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
 
   // Simulate text window.
@@ -505,6 +531,7 @@ void SimMessage::startSimulator()
           }
 
           if (! usedComponents.isEmpty()) {
+            isVerilogA = true;
 
 
             /// \todo remove the command line arguments? use only netlist annotation?
@@ -546,6 +573,20 @@ void SimMessage::startSimulator()
         Arguments << "-b" << "-g" << "-i"
                   << QucsSettings.QucsHomeDir.filePath("netlist.txt")
                   << "-o" << DataSet;
+
+        // Verilog-A modules are loaded from compiled libraries, which
+        // are not part of the key
+        if (!isVerilogA) {
+          ResultKey = SimResultCache::key(
+              QStringList(QucsSettings.QucsHomeDir.filePath("netlist.txt")),
+              Program, "-b -g", QString());
+          if (SimResultCache::fetch(ResultKey, DataSet)) {
+            ResultKey.clear();
+            ProgText->appendPlainText(tr("Circuit not changed, using cached simulation results."));
+            FinishSimulation(0);
+            return;
+          }
+        }
       }
     }
     else {
@@ -654,7 +695,7 @@ void SimMessage::slotDisplayMsg()
       wasLF = true;
       QString tmps = ProgressText.left(i).trimmed();
       if (!tmps.isEmpty()) // avoid adding a newline if no text to show
-	ProgText->appendPlainText(tmps);
+	Log->append(tmps + "\n");
       ProgressText.remove(0, i+1);
       return;
     }
@@ -662,7 +703,7 @@ void SimMessage::slotDisplayMsg()
 
   QString tmps = ProgressText.trimmed();
   if (!tmps.isEmpty()) // avoid adding a newline if no text to show
-    ProgText->appendPlainText(tmps);
+    Log->append(tmps + "\n");
   ProgressText = "";
   wasLF = false;
 }
@@ -774,6 +815,7 @@ void SimMessage::slotSimEnded(int exitCode, QProcess::ExitStatus exitStatus )
  */
 void SimMessage::FinishSimulation(int Status)
 {
+  Log->flush();  // the output goes before the final messages
   Abort->setText(tr("Close window"));
   Display->setDisabled(false);
   SimProgress->setValue(100);  // progress bar to 100%
@@ -807,6 +849,10 @@ void SimMessage::FinishSimulation(int Status)
     file.close();
   }
 
+  if(Status == 0 && !simKilled && !ResultKey.isEmpty())
+    SimResultCache::store(ResultKey, DataSet);
+  ResultKey.clear();
+
   if(Status == 0) {
     if(SimOpt) { // save optimization data
       QFile ifile(QucsSettings.QucsHomeDir.filePath("asco_out.dat"));
@@ -34,6 +34,7 @@ class QProcess;
 class QFile;
 class Component;
 class Schematic;
+class SimLog;
 
 // #define SPEEDUP_PROGRESSBAR
 
@@ -64,6 +65,7 @@ private slots:
 
   void slotReadSpiceNetlist();
   void slotFinishSpiceNetlist(int status);
+  void slotRemoveLog();
 
 /* #ifdef SPEEDUP_PROGRESSBAR
   void slotUpdateProgressBar();
@@ -93,6 +95,8 @@ public:
   QPushButton    *Display, *Abort;
   QProgressBar   *SimProgress;
   QString        ProgressText;
+  SimLog         *Log;     // simulator output, the whole of it in simulator.<doc>.log
+                           // while the dialog is open
 
   Component      *SimOpt;
   int            SimPorts;
@@ -104,6 +108,7 @@ public:
   QVBoxLayout  *all;
 protected:
   QString Program;
+  QString ResultKey;  // key of the simulation in the result cache
 };
 
 #endif
@@ -17,6 +17,44 @@
 
 #include "element.h"
 
+#include <QMutex>
+#include <QSet>
+
+static QMutex InternMutex;
+static QSet<QString> InternPool;
+static int InternPruneAt = 4096;
+static bool Interning = true;
+
+// ---------------------------------------------------------------------
+// Property names, descriptions and default values are created anew by
+// every component constructor (often by QObject::tr()), so without the
+// pool each instance carries its own copy of the same texts. Strings
+// held by the pool alone are dropped whenever its size has doubled.
+QString qucs::intern(const QString &s)
+{
+  if(s.isEmpty())  return s;   // keeps an empty string apart from a null one
+  QMutexLocker locker(&InternMutex);
+  if(!Interning)  return s;
+  QSet<QString>::const_iterator it = InternPool.constFind(s);
+  if(it != InternPool.constEnd())  return *it;
+
+  if(InternPool.size() >= InternPruneAt) {
+    for(QSet<QString>::iterator p = InternPool.begin(); p != InternPool.end(); ) {
+      if(p->isDetached())  p = InternPool.erase(p);   // no element uses it
+      else  ++p;
+    }
+    InternPruneAt = qMax(4096, 2 * InternPool.size());
+  }
+  InternPool.insert(s);
+  return s;
+}
+
+void qucs::setInterning(bool on)
+{
+  QMutexLocker locker(&InternMutex);
+  Interning = on;
+}
+
 Element::Element()
 {
   Type = isDummyElement;
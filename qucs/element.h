@@ -72,6 +72,14 @@ struct Area {
   QBrush Brush;    // filling style/color
 };
 
+// Returns the pooled copy of a string, so equal texts held by many
+// elements (property names, descriptions, models) share one buffer.
+// Called when components are loaded or placed, see
+// Component::internStrings(). setInterning(false) makes it return the
+// string unchanged, to measure the effect (qucs-bench).
+QString intern(const QString &s);
+void setInterning(bool on);
+
 }
 
 struct Port {
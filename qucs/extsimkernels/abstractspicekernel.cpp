@@ -25,12 +25,15 @@
 #include "abstractspicekernel.h"
 #include "misc.h"
 #include "main.h"
+#include "simresultcache.h"
 #include "../paintings/id_text.h"
 #include "dialogs/sweepdialog.h"
 
 
 #include <QPlainTextEdit>
+#include <QTimer>
 #include <algorithm>
+#include <cmath>
 
 /*!
   \file abstractspicekernel.cpp
@@ -51,6 +54,7 @@ AbstractSpiceKernel::AbstractSpiceKernel(Schematic *sch_, QObject *parent) :
 
     if (Sch->showBias == 0) DC_OP_only = true;
     else DC_OP_only = false;
+    ResultCached = false;
 
     workdir = QucsSettings.S4Qworkdir;
     QFileInfo inf(workdir);
@@ -66,6 +70,9 @@ AbstractSpiceKernel::AbstractSpiceKernel(Schematic *sch_, QObject *parent) :
     connect(SimProcess,SIGNAL(errorOccurred(QProcess::ProcessError)),this,SLOT(slotErrors(QProcess::ProcessError)));
     connect(this,SIGNAL(destroyed()),this,SLOT(killThemAll()));
 
+    Log = new SimLog(this);
+    Log->setFileName(workdir+QDir::separator()+"spice4qucs.sim.log");
+    SimFailed = false;
 }
 
 
@@ -76,6 +83,7 @@ AbstractSpiceKernel::~AbstractSpiceKernel()
 
 void AbstractSpiceKernel::killThemAll()
 {
+    ResultKey.clear(); // an aborted simulation is not cached
     if (SimProcess->state()!=QProcess::NotRunning) {
         SimProcess->kill();
     }
@@ -291,6 +299,31 @@ void AbstractSpiceKernel::createSubNetlsit(QTextStream &stream, bool lib)
     stream<<".ENDS\n";
 }
 
+/*!
+ * \brief AbstractSpiceKernel::useCachedResult Look up the simulation in the
+ *        result cache. Called by slotSimulate() when all input files of
+ *        the simulator are written. On a hit the simulation is reported as
+ *        finished from the event loop and convertToQucsData() restores the
+ *        cached dataset. On a miss the dataset is added to the cache after the
+ *        conversion, unless the simulation failed or reported errors.
+ * \param files Netlists and other files read by the simulator
+ * \return True if the result is cached and no simulator has to be started
+ */
+bool AbstractSpiceKernel::useCachedResult(const QStringList &files)
+{
+    ResultCached = false;
+    ResultKey.clear();
+    if (DC_OP_only) return false; // bias is shown on the schematic, there is no dataset
+
+    ResultKey = SimResultCache::key(files,simulator_cmd,simulator_parameters,workdir);
+    if (!SimResultCache::contains(ResultKey)) return false;
+
+    ResultCached = true;
+    // slotSimulate() may be called before the caller connected to finished()
+    QTimer::singleShot(0,this,SLOT(slotCachedResult()));
+    return true;
+}
+
 /*!
  * \brief AbstractSpiceKernel::slotSimulate Executes simulator
  */
@@ -1035,6 +1068,118 @@ int AbstractSpiceKernel::checkRawOutupt(QString ngspice_file, QStringList &value
     return filetype;
 }
 
+/*!
+ * \brief AbstractSpiceKernel::parseOutputFile Extract the simulation points of
+ *        a simulator output file. The parser is chosen by the file name and
+ *        content.
+ * \param dir Directory holding the output file and the sweep .res files
+ * \param ngspice_output_filename Output file name, one of output_files
+ * \param[out] sim_points 2D array of the simulation points
+ * \param[out] var_list Spice variable names, the independent variable first
+ * \param[out] isComplex True if the variables are complex
+ * \param[out] hasParSweep, hasDblParSweep Output contains one or two parameter sweeps
+ * \param[out] swp_var, swp_var_val, swp_var2, swp_var2_val Names and values of
+ *        the swept parameters
+ */
+void AbstractSpiceKernel::parseOutputFile(const QString &dir, const QString &ngspice_output_filename,
+                                          QList< QList<double> > &sim_points, QStringList &var_list,
+                                          bool &isComplex, bool &hasParSweep, bool &hasDblParSweep,
+                                          QString &swp_var, QStringList &swp_var_val,
+                                          QString &swp_var2, QStringList &swp_var2_val)
+{
+    QRegularExpression four_rx(".*\\.four[0-9]+$");
+    QString full_outfile = dir+QDir::separator()+ngspice_output_filename;
+    if (ngspice_output_filename.endsWith("HB.FD.prn")) {
+        //parseHBOutput(full_outfile,sim_points,var_list,hasParSweep);
+        //isComplex = true;
+        parseXYCESTDOutput(full_outfile,sim_points,var_list,isComplex,hasParSweep);
+        if (hasParSweep) {
+            QString res_file = QDir::toNativeSeparators(dir + QDir::separator()
+                                                    + "spice4qucs.hb.cir.res");
+            parseResFile(res_file,swp_var,swp_var_val);
+        }
+    } else if (ngspice_output_filename.endsWith(".four") ||
+               four_rx.match(ngspice_output_filename).hasMatch()) {
+        isComplex=false;
+        parseFourierOutput(full_outfile,sim_points,var_list);
+    } else if (ngspice_output_filename.endsWith(".ngspice.sens.dc.prn")) {
+        isComplex = false;
+        parseSENSOutput(full_outfile,sim_points,var_list);
+    } else if (ngspice_output_filename.endsWith(".txt_std")) {
+        parseXYCESTDOutput(full_outfile,sim_points,var_list,isComplex,hasParSweep);
+    } else if (ngspice_output_filename.endsWith(".noise_log")) {
+        isComplex = false;
+        parseXYCENoiseLog(full_outfile,sim_points,var_list);
+    } else if (ngspice_output_filename.endsWith(".noise")) {
+        isComplex = false;
+        parseNoiseOutput(full_outfile,sim_points,var_list,hasParSweep);
+        if (hasParSweep) {
+            QString res_file = QDir::toNativeSeparators(dir + QDir::separator()
+                                                    + "spice4qucs.noise.cir.res");
+            parseResFile(res_file,swp_var,swp_var_val);
+        }
+    } else if (ngspice_output_filename.endsWith(".pz")) {
+        isComplex = true;
+        parsePZOutput(full_outfile,sim_points,var_list,hasParSweep);
+        if (hasParSweep) {
+            QString res_file = QDir::toNativeSeparators(dir + QDir::separator()
+                                                    + "spice4qucs.pz.cir.res");
+            parseResFile(res_file,swp_var,swp_var_val);
+        }
+    } else if (ngspice_output_filename.endsWith(".SENS.prn")) {
+        QStringList vals;
+        int type = checkRawOutupt(full_outfile,vals);
+        parseXYCESTDOutput(full_outfile,sim_points,var_list,isComplex,hasParSweep);
+        if (type == xyceSTDswp) {
+            hasParSweep = true;
+            QString res_file = QDir::toNativeSeparators(dir + QDir::separator()
+                                                    + "spice4qucs.sens.cir.res");
+            parseResFile(res_file,swp_var,swp_var_val);
+        }
+    } else if (ngspice_output_filename.endsWith("_swp.txt")) {
+        hasParSweep = true;
+        QString simstr = full_outfile;
+        simstr.remove("_swp.txt");
+        if (ngspice_output_filename.endsWith("_swp_swp.txt")) { // 2-var parameter sweep
+            hasDblParSweep = true;
+            simstr.chop(4);
+            simstr = simstr.split('_').last();
+            QString res2_file = QDir::toNativeSeparators(dir + QDir::separator()
+                                                        + "spice4qucs." + simstr + ".cir.res1");
+            parseResFile(res2_file,swp_var2,swp_var2_val);
+        } else {
+            simstr = simstr.split('_').last();
+        }
+
+        QString res_file = QDir::toNativeSeparators(dir + QDir::separator()
+                                                + "spice4qucs." + simstr + ".cir.res");
+        parseResFile(res_file,swp_var,swp_var_val);
+
+        parseSTEPOutput(full_outfile,sim_points,var_list,isComplex);
+    } else {
+        int OutType = checkRawOutupt(full_outfile,swp_var_val);
+        bool hasSwp = false;
+        switch (OutType) {
+        case spiceRawSwp:
+            hasParSweep = true;
+            swp_var = "Number";
+            parseSTEPOutput(full_outfile,sim_points,var_list,isComplex);
+            break;
+        case spiceRaw:
+            parseNgSpiceSimOutput(full_outfile,sim_points,var_list,isComplex);
+            break;
+        case xyceSTD:
+            parseXYCESTDOutput(full_outfile,sim_points,var_list,isComplex,hasSwp);
+            break;
+        case xyceSTDswp:
+            hasParSweep = true;
+            swp_var = "Number";
+            parseXYCESTDOutput(full_outfile,sim_points,var_list,isComplex,hasSwp);
+        default: break;
+        }
+    }
+}
+
 /*!
  * \brief AbstractSpiceKernel::convertToQucsData Put data extracted from spice raw
  *        text output files (given in outputs_files property) into single XML
@@ -1056,6 +1201,8 @@ void AbstractSpiceKernel::convertToQucsData(const QString &qucs_dataset)
         return;
     }
 
+    if (ResultCached && SimResultCache::fetch(ResultKey,qucs_dataset)) return;
+
     // Merge all outputs in a single Qucs dataset otherwise
     QString ds_str;
     QTextStream ds_stream(&ds_str);
@@ -1074,97 +1221,8 @@ void AbstractSpiceKernel::convertToQucsData(const QString &qucs_dataset)
         bool hasParSweep = false;
         bool hasDblParSweep = false;
 
-        QRegularExpression four_rx(".*\\.four[0-9]+$");
-        QString full_outfile = workdir+QDir::separator()+ngspice_output_filename;
-        if (ngspice_output_filename.endsWith("HB.FD.prn")) {
-            //parseHBOutput(full_outfile,sim_points,var_list,hasParSweep);
-            //isComplex = true;
-            parseXYCESTDOutput(full_outfile,sim_points,var_list,isComplex,hasParSweep);
-            if (hasParSweep) {
-                QString res_file = QDir::toNativeSeparators(workdir + QDir::separator()
-                                                        + "spice4qucs.hb.cir.res");
-                parseResFile(res_file,swp_var,swp_var_val);
-            }
-        } else if (ngspice_output_filename.endsWith(".four") ||
-                   four_rx.match(ngspice_output_filename).hasMatch()) {
-            isComplex=false;
-            parseFourierOutput(full_outfile,sim_points,var_list);
-        } else if (ngspice_output_filename.endsWith(".ngspice.sens.dc.prn")) {
-            isComplex = false;
-            parseSENSOutput(full_outfile,sim_points,var_list);
-        } else if (ngspice_output_filename.endsWith(".txt_std")) {
-            parseXYCESTDOutput(full_outfile,sim_points,var_list,isComplex,hasParSweep);
-        } else if (ngspice_output_filename.endsWith(".noise_log")) {
-            isComplex = false;
-            parseXYCENoiseLog(full_outfile,sim_points,var_list);
-        } else if (ngspice_output_filename.endsWith(".noise")) {
-            isComplex = false;
-            parseNoiseOutput(full_outfile,sim_points,var_list,hasParSweep);
-            if (hasParSweep) {
-                QString res_file = QDir::toNativeSeparators(workdir + QDir::separator()
-                                                        + "spice4qucs.noise.cir.res");
-                parseResFile(res_file,swp_var,swp_var_val);
-            }
-        } else if (ngspice_output_filename.endsWith(".pz")) {
-            isComplex = true;
-            parsePZOutput(full_outfile,sim_points,var_list,hasParSweep);
-            if (hasParSweep) {
-                QString res_file = QDir::toNativeSeparators(workdir + QDir::separator()
-                                                        + "spice4qucs.pz.cir.res");
-                parseResFile(res_file,swp_var,swp_var_val);
-            }
-        } else if (ngspice_output_filename.endsWith(".SENS.prn")) {
-            QStringList vals;
-            int type = checkRawOutupt(full_outfile,vals);
-            parseXYCESTDOutput(full_outfile,sim_points,var_list,isComplex,hasParSweep);
-            if (type == xyceSTDswp) {
-                hasParSweep = true;
-                QString res_file = QDir::toNativeSeparators(workdir + QDir::separator()
-                                                        + "spice4qucs.sens.cir.res");
-                parseResFile(res_file,swp_var,swp_var_val);
-            }
-        } else if (ngspice_output_filename.endsWith("_swp.txt")) {
-            hasParSweep = true;
-            QString simstr = full_outfile;
-            simstr.remove("_swp.txt");
-            if (ngspice_output_filename.endsWith("_swp_swp.txt")) { // 2-var parameter sweep
-                hasDblParSweep = true;
-                simstr.chop(4);
-                simstr = simstr.split('_').last();
-                QString res2_file = QDir::toNativeSeparators(workdir + QDir::separator()
-                                                            + "spice4qucs." + simstr + ".cir.res1");
-                parseResFile(res2_file,swp_var2,swp_var2_val);
-            } else {
-                simstr = simstr.split('_').last();
-            }
-
-            QString res_file = QDir::toNativeSeparators(workdir + QDir::separator()
-                                                    + "spice4qucs." + simstr + ".cir.res");
-            parseResFile(res_file,swp_var,swp_var_val);
-
-            parseSTEPOutput(full_outfile,sim_points,var_list,isComplex);
-        } else {
-            int OutType = checkRawOutupt(full_outfile,swp_var_val);
-            bool hasSwp = false;
-            switch (OutType) {
-            case spiceRawSwp:
-                hasParSweep = true;
-                swp_var = "Number";
-                parseSTEPOutput(full_outfile,sim_points,var_list,isComplex);
-                break;
-            case spiceRaw:
-                parseNgSpiceSimOutput(full_outfile,sim_points,var_list,isComplex);
-                break;
-            case xyceSTD:
-                parseXYCESTDOutput(full_outfile,sim_points,var_list,isComplex,hasSwp);
-                break;
-            case xyceSTDswp:
-                hasParSweep = true;
-                swp_var = "Number";
-                parseXYCESTDOutput(full_outfile,sim_points,var_list,isComplex,hasSwp);
-            default: break;
-            }
-        }
+        parseOutputFile(workdir,ngspice_output_filename,sim_points,var_list,isComplex,
+                        hasParSweep,hasDblParSweep,swp_var,swp_var_val,swp_var2,swp_var2_val);
         if (var_list.isEmpty()) continue; // nothing to convert
         normalizeVarsNames(var_list);
 
@@ -1236,12 +1294,90 @@ void AbstractSpiceKernel::convertToQucsData(const QString &qucs_dataset)
         QTextStream ts(&dataset);
         ts<<ds_str;
         dataset.close();
+        if (!hasErrors())
+            SimResultCache::store(ResultKey,qucs_dataset);
     }
 #ifdef NDEBUG
     removeAllSimulatorOutputs();
 #endif
 }
 
+/*!
+ * \brief AbstractSpiceKernel::readSimOutputs Read the outputs of a finished
+ *        simulation into memory, without creating a Qucs dataset. Used by
+ *        the optimizer to evaluate its goals.
+ * \param dir Directory holding the output files given by output_files
+ * \param[out] results Points of every variable by its Qucs dataset name.
+ *        Complex values are given as magnitude, the points of all parameter
+ *        sweep steps follow each other.
+ */
+void AbstractSpiceKernel::readSimOutputs(const QString &dir, QHash<QString, QVector<double> > &results)
+{
+    results.clear();
+    for (const QString& ngspice_output_filename : output_files) {
+        QList< QList<double> > sim_points;
+        QStringList var_list;
+        QString swp_var,swp_var2;
+        QStringList swp_var_val,swp_var2_val;
+        bool isComplex = false;
+        bool hasParSweep = false;
+        bool hasDblParSweep = false;
+
+        parseOutputFile(dir,ngspice_output_filename,sim_points,var_list,isComplex,
+                        hasParSweep,hasDblParSweep,swp_var,swp_var_val,swp_var2,swp_var2_val);
+        if (var_list.isEmpty()) continue;
+        normalizeVarsNames(var_list);
+
+        for (int i=0;i<var_list.count();i++) {
+            if (var_list.at(i).isEmpty()) continue;
+            QVector<double> &values = results[var_list.at(i)];
+            values.clear();
+            values.reserve(sim_points.count());
+            for (const auto& sim_point : sim_points) {
+                if (i == 0) values.append(sim_point.value(0));
+                else if (isComplex) values.append(std::hypot(sim_point.value(2*(i-1)+1),
+                                                             sim_point.value(2*i)));
+                else values.append(sim_point.value(i));
+            }
+        }
+    }
+}
+
+/*!
+ * \brief AbstractSpiceKernel::createNetlists Create the netlists of the
+ *        schematic without starting the simulator, e.g. to run them with
+ *        different parameter values. Fills the list of output files.
+ *        Should be reimplemented for Ngspice and Xyce.
+ * \param[out] netlists Netlist text by file name, relative to the working
+ *        directory
+ * \return False if the schematic cannot be simulated, the reason is given
+ *         in the simulator output
+ */
+bool AbstractSpiceKernel::createNetlists(QMap<QString, QString> &netlists)
+{
+    netlists.clear();
+    return false;
+}
+
+/*!
+ * \brief AbstractSpiceKernel::simulatorCommand Command line that simulates
+ *        a netlist in the current directory.
+ * \param netlist Netlist file name
+ */
+QString AbstractSpiceKernel::simulatorCommand(const QString &netlist)
+{
+    return QString("\"%1\" %2 %3").arg(simulator_cmd,simulator_parameters,netlist);
+}
+
+/*!
+ * \brief AbstractSpiceKernel::simulatorEnvironment Environment the simulator
+ *        processes are started with.
+ */
+QProcessEnvironment AbstractSpiceKernel::simulatorEnvironment()
+{
+    return SimProcess->processEnvironment();
+}
+
 /*!
  * \brief AbstractSpiceKernel::removeAllSimulatorOutputs Clean temporary simulator
  *        datasets.
@@ -1325,6 +1461,8 @@ void AbstractSpiceKernel::normalizeVarsNames(QStringList &var_list)
  */
 void AbstractSpiceKernel::slotErrors(QProcess::ProcessError err)
 {
+    ResultKey.clear();
+    SimFailed = true;
     emit errors(err);
 }
 
@@ -1334,7 +1472,25 @@ void AbstractSpiceKernel::slotErrors(QProcess::ProcessError err)
 void AbstractSpiceKernel::slotFinished()
 {
     //output.clear();
-    output += SimProcess->readAllStandardOutput();
+    QString s = SimProcess->readAllStandardOutput();
+    Progress.scan(s);
+    appendOutput(s + Progress.remainder());
+    if (SimProcess->exitStatus() != QProcess::NormalExit || SimProcess->exitCode() != 0) {
+        ResultKey.clear();
+        SimFailed = true;
+    }
+    emit finished();
+    emit progress(100);
+}
+
+/*!
+ * \brief AbstractSpiceKernel::slotCachedResult Report a simulation served
+ *        from the result cache as finished.
+ */
+void AbstractSpiceKernel::slotCachedResult()
+{
+    emit started();
+    output += "Circuit not changed, using cached simulation results\n";
     emit finished();
     emit progress(100);
 }
@@ -1349,12 +1505,45 @@ void AbstractSpiceKernel::slotProcessOutput()
 
 /*!
  * \brief AbstractSpiceKernel::getOutput Get sdtout and stderr output of simulation
- *        process.
+ *        process, after the messages of Qucs.
  * \return Simulation process output
  */
 QString AbstractSpiceKernel::getOutput()
 {
-    return output;
+    return output + Log->text();
+}
+
+/*!
+ * \brief AbstractSpiceKernel::clearOutput Drop the messages and the
+ *        simulator output of the previous simulation.
+ */
+void AbstractSpiceKernel::clearOutput()
+{
+    output.clear();
+    Log->clear();
+    Progress.remainder();
+    SimFailed = false;
+}
+
+/*!
+ * \brief AbstractSpiceKernel::appendOutput Add simulator output. It is
+ *        written to spice4qucs.sim.log in the working directory, only its
+ *        tail is kept in memory.
+ */
+void AbstractSpiceKernel::appendOutput(const QString &text)
+{
+    Log->append(text);
+}
+
+/*!
+ * \brief AbstractSpiceKernel::hasErrors Whether the last simulation failed:
+ *        a simulator process crashed or returned an exit code, or an
+ *        error was reported in its output or in the messages of Qucs.
+ */
+bool AbstractSpiceKernel::hasErrors()
+{
+    return SimFailed || Log->hasErrors() ||
+           output.contains("error",Qt::CaseInsensitive);
 }
 
 /*!
@@ -1389,6 +1578,7 @@ void AbstractSpiceKernel::setWorkdir(QString path)
         QDir dir;
         dir.mkpath(workdir);
     }
+    Log->setFileName(workdir+QDir::separator()+"spice4qucs.sim.log");
 }
 
 /*!
@@ -1402,6 +1592,7 @@ void AbstractSpiceKernel::SaveNetlist(QString)
 
 bool AbstractSpiceKernel::waitEndOfSimulation()
 {
+    if (ResultCached) return true; // no simulator was started
     return SimProcess->waitForFinished(10000);
 }
 
@@ -21,6 +21,9 @@
 #define ABSTRACTSPICEKERNEL_H
 
 #include <QList>
+#include <QHash>
+#include <QMap>
+#include <QVector>
 #include <QString>
 #include <QStringList>
 #include <QDataStream>
@@ -28,6 +31,7 @@
 #include <QProcess>
 
 #include "schematic.h"
+#include "simlog.h"
 
 /*!
   \file abstractspicekernel.h
@@ -48,6 +52,11 @@ private:
 
     void normalizeVarsNames(QStringList &var_list);
     int checkRawOutupt(QString ngspice_file, QStringList &values);
+    void parseOutputFile(const QString &dir, const QString &ngspice_output_filename,
+                         QList< QList<double> > &sim_points, QStringList &var_list,
+                         bool &isComplex, bool &hasParSweep, bool &hasDblParSweep,
+                         QString &swp_var, QStringList &swp_var_val,
+                         QString &swp_var2, QStringList &swp_var2_val);
     void extractBinSamples(QDataStream &dbl, QList< QList<double> > &sim_points,
                            int NumPoints, int NumVars, bool isComplex);
     bool extractASCIISamples(QString &lin, QTextStream &ngsp_data, QList< QList<double> > &sim_points,
@@ -63,6 +72,13 @@ protected:
     bool DC_OP_only; // only calculate operating point to show DC bias
     Schematic *Sch;
 
+    QString ResultKey;  // key of the simulation in the result cache
+    bool ResultCached;  // dataset is taken from the result cache
+
+    SimLog *Log;                  // simulator output, see getOutput()
+    bool SimFailed;               // a simulator process failed or reported errors
+    SimProgressScanner Progress;  // progress reports of SimProcess
+
     bool prepareSpiceNetlist(QTextStream &stream, bool isSubckt = false);
     virtual void startNetlist(QTextStream& stream, bool xyce = false);
     virtual void createNetlist(QTextStream& stream, int NumPorts,QStringList& simulations,
@@ -71,6 +87,9 @@ protected:
     bool checkGround();
     bool checkSimulations();
     bool checkDCSimulation();
+    bool useCachedResult(const QStringList &files);
+    void clearOutput();
+    void appendOutput(const QString &text);
 
 public:
 
@@ -105,7 +124,13 @@ public:
                            QStringList &var_list);
     void parseResFile(QString resfile, QString &var, QStringList &values);
     void convertToQucsData(const QString &qucs_dataset);
+    void readSimOutputs(const QString &dir, QHash<QString, QVector<double> > &results);
     QString getOutput();
+    bool hasErrors();
+
+    virtual bool createNetlists(QMap<QString, QString> &netlists);
+    virtual QString simulatorCommand(const QString &netlist);
+    QProcessEnvironment simulatorEnvironment();
 
     virtual void setSimulatorCmd(QString cmd);
     virtual void setSimulatorParameters(QString parameters);
@@ -122,10 +147,11 @@ signals:
 protected slots:
     virtual void slotFinished();
     virtual void slotProcessOutput();
+    void slotCachedResult();
 
 public slots:
     virtual void slotSimulate();
-    void killThemAll();
+    virtual void killThemAll();
     void slotErrors(QProcess::ProcessError err);
     
 };
@@ -38,6 +38,7 @@ ExternSimDialog::ExternSimDialog(Schematic *sch,QWidget *parent) :
 
     ngspice = new Ngspice(sch,this);
     xyce = new Xyce(sch,this);
+    optimizer = nullptr;
 
 
     buttonSimulate = new QPushButton(tr("Simulate"),this);
@@ -65,6 +66,7 @@ ExternSimDialog::ExternSimDialog(Schematic *sch,QWidget *parent) :
     font.setPointSize(10);
     editSimConsole->setFont(font);
     editSimConsole->setReadOnly(true);
+    editSimConsole->setMaximumBlockCount(SimLog::MaxLines);
     vbl1->addWidget(editSimConsole);
     grp_1->setLayout(vbl1);
 
@@ -92,6 +94,7 @@ ExternSimDialog::ExternSimDialog(Schematic *sch,QWidget *parent) :
 ExternSimDialog::~ExternSimDialog()
 {
     ngspice->killThemAll();
+    if (optimizer != nullptr) optimizer->killThemAll();
 }
 
 void ExternSimDialog::slotSetSimulator()
@@ -147,6 +150,32 @@ void ExternSimDialog::slotSetSimulator()
         break;
     default: break;
     }
+
+    setOptimizer();
+}
+
+/*!
+ * \brief ExternSimDialog::setOptimizer If the schematic has an active
+ *        optimization component, the Simulate button starts the optimizer
+ *        instead of a single simulation. The DC bias is simulated as usual.
+ */
+void ExternSimDialog::setOptimizer()
+{
+    if ((Sch->showBias == 0) || (SpiceOptimizer::findOptimization(Sch) == nullptr)) return;
+
+    AbstractSpiceKernel *kernel = ngspice;
+    if ((QucsSettings.DefaultSimulator == spicecompat::simXyceSer) ||
+        (QucsSettings.DefaultSimulator == spicecompat::simXycePar)) kernel = xyce;
+
+    optimizer = new SpiceOptimizer(Sch,kernel,this);
+    disconnect(buttonSimulate,SIGNAL(clicked()),kernel,SLOT(slotSimulate()));
+    connect(optimizer,SIGNAL(started()),this,SLOT(slotNgspiceStarted()));
+    connect(optimizer,SIGNAL(finished()),this,SLOT(slotProcessOutput()));
+    connect(optimizer,SIGNAL(errors(QProcess::ProcessError)),this,SLOT(slotNgspiceStartError(QProcess::ProcessError)));
+    connect(optimizer,SIGNAL(progress(int)),simProgress,SLOT(setValue(int)));
+    connect(buttonSimulate,SIGNAL(clicked()),optimizer,SLOT(slotOptimize()));
+    connect(buttonStopSim,SIGNAL(clicked()),optimizer,SLOT(killThemAll()));
+    connect(buttonExit,SIGNAL(clicked()),optimizer,SLOT(killThemAll()));
 }
 
 
@@ -179,6 +208,8 @@ void ExternSimDialog::slotProcessOutput()
         break;
     }
 
+    if (optimizer != nullptr) out = optimizer->getOutput();
+
     if (out.contains("warning",Qt::CaseInsensitive)||
         out.contains("error",Qt::CaseInsensitive)) {
         emit warnings();
@@ -192,6 +223,8 @@ void ExternSimDialog::slotProcessOutput()
     QFileInfo inf(Sch->DocName);
     //QString qucs_dataset = inf.canonicalPath()+QDir::separator()+inf.baseName()+"_ngspice.dat";
     QString qucs_dataset = inf.canonicalPath()+QDir::separator()+inf.baseName()+ext;
+    // a stopped or failed optimization leaves no simulator outputs
+    if ((optimizer != nullptr) && !optimizer->hasResult()) return;
     switch (QucsSettings.DefaultSimulator) {
     case spicecompat::simNgspice:
     case spicecompat::simSpiceOpus:
@@ -23,6 +23,7 @@
 #include "schematic.h"
 #include "ngspice.h"
 #include "xyce.h"
+#include "spiceoptimizer.h"
 #include "spicecompat.h"
 
 class ExternSimDialog : public QDialog
@@ -45,6 +46,7 @@ private:
 
     Ngspice *ngspice;
     Xyce *xyce;
+    SpiceOptimizer *optimizer;
 
 public:
     explicit ExternSimDialog(Schematic *sch,QWidget *parent = 0);
@@ -54,6 +56,7 @@ public:
 
 private:
     void saveLog();
+    void setOptimizer();
     
 signals:
     void simulated();
@@ -26,11 +26,17 @@
 #include "spicecomponents/sp_spiceinit.h"
 #include "spicecomponents/xsp_cmlib.h"
 #include "main.h"
+#include "subcircuitcache.h"
 #include "misc.h"
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
+#include <QSet>
+#include <QThread>
+
+#include <algorithm>
+
 /*!
   \file ngspice.cpp
   \brief Implementation of the Ngspice class
@@ -50,6 +56,11 @@ Ngspice::Ngspice(Schematic *sch_, QObject *parent) :
         simulator_cmd = QFileInfo(QucsSettings.NgspiceExecutable).absoluteFilePath();
     }
     simulator_parameters = "";
+    Progress = SimProgressScanner("%",true);
+    ShardIndex = 0;
+    ShardCount = 1;
+    finishedShards = 0;
+    StartFailed = false;
 }
 
 /*!
@@ -113,16 +124,19 @@ void Ngspice::createNetlist(QTextStream &stream, int ,
 
     // set variable names for named nodes and wires
     vars.clear();
+    QSet<QString> known_vars;
     for(Node *pn = Sch->DocNodes.first(); pn != 0; pn = Sch->DocNodes.next()) {
       if(pn->Label != 0) {
-          if (!vars.contains(pn->Label->Name)) {
+          if (!known_vars.contains(pn->Label->Name)) {
+              known_vars.insert(pn->Label->Name);
               vars.append(pn->Label->Name);
           }
       }
     }
     for(Wire *pw = Sch->DocWires.first(); pw != 0; pw = Sch->DocWires.next()) {
       if(pw->Label != 0) {
-          if (!vars.contains(pw->Label->Name)) {
+          if (!known_vars.contains(pw->Label->Name)) {
+              known_vars.insert(pw->Label->Name);
               vars.append(pw->Label->Name);
           }
       }
@@ -130,16 +144,19 @@ void Ngspice::createNetlist(QTextStream &stream, int ,
     for(Component *pc = Sch->DocComps.first(); pc != 0; pc = Sch->DocComps.next()) {
         if (pc->isProbe) {
             QString var_pr = pc->getProbeVariable();
-            if (!vars.contains(var_pr)) {
+            if (!known_vars.contains(var_pr)) {
+                known_vars.insert(var_pr);
                 vars.append(var_pr);
             }
         }
     }
     vars.sort();
 
-    stream<<".control\n"          //execute simulations
-          <<"echo \"\" > spice4qucs.cir.noise\n"
-          <<"echo \"\" > spice4qucs.cir.pz\n";
+    stream<<".control\n";         //execute simulations
+    if (ShardIndex == 0) { // other shards only append swept results
+        stream<<"echo \"\" > spice4qucs.cir.noise\n"
+              <<"echo \"\" > spice4qucs.cir.pz\n";
+    }
 
     bool load_osdi = false;
     for(Component *pc = Sch->DocComps.first(); pc != 0; pc = Sch->DocComps.next()) {
@@ -165,6 +182,14 @@ void Ngspice::createNetlist(QTextStream &stream, int ,
         bool hasDblSWP = false;
         QString cnt_var;
 
+        // Sharded netlist: only a part of the outer sweep is simulated
+        Param_Sweep *shard_swp = nullptr;
+        if (ShardCount > 1) {
+            shard_swp = findOuterSweep(sim);
+            if (shard_swp == nullptr && ShardIndex > 0) continue; // first shard only
+            if (shard_swp != nullptr) shard_swp->setShard(ShardIndex,ShardCount);
+        }
+
         // Duplicate .PARAM in .control section. They may be used in euqations
         for(Component *pc = Sch->DocComps.first(); pc != 0; pc = Sch->DocComps.next()) {
             if (pc->Model=="Eqn") {
@@ -179,46 +204,13 @@ void Ngspice::createNetlist(QTextStream &stream, int ,
             Component *pc = Sch->DocComps.at(i);
             QString sim_typ = pc->Model;
             if (!pc->isActive) continue;
-            if (sim_typ==".SW") {
-                QString SwpSim = pc->Props.at(0)->Value;
+            if ((sim_typ==".SW")||(sim_typ==".MC")) {
                 QString s = pc->getNgspiceBeforeSim(sim);
                 cnt_var = ((Param_Sweep *)pc)->getCounterVar();
-                if (SwpSim.startsWith("AC")&&(sim=="ac")) {
+                if (sweepsSimulation(pc,sim)) {
                     QString s2 = getParentSWPscript(pc,sim,true,hasDblSWP);
                     stream<<(s2+s);
                     hasParSWP = true;
-                } else if (SwpSim.startsWith("SP")&&(sim=="sp")) {
-                    QString s2 = getParentSWPscript(pc,sim,true,hasDblSWP);
-                    stream<<(s2+s);
-                    hasParSWP = true;
-                } else if (SwpSim.startsWith("DISTO")&&(sim=="disto")) {
-                    QString s2 = getParentSWPscript(pc,sim,true,hasDblSWP);
-                    stream<<(s2+s);
-                    hasParSWP = true;
-                } else if (SwpSim.startsWith("NOISE")&&(sim=="noise")) {
-                    QString s2 = getParentSWPscript(pc,sim,true,hasDblSWP);
-                    stream<<(s2+s);
-                    hasParSWP = true;
-                } else if (SwpSim.startsWith("PZ")&&(sim=="pz")) {
-                    QString s2 = getParentSWPscript(pc,sim,true,hasDblSWP);
-                    stream<<(s2+s);
-                    hasParSWP = true;
-                } else if (SwpSim.startsWith("FFT")&&(sim=="fft")) {
-                    QString s2 = getParentSWPscript(pc,sim,true,hasDblSWP);
-                    stream<<(s2+s);
-                    hasParSWP = true;
-                } if (SwpSim.startsWith("TR")&&(sim=="tran")) {
-                    QString s2 = getParentSWPscript(pc,sim,true,hasDblSWP);
-                    stream<<(s2+s);
-                    hasParSWP = true;
-                } else if (SwpSim.startsWith("SW")&&(sim=="dc")) {
-                    for(Component *pc1 = Sch->DocComps.first(); pc1 != 0; pc1 = Sch->DocComps.next()) {
-                        if ((pc1->Name==SwpSim)&&(pc1->Props.at(0)->Value.startsWith("DC"))) {
-                            QString s2 = getParentSWPscript(pc,sim,true,hasDblSWP);
-                            stream<<(s2+s);
-                            hasParSWP = true;
-                        }
-                    }
                 }
             }
         }
@@ -361,50 +353,33 @@ void Ngspice::createNetlist(QTextStream &stream, int ,
             QString write_str = QString("write %1 %2\n").arg(filename).arg(nods);
             stream<<write_str;
             outputs.append(filename);
+            if (shard_swp != nullptr) appendedOutputs.insert(filename);
+        }
+
+        if (shard_swp != nullptr) { // written once per sweep point
+            if (sim=="noise") appendedOutputs.insert("spice4qucs.cir.noise");
+            if (sim=="pz") appendedOutputs.insert("spice4qucs.cir.pz");
+            if (hasDblSWP) appendedOutputs.insert(QString("spice4qucs.%1.cir.res1").arg(sim));
+            else appendedOutputs.insert(QString("spice4qucs.%1.cir.res").arg(sim));
         }
 
 
         for(Component *pc = Sch->DocComps.first(); pc != 0; pc = Sch->DocComps.next()) {
             QString sim_typ = pc->Model;
             if (!pc->isActive) continue;
-            if (sim_typ==".SW") {
-                QString s = pc->getNgspiceAfterSim(sim);
-                QString SwpSim = pc->Props.at(0)->Value;
+            if ((sim_typ==".SW")||(sim_typ==".MC")) {
                 bool b; // value drain
-                if (SwpSim.startsWith("AC")&&(sim=="ac")) {
-                    s += getParentSWPscript(pc,sim,false,b);
-                    stream<<s;
-                } else if (SwpSim.startsWith("SP")&&(sim=="sp")) {
-                    s += getParentSWPscript(pc,sim,false,b);
-                    stream<<s;
-                } else if (SwpSim.startsWith("DISTO")&&(sim=="disto")) {
-                    s += getParentSWPscript(pc,sim,false,b);
-                    stream<<s;
-                } else if (SwpSim.startsWith("NOISE")&&(sim=="noise")) {
-                    s += getParentSWPscript(pc,sim,false,b);
-                    stream<<s;
-                } else if (SwpSim.startsWith("PZ")&&(sim=="pz")) {
-                    s += getParentSWPscript(pc,sim,false,b);
-                    stream<<s;
-                } else if (SwpSim.startsWith("FFT")&&(sim=="fft")) {
-                    s += getParentSWPscript(pc,sim,false,b);
-                    stream<<s;
-                } else if (SwpSim.startsWith("TR")&&(sim=="tran")) {
+                if (sweepsSimulation(pc,sim)) {
+                    QString s = pc->getNgspiceAfterSim(sim);
                     s += getParentSWPscript(pc,sim,false,b);
                     stream<<s;
-                } else if (SwpSim.startsWith("SW")&&(sim=="dc")) {
-                    for(Component *pc1 = Sch->DocComps.first(); pc1 != 0; pc1 = Sch->DocComps.next()) {
-                        if ((pc1->Name==SwpSim)&&(pc1->Props.at(0)->Value.startsWith("DC"))) {
-                             s += getParentSWPscript(pc,sim,false,b);
-                             stream<<s;
-                        }
-                    }
-               }
+                }
             }
         }
 
         stream<<"destroy all\n";
         stream<<"reset\n\n";
+        if (shard_swp != nullptr) shard_swp->setShard(0,1);
     }
 
     stream<<"exit\n"
@@ -429,7 +404,7 @@ QString Ngspice::getParentSWPscript(Component *pc_swp, QString sim, bool before,
     if (Comps.count()>0) {
         for (unsigned int i=0;i<Comps.count();i++) {
             Component *pc2 = Comps.at(i);
-            if (pc2->Model.startsWith(".SW")) {
+            if (pc2->Model.startsWith(".SW")||(pc2->Model==".MC")) {
                 if (pc2->Props.at(0)->Value==swp) {
                     if (before) {
                         hasDblSwp = true;
@@ -445,66 +420,157 @@ QString Ngspice::getParentSWPscript(Component *pc_swp, QString sim, bool before,
     return QString("");
 }
 
+/*!
+ * \brief Ngspice::sweepsSimulation Check whether a parameter sweep loop
+ *        encloses the simulation.
+ * \param pc_swp Parameter sweep component
+ * \param sim Simulation type (ac, tran, dc, ...)
+ * \return true if the sweep steps the simulation
+ */
+bool Ngspice::sweepsSimulation(Component *pc_swp, const QString &sim)
+{
+    QString SwpSim = pc_swp->Props.at(0)->Value;
+    if (SwpSim.startsWith("AC")) return (sim=="ac");
+    if (SwpSim.startsWith("SP")) return (sim=="sp");
+    if (SwpSim.startsWith("DISTO")) return (sim=="disto");
+    if (SwpSim.startsWith("NOISE")) return (sim=="noise");
+    if (SwpSim.startsWith("PZ")) return (sim=="pz");
+    if (SwpSim.startsWith("FFT")) return (sim=="fft");
+    if (SwpSim.startsWith("TR")) return (sim=="tran");
+    if (SwpSim.startsWith("SW")&&(sim=="dc")) { // sweep of a DC sweep
+        Q3PtrList<Component> Comps(Sch->DocComps);
+        for(Component *pc1 = Comps.first(); pc1 != 0; pc1 = Comps.next()) {
+            if ((pc1->Name==SwpSim)&&(pc1->Props.at(0)->Value.startsWith("DC")))
+                return true;
+        }
+    }
+    return false;
+}
+
+/*!
+ * \brief Ngspice::findOuterSweep Find the outermost parameter sweep loop of
+ *        a simulation. This is the parent sweep of a double sweep, see
+ *        getParentSWPscript().
+ * \param sim Simulation type (ac, tran, dc, ...)
+ * \return Sweep component or nullptr if the simulation is not swept
+ */
+Param_Sweep *Ngspice::findOuterSweep(const QString &sim)
+{
+    Q3PtrList<Component> Comps(Sch->DocComps);
+    for(Component *pc = Comps.first(); pc != 0; pc = Comps.next()) {
+        if ((pc->isActive != COMP_IS_ACTIVE) || ((pc->Model!=".SW")&&(pc->Model!=".MC"))) continue;
+        if (!sweepsSimulation(pc,sim)) continue;
+        if (!pc->Name.startsWith("DC")) {
+            Q3PtrList<Component> Comps2(Sch->DocComps);
+            for(Component *pc2 = Comps2.first(); pc2 != 0; pc2 = Comps2.next()) {
+                // an inactive parent writes no loop, see getNgspiceBeforeSim()
+                if (pc2->isActive != COMP_IS_ACTIVE) continue;
+                if ((pc2->Model.startsWith(".SW")||(pc2->Model==".MC"))&&
+                    (pc2->Props.at(0)->Value==pc->Name))
+                    return (Param_Sweep *)pc2;
+            }
+        }
+        return (Param_Sweep *)pc;
+    }
+    return nullptr;
+}
+
 /*!
  * \brief Ngspice::slotSimulate Create netlist and execute Ngspice simulator. Netlist
  *        is saved at $HOME/.qucs/spice4qucs/spice4qucs.cir
  */
 void Ngspice::slotSimulate()
 {
-    output.clear();
+    clearOutput();
 
     QString mathf_inc; // drain
     if (!findMathFuncInc(mathf_inc)) {
         output.append("[Warning!] " + mathf_inc + " file not found!\n");
     }
 
+    if (!checkNetlist()) {
+        emit finished();
+        emit errors(QProcess::FailedToStart);
+        return;
+    }
+
+    QString netfile = "spice4qucs.cir";
+    QString tmp_path = QDir::toNativeSeparators(workdir+QDir::separator()+netfile);
+    SaveNetlist(tmp_path);
+
+    removeAllSimulatorOutputs();
+    prepareCodeModels();
+
+    QStringList inputs;
+    inputs<<tmp_path<<workdir+"/.spiceinit"<<workdir+"/qucs_cmlib/qucs_xspice.cm";
+    if (useCachedResult(inputs)) return;
+
+    int shards = shardLimit();
+    if (shards > 1) { // run parts of the outer sweeps concurrently
+        emit started();
+        startShards(shards);
+        return;
+    }
+
+    //startNgSpice(tmp_path);
+    SimProcess->setWorkingDirectory(workdir);
+    qDebug()<<workdir;
+    QString cmd = simulatorCommand(netfile);
+    QStringList cmd_args = misc::parseCmdArgs(cmd);
+    QString ngsp_cmd = cmd_args.at(0);
+    cmd_args.removeAt(0);
+    SimProcess->start(ngsp_cmd,cmd_args);
+    emit started();
+}
+
+/*!
+ * \brief Ngspice::checkNetlist Check if the schematic can be simulated
+ *        with Ngspice. The reason is appended to the simulator output.
+ * \return True if a netlist can be created
+ */
+bool Ngspice::checkNetlist()
+{
     QStringList incompat;
     if (!checkSchematic(incompat)) {
         QString s = incompat.join("; ");
         output.append("There were SPICE-incompatible components. Simulator cannot proceed.");
         output.append("Incompatible components are: " + s + "\n");
-        emit finished();
-        emit errors(QProcess::FailedToStart);
-        return;
+        return false;
     }
 
     if (!checkGround()) {
         output.append("No Ground found. Please add at least one ground!\n");
-        emit finished();
-        emit errors(QProcess::FailedToStart);
-        return;
+        return false;
     }
 
     if (!checkSimulations()) {
         output.append("No simulation found. Please add at least one simulation!\n");
-        emit finished();
-        emit errors(QProcess::FailedToStart);
-        return;
+        return false;
     }
 
     if (!checkDCSimulation()) {
         output.append("Only DC simulation found in the schematic. It has no effect!"
                       " Add TRAN, AC, or Sweep simulation to proceed.\n");
-        emit finished();
-        emit errors(QProcess::FailedToStart);
-        return;
+        return false;
     }
 
     if (!checkNodeNames(incompat)) {
         QString s = incompat.join("; ");
         output.append("There were Nutmeg-incompatible node names. Simulator cannot proceed.\n");
         output.append("Incompatible node names are: " + s + "\n");
-        emit finished();
-        emit errors(QProcess::FailedToStart);
-        return;
+        return false;
     }
 
-    QString netfile = "spice4qucs.cir";
-    QString tmp_path = QDir::toNativeSeparators(workdir+QDir::separator()+netfile);
-    SaveNetlist(tmp_path);
-
-    removeAllSimulatorOutputs();
+    return true;
+}
 
+/*!
+ * \brief Ngspice::prepareCodeModels Write the .spiceinit file into the
+ *        working directory and compile the XSPICE code models used by
+ *        the schematic.
+ */
+void Ngspice::prepareCodeModels()
+{
     XSPICE_CMbuilder *CMbuilder = new XSPICE_CMbuilder(Sch);
     CMbuilder->cleanSpiceinit();
     CMbuilder->createSpiceinit(/*initial_spiceinit=*/collectSpiceinit(Sch));
@@ -514,16 +580,317 @@ void Ngspice::slotSimulate()
         CMbuilder->compileCMlib(output);
     }
     delete CMbuilder;
+}
 
-    //startNgSpice(tmp_path);
-    SimProcess->setWorkingDirectory(workdir);
-    qDebug()<<workdir;
-    QString cmd = QString("\"%1\" %2 %3").arg(simulator_cmd,simulator_parameters,netfile);
+/*!
+ * \brief Ngspice::createNetlists Create the netlist without starting
+ *        Ngspice. The outer parameter sweeps are not split.
+ * \param[out] netlists The netlist text named spice4qucs.cir
+ * \return False if the schematic cannot be simulated
+ */
+bool Ngspice::createNetlists(QMap<QString, QString> &netlists)
+{
+    netlists.clear();
+    clearOutput();
+    if (!checkNetlist()) return false;
+
+    sims.clear();
+    vars.clear();
+    QString text;
+    QTextStream stream(&text);
+    createNetlist(stream,0,sims,vars,output_files);
+    stream.flush();
+    netlists.insert("spice4qucs.cir",text);
+
+    prepareCodeModels();
+    return true;
+}
+
+/*!
+ * \brief Ngspice::shardLimit Number of Ngspice processes the outer
+ *        parameter sweeps are split into. Every process gets at least one
+ *        sweep point. The NgspiceShards setting selects the number, 0 means
+ *        one process per core and 1 keeps the single process, also for
+ *        Monte Carlo runs. Without parameter sweeps a single process is used.
+ */
+int Ngspice::shardLimit()
+{
+    if (DC_OP_only) return 1;
+
+    int limit = QucsSettings.NgspiceShards;
+    if (limit == 0) limit = QThread::idealThreadCount();
+    if (limit <= 1) return 1;
+
+    bool swept = false;
+    for (const QString &sim : sims) {
+        Param_Sweep *pc = findOuterSweep(sim);
+        if (pc == nullptr) continue;
+        swept = true;
+        limit = std::min(limit, (int) pc->getSweepValues().count());
+    }
+    if (!swept) return 1;
+    return std::max(1, limit);
+}
+
+// ---------------------------------------------------------------------
+QString Ngspice::shardDir(int index)
+{
+    return workdir + QDir::separator() + QString("shard%1").arg(index);
+}
+
+/*!
+ * \brief Ngspice::startShards Write one netlist per part of the outer
+ *        sweeps into its own directory and start all of them. The output
+ *        file names are the same in every directory, so the netlists
+ *        differ only in the sweep values.
+ * \param count Number of shards
+ */
+void Ngspice::startShards(int count)
+{
+    Shards.clear();
+    qDeleteAll(shardLogs);
+    shardLogs.clear();
+    appendedOutputs.clear();
+    finishedShards = 0;
+    StartFailed = false;
+    output += QString("Outer parameter sweep split into %1 Ngspice processes\n").arg(count);
+
+    QString spiceinit = workdir + QDir::separator() + ".spiceinit";
+    for (int k = 0; k < count; k++) {
+        QString dir = shardDir(k);
+        QDir(dir).removeRecursively();
+        QDir().mkpath(dir);
+        if (QFile::exists(spiceinit)) // Ngspice reads it from the working directory
+            QFile::copy(spiceinit, dir + QDir::separator() + ".spiceinit");
+
+        QFile spice_file(dir + QDir::separator() + "spice4qucs.cir");
+        if (spice_file.open(QFile::WriteOnly)) {
+            QStringList shard_sims, shard_vars, shard_outputs;
+            QTextStream stream(&spice_file);
+            ShardIndex = k;
+            ShardCount = count;
+            createNetlist(stream,0,shard_sims,shard_vars,shard_outputs);
+            ShardIndex = 0;
+            ShardCount = 1;
+            spice_file.close();
+        }
+        SimLog *log = new SimLog(this);
+        log->setFileName(workdir + QDir::separator() + QString("spice4qucs.shard%1.log").arg(k));
+        log->clear();
+        shardLogs.append(log);
+    }
+
+    for (int k = 0; k < count; k++) {
+        NgspiceShard shard;
+        shard.index = k;
+        shard.percent = 0;
+        shard.progress = SimProgressScanner("%",true);
+        shard.process = new QProcess(this);
+        shard.process->setProcessChannelMode(QProcess::MergedChannels);
+        shard.process->setProcessEnvironment(SimProcess->processEnvironment());
+        shard.process->setWorkingDirectory(shardDir(k));
+        connect(shard.process,SIGNAL(finished(int)),this,SLOT(slotShardFinished()));
+        connect(shard.process,SIGNAL(readyRead()),this,SLOT(slotShardOutput()));
+        connect(shard.process,SIGNAL(errorOccurred(QProcess::ProcessError)),
+                this,SLOT(slotShardError(QProcess::ProcessError)));
+        Shards.append(shard);
+    }
+
+    QString cmd = simulatorCommand("spice4qucs.cir");
     QStringList cmd_args = misc::parseCmdArgs(cmd);
     QString ngsp_cmd = cmd_args.at(0);
     cmd_args.removeAt(0);
-    SimProcess->start(ngsp_cmd,cmd_args);
-    emit started();
+    QList<NgspiceShard> shards = Shards;
+    for (const NgspiceShard &shard : shards) {
+        if (StartFailed) break;
+        shard.process->start(ngsp_cmd,cmd_args);
+    }
+}
+
+/*!
+ * \brief Ngspice::slotShardFinished Shard process finished handler.
+ */
+void Ngspice::slotShardFinished()
+{
+    finishShard(qobject_cast<QProcess*>(sender()));
+}
+
+/*!
+ * \brief Ngspice::slotShardOutput Collect the output of a shard process
+ *        and report the progress of all shards.
+ */
+void Ngspice::slotShardOutput()
+{
+    QProcess *process = qobject_cast<QProcess*>(sender());
+    int j = findShard(process);
+    if (j < 0) return;
+
+    QString s = process->readAllStandardOutput();
+    int percent = Shards[j].progress.scan(s);
+    if (percent >= 0) {
+        Shards[j].percent = percent;
+        reportProgress();
+    }
+    shardLogs.at(Shards.at(j).index)->append(s);
+}
+
+/*!
+ * \brief Ngspice::slotShardError Shard process error handler. If Ngspice
+ *        cannot be started, the other shards are stopped as they would
+ *        fail the same way.
+ */
+void Ngspice::slotShardError(QProcess::ProcessError err)
+{
+    QProcess *process = qobject_cast<QProcess*>(sender());
+    ResultKey.clear();
+    SimFailed = true;
+    emit errors(err);
+    if (err != QProcess::FailedToStart) return;  // finished() follows
+
+    StartFailed = true;
+    int j = findShard(process);
+    if (j >= 0) {
+        Shards.removeAt(j);
+        process->deleteLater();
+    }
+    killThemAll();
+}
+
+/*!
+ * \brief Ngspice::killThemAll Stop the simulator and all shard processes.
+ */
+void Ngspice::killThemAll()
+{
+    QList<NgspiceShard> shards = Shards;
+    for (const NgspiceShard &shard : shards) {
+        if (shard.process->state() != QProcess::NotRunning)
+            shard.process->kill();
+    }
+    AbstractSpiceKernel::killThemAll();
+}
+
+bool Ngspice::waitEndOfSimulation()
+{
+    if (Shards.isEmpty()) return AbstractSpiceKernel::waitEndOfSimulation();
+    while (!Shards.isEmpty()) {
+        QProcess *process = Shards.first().process;
+        if (!process->waitForFinished(-1) && findShard(process) >= 0)
+            finishShard(process);  // already finished, event not delivered yet
+    }
+    return !StartFailed;
+}
+
+// ---------------------------------------------------------------------
+int Ngspice::findShard(QProcess *process)
+{
+    for (int j = 0; j < Shards.count(); j++)
+        if (Shards.at(j).process == process) return j;
+    return -1;
+}
+
+// ---------------------------------------------------------------------
+void Ngspice::finishShard(QProcess *process)
+{
+    int j = findShard(process);
+    if (j < 0) return;
+    NgspiceShard shard = Shards.takeAt(j);
+    QString s = process->readAllStandardOutput();
+    shard.progress.scan(s);
+    SimLog *log = shardLogs.at(shard.index);
+    log->append(s + shard.progress.remainder());
+    if (log->hasErrors()) SimFailed = true;  // the beginning may be dropped below
+    if ((process->exitStatus() != QProcess::NormalExit) || (process->exitCode() != 0)) {
+        ResultKey.clear();  // a failed shard leaves a hole in the merged sweep
+        SimFailed = true;
+    }
+    process->deleteLater();
+    finishedShards++;
+
+    if (!Shards.isEmpty()) {
+        reportProgress();
+        return;
+    }
+
+    for (SimLog *log : shardLogs)  // the whole outputs stay in the shard logs
+        appendOutput(log->text());
+    if (StartFailed) return;  // errors() was emitted already
+    mergeShardOutputs();
+    emit finished();
+    emit progress(100);
+}
+
+/*!
+ * \brief Ngspice::mergeShardOutputs Combine the shard outputs in the
+ *        working directory, as if one Ngspice process had run the whole
+ *        sweep. Results written once per sweep point are concatenated in
+ *        shard order, the sweep point numbers of the .res files are
+ *        counted on. Other files are taken from the last shard which has
+ *        them: the results of unswept simulations from the first shard,
+ *        the ones overwritten at each sweep point from the last.
+ */
+void Ngspice::mergeShardOutputs()
+{
+    int count = shardLogs.count();
+    QStringList files = output_files;
+    QStringList res_filter("spice4qucs.*.cir.res*");
+    for (int k = 0; k < count; k++)
+        files += QDir(shardDir(k)).entryList(res_filter,QDir::Files);
+    files.removeDuplicates();
+
+    QRegularExpression point_pattern("^\\s*[0-9]+\\s+(.*)$");
+    for (const QString &file : files) {
+        QString target = workdir + QDir::separator() + file;
+        QFile::remove(target);
+
+        if (!appendedOutputs.contains(file)) {
+            for (int k = count-1; k >= 0; k--) {
+                QString src = shardDir(k) + QDir::separator() + file;
+                if (QFile::exists(src)) {
+                    QFile::copy(src,target);
+                    break;
+                }
+            }
+            continue;
+        }
+
+        QFile ofile(target);
+        if (!ofile.open(QIODevice::WriteOnly)) continue;
+        bool resfile = file.contains(".cir.res");
+        int point = 0;
+        for (int k = 0; k < count; k++) {
+            QFile ifile(shardDir(k) + QDir::separator() + file);
+            if (!ifile.open(QIODevice::ReadOnly)) continue;
+            if (!resfile) {
+                ofile.write(ifile.readAll());
+            } else { // STEP header from the first shard, numbered points
+                QTextStream in(&ifile);
+                QTextStream out(&ofile);
+                while (!in.atEnd()) {
+                    QString lin = in.readLine();
+                    QRegularExpressionMatch m = point_pattern.match(lin);
+                    if (m.hasMatch()) out<<point++<<" "<<m.captured(1)<<"\n";
+                    else if (k == 0) out<<lin<<"\n";
+                }
+            }
+            ifile.close();
+        }
+        ofile.close();
+    }
+
+    for (int k = 0; k < count; k++)
+        QDir(shardDir(k)).removeRecursively();
+}
+
+// ---------------------------------------------------------------------
+// Progress of all shards, finished ones count as 100 percent.
+void Ngspice::reportProgress()
+{
+    int count = shardLogs.count();
+    if (count <= 0) return;
+    int sum = finishedShards * 100;
+    for (const NgspiceShard &shard : Shards)
+        sum += shard.percent;
+    emit progress(sum / count);
 }
 
 /*!
@@ -565,14 +932,9 @@ QString Ngspice::collectSpiceinit(Schematic* sch)
         if (pc->Model == "SPICEINIT") {
             collected_spiceinit += ((SpiceSpiceinit*)pc)->getSpiceinit();
         } else if (pc->Model == "Sub") {
-            Schematic *sub = new Schematic(0, ((Subcircuit *)pc)->getSubcircuitFile());
-            if(!sub->loadDocument())      // load document if possible
-            {
-                delete sub;
-                continue;
-            }
+            Schematic *sub = SubcircuitCache::document(((Subcircuit *)pc)->getSubcircuitFile());
+            if(!sub) continue;      // load document if possible
             collected_spiceinit += collectSpiceinit(sub);
-            delete sub;
 	}
     }
     return collected_spiceinit.join("");
@@ -601,16 +963,11 @@ bool Ngspice::findMathFuncInc(QString &mathf_inc)
 void Ngspice::slotProcessOutput()
 {
     QString s = SimProcess->readAllStandardOutput();
-    QRegularExpression percentage_pattern("^%\\d\\d*\\.\\d\\d.*$");
-    if (percentage_pattern.match(s).hasMatch()) {
-        int percent = round(s.mid(1,5).toFloat());
-        emit progress(percent);
-    } else {
-        s.remove(QRegularExpression("%\\d\\d*\\.\\d\\d")); // Remove percentage from logs
-        s.remove(QRegularExpression("\010+")); // Large amount of datar from percentage reports
-                                    // can freeze QTextEdit for over 100k simulation points
-        output += s;
-    }
+    // Percentage reports are removed from the logs, a large amount of them
+    // can freeze QTextEdit for over 100k simulation points
+    int percent = Progress.scan(s);
+    if (percent >= 0) emit progress(percent);
+    appendOutput(s);
 }
 
 /*!
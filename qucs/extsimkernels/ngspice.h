@@ -22,9 +22,12 @@
 #include <QString>
 #include <QStringList>
 #include <QDataStream>
+#include <QSet>
 #include "schematic.h"
 #include "abstractspicekernel.h"
 
+class Param_Sweep;
+
 /*!
   \file ngspice.h
   \brief Declaration of the Ngspice class
@@ -37,28 +40,61 @@ class Ngspice : public AbstractSpiceKernel
 {
     Q_OBJECT
 private:
+    //! One Ngspice process running a part of the outer parameter sweeps
+    struct NgspiceShard {
+        QProcess *process;
+        int index;       //!< part of the sweeps, see Param_Sweep::setShard()
+        int percent;     //!< progress reported by Ngspice
+        SimProgressScanner progress;
+    };
+
+    int ShardIndex;   // part of the outer sweeps createNetlist() writes
+    int ShardCount;
+    QList<NgspiceShard> Shards;      // running shards
+    QList<SimLog*> shardLogs;        // simulator output per shard
+    QSet<QString> appendedOutputs;   // shard output files to concatenate
+    int finishedShards;
+    bool StartFailed;
 
     bool checkNodeNames(QStringList &incompat);
     static QString collectSpiceinit(Schematic *sch);
     bool findMathFuncInc(QString &mathf_inc);
     QString getParentSWPscript(Component *pc_swp, QString sim, bool before, bool &hasDblSWP);
     QString getParentSWPCntVar(Component *pc_swp, QString sim);
+    bool sweepsSimulation(Component *pc_swp, const QString &sim);
+    Param_Sweep *findOuterSweep(const QString &sim);
+
+    int shardLimit();
+    QString shardDir(int index);
+    void startShards(int count);
+    int findShard(QProcess *process);
+    void finishShard(QProcess *process);
+    void mergeShardOutputs();
+    void reportProgress();
 
 public:
     explicit Ngspice(Schematic *sch_, QObject *parent = 0);
     void SaveNetlist(QString filename);
+    bool createNetlists(QMap<QString, QString> &netlists);
     void setSimulatorCmd(QString cmd);
     void setSimulatorParameters(QString parameters);
-    
+    bool waitEndOfSimulation();
+
 protected:
     void createNetlist(QTextStream &stream, int NumPorts, QStringList &simulations,
                        QStringList &vars, QStringList &outputs);
+    bool checkNetlist();
+    void prepareCodeModels();
 
 public slots:
     void slotSimulate();
+    void killThemAll();
 
 protected slots:
     void slotProcessOutput();
+    void slotShardFinished();
+    void slotShardOutput();
+    void slotShardError(QProcess::ProcessError err);
 };
 
 #endif // NGSPICE_H
@@ -0,0 +1,528 @@
+/***************************************************************************
+                             ngspicesession.cpp
+                            --------------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "ngspicesession.h"
+#include "schematic.h"
+#include "misc.h"
+#include "main.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QTimer>
+
+/*!
+  \file ngspicesession.cpp
+  \brief Implementation of the NgspiceSession class
+*/
+
+// echoed by Ngspice after the last analysis of a run
+#define END_MARKER "qucs_tuning_step done"
+
+/*!
+ * \brief NgspiceSession::NgspiceSession Class constructor. The session
+ *        follows the edits of the schematic until it is deleted. It works
+ *        in its own subdirectory of the simulator working directory, so
+ *        other sessions and simulations do not touch its files.
+ * \param sch_ Schematic to tune
+ * \param parent Parent object
+ */
+NgspiceSession::NgspiceSession(Schematic *sch_, QObject *parent) :
+    Ngspice(sch_, parent)
+{
+    Session = nullptr;
+    Running = false;
+    Pending = false;
+    static int sessions = 0;
+    setWorkdir(workdir + QDir::separator() + QString("tune%1").arg(++sessions));
+    QDir(workdir).removeRecursively();  // left over from a crash
+    QDir().mkpath(workdir);
+    Log->setFileName(workdir + QDir::separator() + "spice4qucs.tune.log");
+    connect(sch_,SIGNAL(signalEdited()),this,SLOT(slotUpdate()));
+}
+
+NgspiceSession::~NgspiceSession()
+{
+    killThemAll();
+    Log->setFileName(QString());  // closes the log
+    QDir(workdir).removeRecursively();
+}
+
+/*!
+ * \brief NgspiceSession::killThemAll Stop the Ngspice process.
+ */
+void NgspiceSession::killThemAll()
+{
+    Running = false;
+    Pending = false;
+    if (Session != nullptr) {
+        Session->disconnect(this);
+        if (Session->state() != QProcess::NotRunning) {
+            Session->kill();
+            Session->waitForFinished(1000);
+        }
+        Session->deleteLater();
+        Session = nullptr;
+    }
+    loadedCircuit.clear();
+    Ngspice::killThemAll();
+}
+
+/*!
+ * \brief NgspiceSession::datasetName The Qucs dataset the results are
+ *        written to, the same as for a simulation with Ngspice.
+ */
+QString NgspiceSession::datasetName()
+{
+    QFileInfo inf(Sch->DocName);
+    return inf.canonicalPath() + QDir::separator() + inf.baseName() + ".dat.ngspice";
+}
+
+/*!
+ * \brief NgspiceSession::slotStart Start Ngspice, load the circuit and
+ *        run the analyses of the schematic.
+ */
+void NgspiceSession::slotStart()
+{
+    killThemAll();
+    clearOutput();
+
+    QString circuit;
+    QStringList script, osdi;
+    if (!createDeck(circuit,script,osdi)) {
+        emit finished();
+        emit errors(QProcess::FailedToStart);
+        return;
+    }
+    lastCircuit = circuit;
+    lastScript = script;
+    osdiFiles = osdi;
+
+    startSession();
+    if (Session == nullptr) return;
+    loadCircuit(circuit);
+    run(script,QStringList());
+}
+
+/*!
+ * \brief NgspiceSession::slotUpdate The schematic was edited. Apply the
+ *        changed values to the loaded circuit, or reload the circuit if
+ *        the changes cannot be expressed with alter commands, and run the
+ *        analyses again. An edit during a run is handled after the run.
+ */
+void NgspiceSession::slotUpdate()
+{
+    if (Running) {
+        Pending = true;
+        return;
+    }
+    clearOutput();
+
+    QString circuit;
+    QStringList script, osdi;
+    if (!createDeck(circuit,script,osdi)) {
+        emit finished();
+        emit errors(QProcess::FailedToStart);
+        return;
+    }
+    // e.g. a diagram or a marker was edited
+    if ((Session != nullptr) && (circuit == lastCircuit) && (script == lastScript)) return;
+    lastCircuit = circuit;
+    lastScript = script;
+
+    QStringList tuning;
+    if ((Session == nullptr) || (osdi != osdiFiles)) {
+        osdiFiles = osdi;
+        startSession();
+        if (Session == nullptr) return;
+        loadCircuit(circuit);
+    } else if (!diffCircuit(loadedCircuit,circuit,appliedParams,tuning)) {
+        tuning.clear();
+        prepareCodeModels();
+        if (readSpiceinit() != spiceinit) {  // code models are loaded at start
+            startSession();
+            if (Session == nullptr) return;
+        }
+        loadCircuit(circuit);
+    }
+    run(script,tuning);
+}
+
+/*!
+ * \brief NgspiceSession::createDeck Create the netlist and split it into
+ *        the circuit and the commands of the control section.
+ * \param[out] circuit Netlist without the control section
+ * \param[out] script Analyses and output commands
+ * \param[out] osdi OSDI libraries to load
+ * \return False if the schematic cannot be simulated
+ */
+bool NgspiceSession::createDeck(QString &circuit, QStringList &script, QStringList &osdi)
+{
+    circuit.clear();
+    script.clear();
+    osdi.clear();
+    if (!checkNetlist()) return false;
+
+    sims.clear();
+    vars.clear();
+    QString text;
+    QTextStream stream(&text);
+    createNetlist(stream,0,sims,vars,output_files);
+    stream.flush();
+
+    bool control = false;
+    const QStringList lines = text.split('\n');
+    for (const QString &line : lines) {
+        QString cmd = line.trimmed();
+        if (cmd.compare(".control",Qt::CaseInsensitive) == 0) {
+            control = true;
+        } else if (cmd.compare(".endc",Qt::CaseInsensitive) == 0) {
+            control = false;
+        } else if (!control) {
+            circuit += line + "\n";
+        } else if (cmd.startsWith("pre_osdi")) {
+            osdi.append(cmd.mid(8).trimmed());
+        } else if ((cmd != "exit") && (cmd != "quit")) {
+            script.append(line);
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief NgspiceSession::startSession Start Ngspice in pipe mode in the
+ *        working directory and load the OSDI libraries. A running session
+ *        is stopped first.
+ */
+void NgspiceSession::startSession()
+{
+    if (Session != nullptr) {
+        Session->disconnect(this);
+        Session->kill();
+        Session->waitForFinished(1000);
+        Session->deleteLater();
+        Session = nullptr;
+    }
+    loadedCircuit.clear();
+
+    prepareCodeModels();
+    spiceinit = readSpiceinit();
+    QFile init(workdir + QDir::separator() + ".spiceinit");
+    if (spiceinit.isEmpty()) {  // Ngspice reads it from the working directory
+        init.remove();
+    } else if (init.open(QFile::WriteOnly)) {
+        init.write(spiceinit.toUtf8());
+        init.close();
+    }
+
+    Session = new QProcess(this);
+    Session->setProcessChannelMode(QProcess::MergedChannels);
+    Session->setProcessEnvironment(simulatorEnvironment());
+    Session->setWorkingDirectory(workdir);
+    connect(Session,SIGNAL(readyRead()),this,SLOT(slotSessionOutput()));
+    connect(Session,SIGNAL(finished(int,QProcess::ExitStatus)),
+            this,SLOT(slotSessionFinished(int,QProcess::ExitStatus)));
+    connect(Session,SIGNAL(errorOccurred(QProcess::ProcessError)),
+            this,SLOT(slotSessionError(QProcess::ProcessError)));
+
+    QStringList cmd_args = misc::parseCmdArgs(
+                QString("\"%1\" %2 -p").arg(simulator_cmd,simulator_parameters));
+    QString ngsp_cmd = cmd_args.takeFirst();
+    Session->start(ngsp_cmd,cmd_args);
+    if (!Session->waitForStarted()) return; // slotSessionError() cleans up
+
+    for (const QString &file : osdiFiles)
+        send(QString("osdi %1").arg(file));
+}
+
+/*!
+ * \brief NgspiceSession::loadCircuit Replace the circuit loaded in Ngspice.
+ */
+void NgspiceSession::loadCircuit(const QString &circuit)
+{
+    QString netfile = "spice4qucs.tune.cir";
+    QFile spice_file(workdir + QDir::separator() + netfile);
+    if (spice_file.open(QFile::WriteOnly)) {
+        QTextStream stream(&spice_file);
+        stream << circuit;
+        spice_file.close();
+    }
+    if (!loadedCircuit.isEmpty()) send("remcirc");
+    send(QString("source %1").arg(netfile));
+    loadedCircuit = circuit;
+
+    QStringList others;
+    QMap<QString, QStringList> elements;
+    appliedParams.clear();
+    splitCircuit(circuit,others,elements,appliedParams);
+}
+
+/*!
+ * \brief NgspiceSession::run Run the analyses. The control section resets
+ *        the circuit after each analysis, which restores the loaded values,
+ *        so the tuning commands are sent before every analysis.
+ * \param script Commands of the control section
+ * \param tuning alterparam and alter commands for the edited values
+ */
+void NgspiceSession::run(const QStringList &script, const QStringList &tuning)
+{
+    removeAllSimulatorOutputs();
+
+    QStringList commands = tuning;
+    for (const QString &line : script) {
+        commands.append(line);
+        if (line.trimmed() == "reset") commands += tuning;
+    }
+    commands.append(QString("echo %1").arg(END_MARKER));
+
+    received.clear();
+    Running = true;
+    emit started();
+    for (const QString &cmd : commands)
+        send(cmd);
+}
+
+void NgspiceSession::send(const QString &command)
+{
+    if (Session == nullptr) return;
+    Session->write(command.toUtf8() + "\n");
+}
+
+/*!
+ * \brief NgspiceSession::readSpiceinit Content of the .spiceinit which
+ *        prepareCodeModels() has written into the simulator working
+ *        directory. startSession() copies it into the session directory.
+ */
+QString NgspiceSession::readSpiceinit()
+{
+    QFile file(QucsSettings.S4Qworkdir + QDir::separator() + ".spiceinit");
+    if (!file.open(QFile::ReadOnly)) return QString();
+    return QString::fromUtf8(file.readAll());
+}
+
+/*!
+ * \brief NgspiceSession::slotSessionOutput Collect the output of a run.
+ *        When the end marker arrives the results are converted into the
+ *        dataset of the schematic.
+ */
+void NgspiceSession::slotSessionOutput()
+{
+    received += QString::fromUtf8(Session->readAll());
+    if (!Running) {
+        received.clear();
+        return;
+    }
+
+    static const QRegularExpression marker_rx("^" END_MARKER "\\s*$",
+                                              QRegularExpression::MultilineOption);
+    QRegularExpressionMatch m = marker_rx.match(received);
+    if (!m.hasMatch()) {
+        int lf = received.lastIndexOf('\n');  // the marker starts a line
+        if (lf >= 0) {
+            appendOutput(received.left(lf + 1));
+            received.remove(0,lf + 1);
+        }
+        return;
+    }
+
+    Running = false;
+    appendOutput(received.left(m.capturedStart()));
+    received.clear();
+    convertToQucsData(datasetName());
+    emit progress(100);
+    emit finished();
+
+    if (Pending) {
+        Pending = false;
+        QTimer::singleShot(0,this,SLOT(slotUpdate()));
+    }
+}
+
+/*!
+ * \brief NgspiceSession::slotSessionFinished Ngspice exited, e.g. it
+ *        crashed on the circuit. The next edit starts it again.
+ */
+void NgspiceSession::slotSessionFinished(int, QProcess::ExitStatus)
+{
+    appendOutput(received);
+    received.clear();
+    Session->deleteLater();
+    Session = nullptr;
+    loadedCircuit.clear();
+    if (Running) {
+        Running = false;
+        Pending = false;
+        emit finished();
+        emit errors(QProcess::Crashed);
+    }
+}
+
+void NgspiceSession::slotSessionError(QProcess::ProcessError err)
+{
+    if (err != QProcess::FailedToStart) return;  // finished() follows
+    Session->deleteLater();
+    Session = nullptr;
+    Running = false;
+    Pending = false;
+    output += QString("Ngspice could not be started: %1\n").arg(simulator_cmd);
+    emit finished();
+    emit errors(err);
+}
+
+/*!
+ * \brief NgspiceSession::diffCircuit Compare the edited circuit with the
+ *        loaded one and express the difference as Ngspice commands.
+ *        Element values are compared with the loaded circuit, as reset
+ *        restores them. Parameters are compared with the values applied
+ *        last, as alterparam persists; a parameter set back to its loaded
+ *        value gets an alterparam, too.
+ * \param loaded Circuit loaded in Ngspice
+ * \param current Circuit of the edited schematic
+ * \param[in,out] applied Parameter values in the deck of Ngspice, updated
+ *        to the values of the current circuit on success
+ * \param[out] tuning alterparam commands followed by reset, then alter
+ *        commands
+ * \return False if the circuit has to be reloaded
+ */
+bool NgspiceSession::diffCircuit(const QString &loaded, const QString &current,
+                                 QMap<QString, QString> &applied, QStringList &tuning)
+{
+    tuning.clear();
+    QStringList others0, others1;
+    QMap<QString, QStringList> elements0, elements1;
+    QMap<QString, QString> params0, params1;
+    splitCircuit(loaded,others0,elements0,params0);
+    splitCircuit(current,others1,elements1,params1);
+
+    if (others0 != others1) return false;  // models, subcircuits, options
+    if (elements0.keys() != elements1.keys()) return false;
+    if (params0.keys() != params1.keys()) return false;
+
+    QStringList alterparams;
+    for (auto it = params1.constBegin(); it != params1.constEnd(); ++it) {
+        if (it.value() == applied.value(it.key(),params0.value(it.key()))) continue;
+        if (!isPlainValue(it.value())) return false;
+        alterparams.append(QString("alterparam %1 = %2").arg(it.key(),it.value()));
+    }
+
+    QStringList alters;
+    for (auto it = elements1.constBegin(); it != elements1.constEnd(); ++it) {
+        const QString &name = it.key();
+        const QStringList &tokens0 = elements0[name];
+        const QStringList &tokens1 = it.value();
+        if (tokens0 == tokens1) continue;
+        if (tokens0.count() != tokens1.count()) return false;
+
+        for (int i = 0; i < tokens1.count(); i++) {
+            const QString &t0 = tokens0.at(i);
+            const QString &t1 = tokens1.at(i);
+            if (t0 == t1) continue;
+            QString key = t1.section('=',0,0);
+            QString value = t1.section('=',1);
+            if (t0.contains('=') && t1.contains('=') && !name.startsWith('x') &&
+                (t0.section('=',0,0).compare(key,Qt::CaseInsensitive) == 0) &&
+                isPlainValue(value)) {
+                alters.append(QString("alter %1 %2 = %3").arg(name,key.toLower(),value));
+            } else if ((i == 3) && QString("rcl").contains(name.at(0)) &&
+                       isPlainValue(t1)) {  // value of a passive device
+                alters.append(QString("alter %1 = %2").arg(name,t1));
+            } else {
+                return false;  // nodes, models, expressions
+            }
+        }
+    }
+
+    tuning = alterparams;
+    if (!alterparams.isEmpty()) tuning.append("reset");  // evaluate the parameters
+    tuning += alters;
+    applied = params1;
+    return true;
+}
+
+/*!
+ * \brief NgspiceSession::splitCircuit Split a circuit into parameters,
+ *        element lines and all other lines. Continuation lines are joined
+ *        and spaces around '=' are removed. Subcircuit definitions are
+ *        kept as other lines, as alter cannot reach into them.
+ * \param circuit Circuit text
+ * \param[out] others Lines compared literally
+ * \param[out] elements Tokens of the top level elements by lower case name
+ * \param[out] params Values of the .PARAM definitions by lower case name
+ */
+void NgspiceSession::splitCircuit(const QString &circuit, QStringList &others,
+                                  QMap<QString, QStringList> &elements,
+                                  QMap<QString, QString> &params)
+{
+    QStringList lines;
+    const QStringList text = circuit.split('\n');
+    for (QString line : text) {
+        line = line.trimmed();
+        if (line.isEmpty() || line.startsWith('*')) continue;
+        if (line.startsWith('+') && !lines.isEmpty()) {
+            lines.last() += " " + line.mid(1).trimmed();
+            continue;
+        }
+        lines.append(line);
+    }
+
+    static const QRegularExpression assign_rx("\\s*=\\s*");
+    static const QRegularExpression space_rx("\\s+");
+    static const QRegularExpression param_rx("([A-Za-z_][\\w.]*)=(\\{[^}]*\\}|'[^']*'|\\S+)");
+
+    int subckt = 0;
+    for (const QString &line : lines) {
+        QString lower = line.toLower();
+        if (lower.startsWith(".subckt")) subckt++;
+        bool is_param = lower.startsWith(".param ");
+        if ((subckt > 0) || (lower.startsWith('.') && !is_param)) {
+            others.append(line);
+            if (lower.startsWith(".ends")) subckt--;
+            continue;
+        }
+
+        QString norm = line;
+        norm.replace(assign_rx,"=");
+        if (is_param) {
+            QRegularExpressionMatchIterator it = param_rx.globalMatch(norm.mid(6));
+            while (it.hasNext()) {
+                QRegularExpressionMatch m = it.next();
+                params.insert(m.captured(1).toLower(),m.captured(2));
+            }
+            continue;
+        }
+
+        QStringList tokens = norm.split(space_rx,qucs::SkipEmptyParts);
+        QString name = tokens.first().toLower();
+        if (elements.contains(name)) {
+            others.append(line);
+        } else {
+            elements.insert(name,tokens);
+        }
+    }
+}
+
+/*!
+ * \brief NgspiceSession::isPlainValue Check if a value is a number with
+ *        an optional scale factor or unit, which alter accepts.
+ */
+bool NgspiceSession::isPlainValue(const QString &value)
+{
+    static const QRegularExpression number_rx(
+                "^[-+]?(\\d+\\.?\\d*|\\.\\d+)([eE][-+]?\\d+)?[a-zA-Z]*$");
+    return number_rx.match(value).hasMatch();
+}
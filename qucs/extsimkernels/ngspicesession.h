@@ -0,0 +1,92 @@
+/***************************************************************************
+                              ngspicesession.h
+                             ------------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef NGSPICESESSION_H
+#define NGSPICESESSION_H
+
+#include <QString>
+#include <QStringList>
+#include <QProcess>
+#include "ngspice.h"
+
+/*!
+  \file ngspicesession.h
+  \brief Declaration of the NgspiceSession class
+*/
+
+/*!
+ * \brief The NgspiceSession class keeps one interactive Ngspice process
+ *        per schematic for tuning. The circuit is loaded once, the
+ *        analyses of the control section are sent as commands and their
+ *        results are converted into the dataset of the schematic.
+ *
+ *        When the schematic is edited, the new netlist is compared with
+ *        the loaded one. Changed .PARAM values and element values are set
+ *        with alterparam and alter commands before the analyses are run
+ *        again, so a tuning step costs only the analyses. alterparam
+ *        changes the deck and outlasts reset, so the parameters are
+ *        compared with the values applied last, not with the loaded ones. Other changes,
+ *        e.g. to the topology or the models, reload the circuit in the
+ *        same process. Ngspice is restarted only if the code models or
+ *        OSDI libraries change.
+ */
+class NgspiceSession : public Ngspice
+{
+    Q_OBJECT
+private:
+    QProcess *Session;
+    QString loadedCircuit;   // circuit part of the netlist Ngspice has loaded
+    QMap<QString, QString> appliedParams;  // .PARAM values in the deck of Ngspice
+    QString lastCircuit;     // netlist of the last run
+    QStringList lastScript;
+    QStringList osdiFiles;
+    QString spiceinit;       // content of .spiceinit at the start of Ngspice
+    QString received;        // output of the running analyses
+    bool Running;
+    bool Pending;            // schematic edited during a run
+
+    bool createDeck(QString &circuit, QStringList &script, QStringList &osdi);
+    void startSession();
+    void loadCircuit(const QString &circuit);
+    void run(const QStringList &script, const QStringList &tuning);
+    void send(const QString &command);
+    QString readSpiceinit();
+
+    static bool diffCircuit(const QString &loaded, const QString &current,
+                            QMap<QString, QString> &applied, QStringList &tuning);
+    static void splitCircuit(const QString &circuit, QStringList &others,
+                             QMap<QString, QStringList> &elements,
+                             QMap<QString, QString> &params);
+    static bool isPlainValue(const QString &value);
+
+public:
+    explicit NgspiceSession(Schematic *sch_, QObject *parent = 0);
+    ~NgspiceSession();
+
+    QString datasetName();
+
+public slots:
+    void slotStart();
+    void slotUpdate();
+    void killThemAll();
+
+private slots:
+    void slotSessionOutput();
+    void slotSessionFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void slotSessionError(QProcess::ProcessError err);
+};
+
+#endif // NGSPICESESSION_H
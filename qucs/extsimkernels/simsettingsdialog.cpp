@@ -33,6 +33,8 @@ SimSettingsDialog::SimSettingsDialog(QWidget *parent) :
     lblSpiceOpus = new QLabel(tr("SpiceOpus executable location"));
     lblQucsator = new QLabel(tr("Qucsator executable location"));
     lblNprocs = new QLabel(tr("Number of processors in a system:"));
+    lblXyceJobs = new QLabel(tr("Concurrent Xyce analyses (0 = automatic):"));
+    lblNgspiceShards = new QLabel(tr("Ngspice processes per parameter sweep (0 = automatic):"));
     lblWorkdir = new QLabel(tr("Directory to store netlist and simulator output"));
     lblSimParam = new QLabel(tr("Extra simulator parameters"));
 
@@ -55,6 +57,14 @@ SimSettingsDialog::SimSettingsDialog(QWidget *parent) :
     spbNprocs->setMaximum(256);
     spbNprocs->setValue(1);
     spbNprocs->setValue(QucsSettings.NProcs);
+    spbXyceJobs = new QSpinBox(this);
+    spbXyceJobs->setMinimum(0);
+    spbXyceJobs->setMaximum(256);
+    spbXyceJobs->setValue(QucsSettings.XyceJobs);
+    spbNgspiceShards = new QSpinBox(this);
+    spbNgspiceShards->setMinimum(0);
+    spbNgspiceShards->setMaximum(256);
+    spbNgspiceShards->setValue(QucsSettings.NgspiceShards);
     edtWorkdir = new QLineEdit(QucsSettings.S4Qworkdir);
     edtSimParam = new QLineEdit(QucsSettings.SimParameters);
 
@@ -109,6 +119,16 @@ SimSettingsDialog::SimSettingsDialog(QWidget *parent) :
     h5->addWidget(spbNprocs);
     top2->addLayout(h5);
 
+    QHBoxLayout *h11 = new QHBoxLayout;
+    h11->addWidget(lblXyceJobs);
+    h11->addWidget(spbXyceJobs);
+    top2->addLayout(h11);
+
+    QHBoxLayout *h12 = new QHBoxLayout;
+    h12->addWidget(lblNgspiceShards);
+    h12->addWidget(spbNgspiceShards);
+    top2->addLayout(h12);
+
     top2->addWidget(lblSpiceOpus);
     QHBoxLayout *h7 = new QHBoxLayout;
     h7->addWidget(edtSpiceOpus,3);
@@ -171,6 +191,8 @@ void SimSettingsDialog::slotApply()
     QucsSettings.SpiceOpusExecutable = edtSpiceOpus->text();
     QucsSettings.Qucsator = edtQucsator->text();
     QucsSettings.NProcs = spbNprocs->value();
+    QucsSettings.XyceJobs = spbXyceJobs->value();
+    QucsSettings.NgspiceShards = spbNgspiceShards->value();
     QucsSettings.S4Qworkdir = edtWorkdir->text();
     QucsSettings.SimParameters = edtSimParam->text();
     if ((QucsSettings.DefaultSimulator != cbxSimulator->currentIndex())&&
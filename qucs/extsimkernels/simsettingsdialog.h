@@ -32,6 +32,8 @@ private:
     QLabel *lblSpiceOpus;
     QLabel *lblXycePar;
     QLabel *lblNprocs;
+    QLabel *lblXyceJobs;
+    QLabel *lblNgspiceShards;
     QLabel *lblQucsator;
     QLabel *lblWorkdir;
     QLabel *lblSimulator;
@@ -45,6 +47,8 @@ private:
     QLineEdit *edtXycePar;
     QLineEdit *edtQucsator;
     QSpinBox  *spbNprocs;
+    QSpinBox  *spbXyceJobs;
+    QSpinBox  *spbNgspiceShards;
     QLineEdit *edtWorkdir;
     QLineEdit *edtSimParam;
 
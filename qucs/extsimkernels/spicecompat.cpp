@@ -1,6 +1,7 @@
 #include "spicecompat.h"
 #include "main.h"
 #include "misc.h"
+#include "spicelibindex.h"
 
 #include <QDebug>
 
@@ -260,46 +261,20 @@ QString spicecompat::convert_relative_filename(QString filename)
     else return filename;
 }
 
+/*!
+ * \brief spicecompat::getPins Get the pin names of a subcircuit.
+ * \param file SPICE file, relative to the working directory or absolute
+ * \param compname .SUBCKT entry name, case insensitive
+ * \param pin_names[out] Pin names are appended here
+ * \return Number of pins
+ */
 int spicecompat::getPins(const QString &file, const QString &compname, QStringList &pin_names)
 {
-    int r = 0;
-    QString content;
     QString LibName = spicecompat::convert_relative_filename(file);
-    QFile f(LibName);
-    if (f.open(QIODevice::ReadOnly)) {
-        QTextStream ts(&f);
-        content = ts.readAll();
-        f.close();
-    } else return 0;
-
-    QRegularExpression subckt_header("^\\s*\\.(S|s)(U|u)(B|b)(C|c)(K|k)(T|t)\\s.*");
-    QRegularExpression sep("\\s");
-
-    QTextStream stream(&content,QIODevice::ReadOnly);
-    while (!stream.atEnd()) {
-        QString lin = stream.readLine();
-
-        if (subckt_header.match(lin).hasMatch()) {
-
-            QStringList lst2 = lin.split(sep,qucs::SkipEmptyParts);
-            QString name = lin.section(sep,1,1,QString::SectionSkipEmpty).toLower();
-            QString refname = compname.toLower();
-            if (name != refname) continue;
-            lst2.removeFirst();
-            lst2.removeFirst();
-            for (const auto &s1: lst2) {
-                QString pp = s1;
-                if (!s1.contains('=') &&
-                   (pp.toLower() != "params:")) {
-                    pin_names.append(s1);
-                }
-            }
-            r = pin_names.count();
-            break;
-        }
-    }
-
-    return r;
+    SpiceLibIndex::Subckt sub;
+    if (!SpiceLibIndex::subckt(LibName, compname, sub)) return 0;
+    pin_names.append(sub.pins);
+    return pin_names.count();
 }
 
 /*!
@@ -309,22 +284,7 @@ int spicecompat::getPins(const QString &file, const QString &compname, QStringLi
  */
 QString spicecompat::getSubcktName(const QString& subfilename)
 {
-    QString s = "";
-
-    QFile sub_file(subfilename);
-    if (sub_file.open(QIODevice::ReadOnly)) {
-        QRegularExpression subckt_header("^\\s*\\.(S|s)(U|u)(B|b)(C|c)(K|k)(T|t)\\s.*");
-        QRegularExpression sep("\\s");
-        QStringList lst = QString(sub_file.readAll()).split("\n");
-        for (const QString& str : lst) {            
-            if (subckt_header.match(str).hasMatch()) {
-                s = str.section(sep,1,1,QString::SectionSkipEmpty);
-                break;
-            }
-        }
-        sub_file.close();
-    }
-    return s;
+    return SpiceLibIndex::firstSubckt(subfilename);
 }
 
 /*!
@@ -0,0 +1,190 @@
+/***************************************************************************
+                            spicelibindex.cpp
+                           -------------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "spicelibindex.h"
+#include "misc.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+
+#include <algorithm>
+
+/*!
+  \file spicelibindex.cpp
+  \brief Implementation of the SpiceLibIndex class
+*/
+
+QMutex SpiceLibIndex::Mutex;
+QHash<QString, SpiceLibIndex::Entry> SpiceLibIndex::Libraries;
+quint64 SpiceLibIndex::UseCounter = 0;
+
+/*!
+ * \brief SpiceLibIndex::library Return the index of a SPICE file. The file
+ *        is scanned on the first request and again only if its
+ *        modification time has changed.
+ * \param file SPICE file name
+ * \return Index or a null pointer if the file cannot be read.
+ */
+SpiceLibIndex::LibraryPtr SpiceLibIndex::library(const QString &file)
+{
+    QDateTime mtime = QFileInfo(file).lastModified();
+
+    Mutex.lock();
+    QHash<QString, Entry>::iterator it = Libraries.find(file);
+    if (it != Libraries.end() && it->mtime == mtime) {
+        it->used = ++UseCounter;
+        LibraryPtr lib = it->lib;
+        Mutex.unlock();
+        return lib;
+    }
+    Mutex.unlock();
+
+    LibraryPtr lib = scan(file);
+    if (lib.isNull()) return lib;
+
+    Entry entry;
+    entry.lib = lib;
+    entry.mtime = mtime;
+    Mutex.lock();
+    entry.used = ++UseCounter;
+    Libraries.insert(file, entry);
+    trim();
+    Mutex.unlock();
+    return lib;
+}
+
+/*!
+ * \brief SpiceLibIndex::subckt Look up a subcircuit definition.
+ * \param file SPICE file name
+ * \param name Subcircuit name, case insensitive
+ * \param sub Index entry of the first definition with this name
+ * \return true if found
+ */
+bool SpiceLibIndex::subckt(const QString &file, const QString &name, Subckt &sub)
+{
+    LibraryPtr lib = library(file);
+    if (lib.isNull()) return false;
+    int i = lib->index.value(name.toLower(), -1);
+    if (i < 0) return false;
+    sub = lib->subckts.at(i);
+    return true;
+}
+
+/*!
+ * \brief SpiceLibIndex::firstSubckt Name of the first subcircuit of a file.
+ * \return Name or an empty string
+ */
+QString SpiceLibIndex::firstSubckt(const QString &file)
+{
+    LibraryPtr lib = library(file);
+    if (lib.isNull() || lib->subckts.isEmpty()) return QString();
+    return lib->subckts.first().name;
+}
+
+// ---------------------------------------------------------------------
+void SpiceLibIndex::clear()
+{
+    QMutexLocker locker(&Mutex);
+    Libraries.clear();
+}
+
+// ---------------------------------------------------------------------
+// Drops the entries of changed or deleted files and the least recently
+// used ones beyond MaxLibraries. Called with the mutex locked. Holders of
+// a LibraryPtr keep their index.
+void SpiceLibIndex::trim()
+{
+    for (auto it = Libraries.begin(); it != Libraries.end(); ) {
+        QFileInfo inf(it.key());
+        if (!inf.exists() || (inf.lastModified() != it->mtime))
+            it = Libraries.erase(it);
+        else ++it;
+    }
+    if (Libraries.size() <= MaxLibraries) return;
+
+    QList<quint64> stamps;
+    for (const Entry &entry : Libraries) stamps.append(entry.used);
+    std::sort(stamps.begin(), stamps.end());
+    quint64 oldest = stamps.at(Libraries.size() - MaxLibraries - 1);
+    for (auto it = Libraries.begin(); it != Libraries.end(); ) {
+        if (it->used <= oldest) it = Libraries.erase(it);
+        else ++it;
+    }
+}
+
+// ---------------------------------------------------------------------
+// Scans the file line by line for .SUBCKT headers and their .ENDS.
+SpiceLibIndex::LibraryPtr SpiceLibIndex::scan(const QString &file)
+{
+    QFile f(file);
+    if (!f.open(QIODevice::ReadOnly))
+        return LibraryPtr();
+    QByteArray data = f.readAll();
+    f.close();
+
+    QRegularExpression subckt_header("^\\s*\\.(S|s)(U|u)(B|b)(C|c)(K|k)(T|t)\\s.*");
+    QRegularExpression ends("^\\s*\\.(E|e)(N|n)(D|d)(S|s)\\b");
+    QRegularExpression sep("\\s");
+
+    QSharedPointer<Library> lib(new Library);
+    int open = -1;  // definition waiting for its .ENDS
+    int pos = 0;
+    while (pos < data.size()) {
+        int end = data.indexOf('\n', pos);
+        if (end < 0) end = data.size();
+        else end++;
+
+        // only lines starting with a dot are of interest, skip the rest
+        // without decoding them
+        int first = pos;
+        while (first < end && (data.at(first) == ' ' || data.at(first) == '\t'))
+            first++;
+        if (first < end && data.at(first) == '.') {
+            QString lin = QString::fromUtf8(data.constData() + pos, end - pos);
+            if (subckt_header.match(lin).hasMatch()) {
+                if (open >= 0) // missing .ENDS
+                    lib->subckts[open].length = pos - lib->subckts[open].offset;
+                Subckt sub;
+                QStringList lst2 = lin.split(sep, qucs::SkipEmptyParts);
+                if (lst2.count() < 2) { // no name
+                    pos = end;
+                    continue;
+                }
+                sub.name = lst2.at(1);
+                lst2.removeFirst();
+                lst2.removeFirst();
+                for (const auto &s1: lst2) {
+                    if (s1.contains('=')) sub.params.append(s1);
+                    else if (s1.toLower() != "params:") sub.pins.append(s1);
+                }
+                sub.offset = pos;
+                sub.length = data.size() - pos;
+                QString key = sub.name.toLower();
+                if (!lib->index.contains(key))
+                    lib->index.insert(key, lib->subckts.size());
+                open = lib->subckts.size();
+                lib->subckts.append(sub);
+            } else if (open >= 0 && ends.match(lin).hasMatch()) {
+                lib->subckts[open].length = end - lib->subckts[open].offset;
+                open = -1;
+            }
+        }
+        pos = end;
+    }
+
+    return lib;
+}
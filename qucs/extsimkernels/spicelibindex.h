@@ -0,0 +1,85 @@
+/***************************************************************************
+                             spicelibindex.h
+                            -----------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SPICELIBINDEX_H
+#define SPICELIBINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+#include <QDateTime>
+#include <QMutex>
+#include <QSharedPointer>
+
+/*!
+  \file spicelibindex.h
+  \brief Declaration of the SpiceLibIndex class
+*/
+
+/*!
+ * \brief The SpiceLibIndex class is a process-wide index of the .SUBCKT
+ *        definitions of SPICE model files. Every file is scanned once per
+ *        modification (keyed by path and mtime) into a table of subcircuit
+ *        names with their pin and parameter lists and the byte range of the
+ *        definition. spicecompat::getPins() and spicecompat::getSubcktName()
+ *        query it, so netlisting many instances of a vendor model reads the
+ *        model file only once.
+ *
+ *        When a file is added, the entries of changed or deleted files and
+ *        the least recently used ones beyond MaxLibraries are dropped.
+ */
+class SpiceLibIndex
+{
+public:
+    struct Subckt {
+        QString name;        //!< as written in the file
+        QStringList pins;
+        QStringList params;  //!< name=value
+        qint64 offset;       //!< byte offset of the .SUBCKT line
+        qint64 length;       //!< byte length up to and including .ENDS
+    };
+
+    struct Library {
+        QList<Subckt> subckts;       //!< in file order
+        QHash<QString, int> index;   //!< lower case name -> first definition
+    };
+
+    typedef QSharedPointer<const Library> LibraryPtr;
+
+    static LibraryPtr library(const QString &file);
+    static bool subckt(const QString &file, const QString &name, Subckt &sub);
+    static QString firstSubckt(const QString &file);
+    static void clear();
+
+    static const int MaxLibraries = 64;
+
+private:
+    struct Entry {
+        LibraryPtr lib;
+        QDateTime mtime;
+        quint64 used;    // for least recently used eviction
+    };
+
+    static LibraryPtr scan(const QString &file);
+    static void trim();
+
+    static QMutex Mutex;
+    static QHash<QString, Entry> Libraries;
+    static quint64 UseCounter;
+};
+
+#endif // SPICELIBINDEX_H
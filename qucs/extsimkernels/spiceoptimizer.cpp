@@ -0,0 +1,716 @@
+/***************************************************************************
+                             spiceoptimizer.cpp
+                            --------------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "spiceoptimizer.h"
+#include "abstractspicekernel.h"
+#include "components/opt_sim.h"
+#include "schematic.h"
+#include "main.h"
+#include "misc.h"
+
+#include <QDir>
+#include <QFile>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QThread>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/*!
+  \file spiceoptimizer.cpp
+  \brief Implementation of the SpiceOptimizer class
+*/
+
+// cost of a candidate that cannot be simulated or evaluated
+#define FAILED_COST std::numeric_limits<double>::infinity()
+
+// the DE strategies with two difference vectors need five other members
+#define MIN_POPULATION 6
+
+
+SpiceOptimizer::SpiceOptimizer(Schematic *sch, AbstractSpiceKernel *kernel_, QObject *parent) :
+    QObject(parent)
+{
+    Sch = sch;
+    kernel = kernel_;
+    Opt = findOptimization(sch);
+    workdir = QucsSettings.S4Qworkdir;
+    jobLimit = std::max(1, QThread::idealThreadCount());
+    bestIndex = -1;
+    iteration = 0;
+    Stopped = StartFailed = finalRun = Result = reportedFailure = false;
+}
+
+SpiceOptimizer::~SpiceOptimizer()
+{
+    killThemAll();
+}
+
+/*!
+ * \brief SpiceOptimizer::findOptimization Find the active optimization
+ *        component of a schematic.
+ * \return The component or nullptr if the schematic is not optimized
+ */
+Optimize_Sim *SpiceOptimizer::findOptimization(Schematic *sch)
+{
+    for(Component *pc = sch->DocComps.first(); pc != 0; pc = sch->DocComps.next()) {
+        if ((pc->isActive == COMP_IS_ACTIVE) && (pc->Model == ".Opt"))
+            return (Optimize_Sim *) pc;
+    }
+    return nullptr;
+}
+
+QString SpiceOptimizer::getOutput()
+{
+    return output;
+}
+
+/*!
+ * \brief SpiceOptimizer::hasResult Check if the optimization finished with
+ *        the simulation of the best candidate, i.e. the simulator outputs in
+ *        the working directory may be converted to a Qucs dataset.
+ */
+bool SpiceOptimizer::hasResult()
+{
+    return Result;
+}
+
+/*!
+ * \brief SpiceOptimizer::slotOptimize Create the netlists and start the
+ *        simulation of the initial population.
+ */
+void SpiceOptimizer::slotOptimize()
+{
+    output.clear();
+    runQueue.clear();
+    missingGoals.clear();
+    costs.clear();
+    bestIndex = -1;
+    iteration = 0;
+    Stopped = StartFailed = finalRun = Result = reportedFailure = false;
+
+    if ((Opt == nullptr) || !readSettings()) {
+        emit finished();
+        emit errors(QProcess::FailedToStart);
+        return;
+    }
+
+    if (!kernel->createNetlists(netlists)) {
+        output += kernel->getOutput();
+        emit finished();
+        emit errors(QProcess::FailedToStart);
+        return;
+    }
+    output += kernel->getOutput(); // warnings, code model compilation
+
+    output += QString("Differential evolution: %1 variables, population %2, "
+                      "up to %3 simulator processes\n")
+                  .arg(variables.count()).arg(NP).arg(jobLimit);
+
+    initPopulation();
+    emit started();
+    evaluate(population);
+}
+
+/*!
+ * \brief SpiceOptimizer::killThemAll Stop the optimization. The best
+ *        values found so far are kept.
+ */
+void SpiceOptimizer::killThemAll()
+{
+    Stopped = true;
+    runQueue.clear();
+    QList<OptJob> jobs = Jobs;
+    for (const OptJob &job : jobs) {
+        if (job.process->state() != QProcess::NotRunning)
+            job.process->kill();
+    }
+}
+
+// ---------------------------------------------------------------------
+// Reads the DE settings, the variables and the goals of the optimization
+// component. The settings are method|maxiter|refresh|NP|F|CR|seed|
+// minvariance|costobj|costconstr, a variable is name|yes/no|init|min|max|type
+// and a goal is name|type|value.
+bool SpiceOptimizer::readSettings()
+{
+    QStringList de = Opt->Props.at(1)->Value.split('|');
+    strategy = de.value(0).toInt();
+    if ((strategy < 1) || (strategy > 10)) strategy = 3;
+    maxIter = std::max(1, de.value(1).toInt());
+    refresh = std::max(1, de.value(2).toInt());
+    NP = std::max(MIN_POPULATION, de.value(3).toInt());
+    F = de.value(4,"0.85").toDouble();
+    if (F <= 0.0) F = 0.85;
+    CR = std::min(1.0, std::max(0.0, de.value(5,"1").toDouble()));
+    rng.seed(de.value(6,"3").toUInt());
+    minVariance = de.value(7,"1e-6").toDouble();
+    costObj = de.value(8,"10").toDouble();
+    costConstr = de.value(9,"100").toDouble();
+
+    variables.clear();
+    goals.clear();
+    for(Property *pp = Opt->Props.at(2); pp != 0; pp = Opt->Props.next()) {
+        QStringList val = pp->Value.split('|');
+        if (pp->Name == "Var") {
+            if (val.value(1) != "yes") continue; // not optimized
+            OptVariable var;
+            var.name = val.value(0);
+            var.type = val.value(5,"LIN_DOUBLE");
+            bool ok_init, ok_min, ok_max;
+            double init = toNumber(val.value(2), &ok_init);
+            double lower = toNumber(val.value(3), &ok_min);
+            double upper = toNumber(val.value(4), &ok_max);
+            if (!ok_min || !ok_max) {
+                output += QString("Variable %1 has no valid limits!\n").arg(var.name);
+                return false;
+            }
+            if (lower > upper) std::swap(lower, upper);
+            if (!ok_init) init = (lower + upper) / 2;
+            init = std::min(upper, std::max(lower, init));
+            if ((var.type != "LIN_DOUBLE") && (var.type != "LIN_INT")) {
+                if (lower <= 0.0) {
+                    output += QString("Variable %1 has a logarithmic type, "
+                                      "its limits must be positive!\n").arg(var.name);
+                    return false;
+                }
+                lower = std::log10(lower);
+                upper = std::log10(upper);
+                init = std::log10(init);
+            }
+            var.lower = lower;
+            var.upper = upper;
+            var.init = init;
+            variables.append(var);
+        } else if (pp->Name == "Goal") {
+            OptGoal goal;
+            goal.name = val.value(0);
+            goal.type = val.value(1,"MON");
+            goal.value = toNumber(val.value(2));
+            goals.append(goal);
+        }
+    }
+
+    if (variables.isEmpty()) {
+        output += "No variable is optimized!\n";
+        return false;
+    }
+    bool haveGoal = false;
+    for (const OptGoal &goal : goals)
+        if (goal.type != "MON") haveGoal = true;
+    if (!haveGoal) {
+        output += "No optimization goal found! Add a goal other than monitor.\n";
+        return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------
+// The first member starts at the initial values, the others are spread
+// uniformly over the search space.
+void SpiceOptimizer::initPopulation()
+{
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    population.resize(NP);
+    for (int k = 0; k < NP; k++) {
+        QVector<double> x(variables.count());
+        for (int j = 0; j < variables.count(); j++) {
+            const OptVariable &var = variables.at(j);
+            if (k == 0) x[j] = var.init;
+            else x[j] = var.lower + uniform(rng) * (var.upper - var.lower);
+        }
+        population[k] = x;
+    }
+    trials = population;
+}
+
+/*!
+ * \brief SpiceOptimizer::makeTrial Create the trial vector of a member by
+ *        mutation and crossover. The strategies are numbered as in ASCO:
+ *        1..5 use exponential and 6..10 binomial crossover with the
+ *        mutations best/1, rand/1, rand-to-best/1, best/2 and rand/2.
+ * \param i Index of the member in the population
+ */
+QVector<double> SpiceOptimizer::makeTrial(int i)
+{
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::uniform_int_distribution<int> member(0, NP - 1);
+    int r[5];
+    for (int n = 0; n < 5; n++) { // distinct members other than i
+        bool distinct;
+        do {
+            r[n] = member(rng);
+            distinct = (r[n] != i);
+            for (int m = 0; m < n; m++)
+                if (r[m] == r[n]) distinct = false;
+        } while (!distinct);
+    }
+
+    const QVector<double> &x = population.at(i);
+    const QVector<double> &best = population.at(bestIndex);
+    const QVector<double> &x1 = population.at(r[0]);
+    const QVector<double> &x2 = population.at(r[1]);
+    const QVector<double> &x3 = population.at(r[2]);
+    const QVector<double> &x4 = population.at(r[3]);
+    const QVector<double> &x5 = population.at(r[4]);
+
+    int D = variables.count();
+    QVector<double> v(D);
+    int mutation = (strategy - 1) % 5;
+    for (int j = 0; j < D; j++) {
+        switch (mutation) {
+        case 0: v[j] = best[j] + F * (x1[j] - x2[j]);
+            break;
+        case 1: v[j] = x1[j] + F * (x2[j] - x3[j]);
+            break;
+        case 2: v[j] = x[j] + F * (best[j] - x[j]) + F * (x1[j] - x2[j]);
+            break;
+        case 3: v[j] = best[j] + F * (x1[j] + x2[j] - x3[j] - x4[j]);
+            break;
+        default: v[j] = x5[j] + F * (x1[j] + x2[j] - x3[j] - x4[j]);
+            break;
+        }
+    }
+
+    QVector<double> trial = x;
+    std::uniform_int_distribution<int> dimension(0, D - 1);
+    int n = dimension(rng);
+    if (strategy <= 5) { // exponential: a run of consecutive parameters
+        int L = 0;
+        do {
+            trial[n] = v[n];
+            n = (n + 1) % D;
+            L++;
+        } while ((uniform(rng) < CR) && (L < D));
+    } else { // binomial: every parameter independently, at least one
+        for (int j = 0; j < D; j++)
+            if ((j == n) || (uniform(rng) < CR)) trial[j] = v[j];
+    }
+
+    for (int j = 0; j < D; j++) { // out of bounds values are drawn again
+        const OptVariable &var = variables.at(j);
+        if ((trial[j] < var.lower) || (trial[j] > var.upper))
+            trial[j] = var.lower + uniform(rng) * (var.upper - var.lower);
+    }
+    return trial;
+}
+
+/*!
+ * \brief SpiceOptimizer::evaluate Write the netlists of the candidates into
+ *        their directories and queue them for simulation.
+ */
+void SpiceOptimizer::evaluate(const QVector< QVector<double> > &candidates)
+{
+    trials = candidates;
+    trialCosts.fill(FAILED_COST, candidates.count());
+    pendingRuns.fill(netlists.count(), candidates.count());
+    failedRuns.fill(false, candidates.count());
+
+    QString spiceinit = workdir + QDir::separator() + ".spiceinit";
+    for (int k = 0; k < candidates.count(); k++) {
+        QString dir = candidateDir(k);
+        QDir(dir).removeRecursively(); // no outputs of the previous candidate
+        QDir().mkpath(dir);
+        if (QFile::exists(spiceinit)) // Ngspice reads it from the working directory
+            QFile::copy(spiceinit, dir + QDir::separator() + ".spiceinit");
+        writeNetlists(dir, candidates.at(k));
+        for (auto it = netlists.constBegin(); it != netlists.constEnd(); ++it)
+            runQueue.append(qMakePair(k, it.key()));
+    }
+    startJobs();
+}
+
+// ---------------------------------------------------------------------
+void SpiceOptimizer::writeNetlists(const QString &dir, const QVector<double> &x)
+{
+    for (auto it = netlists.constBegin(); it != netlists.constEnd(); ++it) {
+        QString text = it.value();
+        for (int j = 0; j < variables.count(); j++) {
+            double value = toValue(variables.at(j), x.at(j));
+            text = setParameter(text, variables.at(j).name, QString::number(value,'g',12));
+        }
+        QFile spice_file(dir + QDir::separator() + it.key());
+        if (spice_file.open(QFile::WriteOnly)) {
+            QTextStream stream(&spice_file);
+            stream<<text;
+            spice_file.close();
+        }
+    }
+}
+
+/*!
+ * \brief SpiceOptimizer::setParameter Set the value of a parameter in a
+ *        netlist. The definitions in .PARAM lines and their copies in the
+ *        Ngspice control section are changed, a .PARAM line is added if
+ *        the netlist has none.
+ */
+QString SpiceOptimizer::setParameter(const QString &netlist, const QString &name,
+                                     const QString &value)
+{
+    QString text = netlist;
+    QString var = QRegularExpression::escape(name);
+    QRegularExpression param_rx(QString("^(\\s*\\.(global_)?param\\b.*[\\s,](%1)\\s*=\\s*)"
+                                        "(\\{[^}\\n]*\\}|'[^'\\n]*'|[^\\s,]+)").arg(var),
+                                QRegularExpression::CaseInsensitiveOption |
+                                QRegularExpression::MultilineOption);
+    QRegularExpression let_rx(QString("^(\\s*let\\s+%1\\s*=)[^\\n]*$").arg(var),
+                              QRegularExpression::CaseInsensitiveOption |
+                              QRegularExpression::MultilineOption);
+
+    // replaced from the end, so the positions of earlier matches stay valid
+    QList<QRegularExpressionMatch> matches;
+    QRegularExpressionMatchIterator it = param_rx.globalMatch(text);
+    while (it.hasNext()) matches.prepend(it.next());
+    bool defined = !matches.isEmpty();
+    for (const QRegularExpressionMatch &m : matches)
+        text.replace(m.capturedStart(4), m.capturedLength(4), value);
+
+    matches.clear();
+    it = let_rx.globalMatch(text);
+    while (it.hasNext()) matches.prepend(it.next());
+    for (const QRegularExpressionMatch &m : matches)
+        text.replace(m.capturedEnd(1), m.capturedEnd(0) - m.capturedEnd(1), value);
+
+    if (!defined) { // after the title line
+        int pos = text.indexOf('\n') + 1;
+        text.insert(pos, QString(".PARAM %1=%2\n").arg(name, value));
+    }
+    return text;
+}
+
+// ---------------------------------------------------------------------
+// Starts queued simulations up to the number of processor cores.
+void SpiceOptimizer::startJobs()
+{
+    while (!runQueue.isEmpty() && (Jobs.count() < jobLimit) && !StartFailed) {
+        QPair<int, QString> run = runQueue.takeFirst();
+        QString dir = (run.first < 0) ? workdir : candidateDir(run.first);
+
+        OptJob job;
+        job.candidate = run.first;
+        job.process = new QProcess(this);
+        job.process->setProcessChannelMode(QProcess::MergedChannels);
+        job.process->setStandardOutputFile(dir + QDir::separator() + "spice4qucs.opt.log",
+                                           QIODevice::Append);
+        job.process->setProcessEnvironment(kernel->simulatorEnvironment());
+        job.process->setWorkingDirectory(dir);
+        connect(job.process,SIGNAL(finished(int,QProcess::ExitStatus)),
+                this,SLOT(slotJobFinished(int,QProcess::ExitStatus)));
+        connect(job.process,SIGNAL(errorOccurred(QProcess::ProcessError)),
+                this,SLOT(slotJobError(QProcess::ProcessError)));
+        Jobs.append(job);
+
+        QStringList cmd_args = misc::parseCmdArgs(kernel->simulatorCommand(run.second));
+        QString cmd = cmd_args.takeFirst();
+        job.process->start(cmd,cmd_args);
+    }
+}
+
+/*!
+ * \brief SpiceOptimizer::slotJobFinished Simulator process finished handler.
+ */
+void SpiceOptimizer::slotJobFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    QProcess *process = qobject_cast<QProcess*>(sender());
+    finishJob(process, (exitStatus == QProcess::NormalExit) && (exitCode == 0));
+}
+
+/*!
+ * \brief SpiceOptimizer::slotJobError Simulator process error handler. If
+ *        the simulator cannot be started, the optimization is stopped.
+ */
+void SpiceOptimizer::slotJobError(QProcess::ProcessError err)
+{
+    if (err != QProcess::FailedToStart) return; // finished() follows
+
+    QProcess *process = qobject_cast<QProcess*>(sender());
+    StartFailed = true;
+    int j = findJob(process);
+    if (j >= 0) {
+        Jobs.removeAt(j);
+        process->deleteLater();
+    }
+    killThemAll();
+    emit errors(err);
+}
+
+// ---------------------------------------------------------------------
+int SpiceOptimizer::findJob(QProcess *process)
+{
+    for (int j = 0; j < Jobs.count(); j++)
+        if (Jobs.at(j).process == process) return j;
+    return -1;
+}
+
+// ---------------------------------------------------------------------
+// Evaluates a candidate when all its netlists are simulated.
+void SpiceOptimizer::finishJob(QProcess *process, bool ok)
+{
+    int j = findJob(process);
+    if (j < 0) return;
+    OptJob job = Jobs.takeAt(j);
+    process->deleteLater();
+    if (StartFailed) return; // errors() was emitted already
+
+    int k = job.candidate;
+    if (k < 0) {
+        if (!ok) Result = false;
+    } else {
+        if (!ok && !failedRuns.at(k) && !reportedFailure && !Stopped) {
+            reportedFailure = true; // the first failure shows what is wrong
+            QFile log(candidateDir(k) + QDir::separator() + "spice4qucs.opt.log");
+            if (log.open(QIODevice::ReadOnly)) {
+                output += "Simulation of a candidate failed:\n" + QString(log.readAll());
+                log.close();
+            }
+        }
+        if (!ok) failedRuns[k] = true;
+        if (--pendingRuns[k] == 0)
+            trialCosts[k] = failedRuns.at(k) ? FAILED_COST : computeCost(candidateDir(k));
+    }
+
+    if (!Stopped) startJobs();
+    if (Jobs.isEmpty() && runQueue.isEmpty()) generationFinished();
+}
+
+/*!
+ * \brief SpiceOptimizer::generationFinished Select the members of the next
+ *        generation and stop if the iterations are done or the costs of
+ *        all members are nearly the same.
+ */
+void SpiceOptimizer::generationFinished()
+{
+    if (finalRun) {
+        complete();
+        return;
+    }
+
+    if (costs.isEmpty()) { // initial population
+        costs = trialCosts;
+    } else {
+        for (int i = 0; i < NP; i++) {
+            if (trialCosts.at(i) <= costs.at(i)) {
+                population[i] = trials.at(i);
+                costs[i] = trialCosts.at(i);
+            }
+        }
+        iteration++;
+    }
+    bestIndex = std::min_element(costs.constBegin(), costs.constEnd()) - costs.constBegin();
+
+    if (!std::isfinite(costs.at(bestIndex))) {
+        output += "No candidate could be simulated or evaluated!\n";
+        complete();
+        return;
+    }
+    if ((iteration % refresh) == 0)
+        output += QString("Iteration %1: %2\n").arg(iteration).arg(report(bestIndex));
+    emit progress(std::min(99, iteration * 100 / maxIter));
+
+    if (Stopped) {
+        output += "Optimization stopped\n";
+        complete();
+        return;
+    }
+
+    double mean = 0.0, variance = 0.0;
+    bool converged = true;
+    for (double c : costs) {
+        if (!std::isfinite(c)) converged = false;
+        mean += c / NP;
+    }
+    if (converged) {
+        for (double c : costs) variance += (c - mean) * (c - mean) / NP;
+        converged = (variance < minVariance);
+    }
+    if (converged || (iteration >= maxIter)) {
+        startFinalRun();
+        return;
+    }
+
+    QVector< QVector<double> > next(NP);
+    for (int i = 0; i < NP; i++)
+        next[i] = makeTrial(i);
+    evaluate(next);
+}
+
+// ---------------------------------------------------------------------
+// Simulates the best candidate in the working directory, so its results
+// are converted to a Qucs dataset like the results of a single simulation.
+void SpiceOptimizer::startFinalRun()
+{
+    finalRun = true;
+    Result = true;
+    QFile::remove(workdir + QDir::separator() + "spice4qucs.opt.log");
+    writeNetlists(workdir, population.at(bestIndex));
+    for (auto it = netlists.constBegin(); it != netlists.constEnd(); ++it)
+        runQueue.append(qMakePair(-1, it.key()));
+    startJobs();
+}
+
+// ---------------------------------------------------------------------
+// Stores the best values in the optimization component.
+void SpiceOptimizer::complete()
+{
+    for (int k = 0; k < NP; k++)
+        QDir(candidateDir(k)).removeRecursively();
+
+    if ((bestIndex >= 0) && std::isfinite(costs.at(bestIndex))) {
+        output += QString("Best result: %1\n").arg(report(bestIndex));
+        QHash<QString, QString> values;
+        for (int j = 0; j < variables.count(); j++)
+            values.insert(variables.at(j).name,
+                          formatValue(variables.at(j), population.at(bestIndex).at(j)));
+        if (Opt->setVarValues(values))
+            Sch->setChanged(true, true);
+    }
+
+    if (finalRun) {
+        QFile log(workdir + QDir::separator() + "spice4qucs.opt.log");
+        if (log.open(QIODevice::ReadOnly)) {
+            output += QString(log.readAll());
+            log.close();
+        }
+    }
+
+    emit progress(100);
+    emit finished();
+}
+
+/*!
+ * \brief SpiceOptimizer::computeCost Evaluate the goals on the simulator
+ *        outputs of a candidate. Objectives and constraints are weighted
+ *        with the cost settings. A goal on a vector takes its worst point,
+ *        i.e. the largest value is minimized and the smallest maximized.
+ *        Constraint violations are relative to the goal value.
+ * \param dir Directory of the candidate
+ * \return Cost, infinite if a goal is not in the results
+ */
+double SpiceOptimizer::computeCost(const QString &dir)
+{
+    QHash<QString, QVector<double> > results;
+    kernel->readSimOutputs(dir, results);
+
+    double objective = 0.0, violation = 0.0;
+    for (const OptGoal &goal : goals) {
+        if (goal.type == "MON") continue;
+        QVector<double> values = results.value(goal.name);
+        if (values.isEmpty()) { // SPICE names are case insensitive
+            for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+                if (it.key().compare(goal.name, Qt::CaseInsensitive) == 0) {
+                    values = it.value();
+                    break;
+                }
+            }
+        }
+        if (values.isEmpty()) {
+            if (!missingGoals.contains(goal.name)) {
+                missingGoals.insert(goal.name);
+                output += QString("Goal %1 not found in the simulation results\n").arg(goal.name);
+            }
+            return FAILED_COST;
+        }
+
+        auto range = std::minmax_element(values.constBegin(), values.constEnd());
+        double lo = *range.first, hi = *range.second;
+        double scale = (goal.value != 0.0) ? std::fabs(goal.value) : 1.0;
+        if (goal.type == "MIN") objective += hi;
+        else if (goal.type == "MAX") objective -= lo;
+        else if (goal.type == "LE") violation += std::max(0.0, hi - goal.value) / scale;
+        else if (goal.type == "GE") violation += std::max(0.0, goal.value - lo) / scale;
+        else if (goal.type == "EQ")
+            violation += std::max(std::fabs(hi - goal.value), std::fabs(lo - goal.value)) / scale;
+    }
+
+    double cost = costObj * objective + costConstr * violation;
+    return std::isfinite(cost) ? cost : FAILED_COST;
+}
+
+// ---------------------------------------------------------------------
+QString SpiceOptimizer::candidateDir(int k)
+{
+    return workdir + QDir::separator() + QString("opt%1").arg(k);
+}
+
+// ---------------------------------------------------------------------
+// Converts a point of the search space into a parameter value.
+double SpiceOptimizer::toValue(const OptVariable &var, double x)
+{
+    if (var.type == "LIN_DOUBLE") return x;
+    if (var.type == "LIN_INT") return std::round(x);
+    double value = std::pow(10.0, x);
+    if (var.type == "LOG_INT") return std::round(value);
+    if (var.type.startsWith('E')) return toSeries(value, var.type.mid(1).toInt());
+    return value;
+}
+
+// ---------------------------------------------------------------------
+QString SpiceOptimizer::formatValue(const OptVariable &var, double x)
+{
+    return QString::number(toValue(var, x), 'g', 8);
+}
+
+// ---------------------------------------------------------------------
+QString SpiceOptimizer::report(int k)
+{
+    QString s = QString("cost %1").arg(costs.at(k), 0, 'g', 6);
+    for (int j = 0; j < variables.count(); j++)
+        s += QString(", %1=%2").arg(variables.at(j).name,
+                                    formatValue(variables.at(j), population.at(k).at(j)));
+    return s;
+}
+
+// ---------------------------------------------------------------------
+// Converts a value with unit suffix, e.g. "4.7k", into a plain number.
+double SpiceOptimizer::toNumber(const QString &value, bool *ok)
+{
+    QString s = value.trimmed();
+    if (ok != nullptr) *ok = !s.isEmpty();
+    if (s.isEmpty()) return 0.0;
+    double num, fac;
+    QString unit;
+    misc::str2num(s, num, unit, fac);
+    return num * fac;
+}
+
+/*!
+ * \brief SpiceOptimizer::toSeries Round a value to the nearest value of an
+ *        E-series. E3..E24 are taken from the E24 table, the finer series
+ *        are computed and rounded to three digits.
+ * \param value Positive value
+ * \param n Values per decade, e.g. 12 for E12
+ */
+double SpiceOptimizer::toSeries(double value, int n)
+{
+    static const double E24[] = {1.0, 1.1, 1.2, 1.3, 1.5, 1.6, 1.8, 2.0, 2.2, 2.4, 2.7, 3.0,
+                                 3.3, 3.6, 3.9, 4.3, 4.7, 5.1, 5.6, 6.2, 6.8, 7.5, 8.2, 9.1};
+    if ((value <= 0.0) || (n <= 0)) return value;
+
+    double decade = std::pow(10.0, std::floor(std::log10(value)));
+    double mantissa = value / decade;
+    double nearest = 1.0;
+    for (int i = 0; i <= n; i++) {
+        double m;
+        if (i == n) m = 10.0;
+        else if ((n <= 24) && ((24 % n) == 0)) m = E24[i * (24 / n)];
+        else m = std::round(std::pow(10.0, double(i) / n) * 100.0) / 100.0;
+        if (std::fabs(std::log(m / mantissa)) < std::fabs(std::log(nearest / mantissa)))
+            nearest = m;
+    }
+    return nearest * decade;
+}
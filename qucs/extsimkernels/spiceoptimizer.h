@@ -0,0 +1,156 @@
+/***************************************************************************
+                              spiceoptimizer.h
+                             ------------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SPICEOPTIMIZER_H
+#define SPICEOPTIMIZER_H
+
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <QProcess>
+
+#include <random>
+
+class Schematic;
+class Optimize_Sim;
+class AbstractSpiceKernel;
+
+/*!
+  \file spiceoptimizer.h
+  \brief Declaration of the SpiceOptimizer class
+*/
+
+/*!
+ * \brief The SpiceOptimizer class optimizes a schematic with Ngspice or
+ *        Xyce by differential evolution. It takes the variables, goals
+ *        and settings of the optimization component, which are used by
+ *        ASCO with Qucsator.
+ *
+ *        The netlists are created once. Every candidate of the population
+ *        gets a copy of them in its own directory with only the values of
+ *        the optimized parameters changed, and the candidates of a
+ *        generation are simulated concurrently. The goals are evaluated
+ *        from the simulator outputs read into memory, no Qucs dataset is
+ *        written until the best candidate is simulated in the working
+ *        directory at the end.
+ */
+class SpiceOptimizer : public QObject
+{
+    Q_OBJECT
+private:
+    //! Optimized variable, the search space is logarithmic for log types
+    struct OptVariable {
+        QString name;
+        QString type;    //!< LIN_DOUBLE, LOG_DOUBLE, LIN_INT, LOG_INT or E-series
+        double lower;    //!< bounds in the search space
+        double upper;
+        double init;
+    };
+    //! Optimization goal
+    struct OptGoal {
+        QString name;
+        QString type;    //!< MIN, MAX, LE, GE, EQ or MON
+        double value;
+    };
+    //! One simulator process, running a netlist of a candidate
+    struct OptJob {
+        QProcess *process;
+        int candidate;   //!< -1 for the final run of the best candidate
+    };
+
+    Schematic *Sch;
+    Optimize_Sim *Opt;
+    AbstractSpiceKernel *kernel;
+    QString workdir;
+    QString output;
+
+    QMap<QString, QString> netlists;  // netlist text by file name
+    QList<OptVariable> variables;
+    QList<OptGoal> goals;
+
+    int strategy, maxIter, refresh, NP;
+    double F, CR, minVariance, costObj, costConstr;
+    std::mt19937 rng;
+
+    QVector< QVector<double> > population;
+    QVector< QVector<double> > trials;
+    QVector<double> costs;
+    QVector<double> trialCosts;
+    QVector<int> pendingRuns;    // unfinished simulator runs per candidate
+    QVector<bool> failedRuns;
+    int bestIndex;
+    int iteration;
+
+    QList< QPair<int, QString> > runQueue;  // candidate and netlist to simulate
+    QList<OptJob> Jobs;
+    int jobLimit;
+    bool Stopped;
+    bool StartFailed;
+    bool finalRun;
+    bool Result;      // the best candidate was simulated in the working directory
+    bool reportedFailure;
+    QSet<QString> missingGoals;
+
+    bool readSettings();
+    void initPopulation();
+    QVector<double> makeTrial(int i);
+    void evaluate(const QVector< QVector<double> > &candidates);
+    void writeNetlists(const QString &dir, const QVector<double> &x);
+    void startJobs();
+    int findJob(QProcess *process);
+    void finishJob(QProcess *process, bool ok);
+    void generationFinished();
+    void startFinalRun();
+    void complete();
+    double computeCost(const QString &dir);
+    QString candidateDir(int k);
+    double toValue(const OptVariable &var, double x);
+    QString formatValue(const OptVariable &var, double x);
+    QString report(int k);
+
+    static QString setParameter(const QString &netlist, const QString &name,
+                                const QString &value);
+    static double toNumber(const QString &value, bool *ok = nullptr);
+    static double toSeries(double value, int n);
+
+public:
+    explicit SpiceOptimizer(Schematic *sch, AbstractSpiceKernel *kernel_,
+                            QObject *parent = 0);
+    ~SpiceOptimizer();
+
+    static Optimize_Sim *findOptimization(Schematic *sch);
+    QString getOutput();
+    bool hasResult();
+
+signals:
+    void started();
+    void finished();
+    void errors(QProcess::ProcessError);
+    void progress(int);
+
+private slots:
+    void slotJobFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void slotJobError(QProcess::ProcessError err);
+
+public slots:
+    void slotOptimize();
+    void killThemAll();
+};
+
+#endif // SPICEOPTIMIZER_H
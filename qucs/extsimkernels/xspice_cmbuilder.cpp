@@ -20,6 +20,19 @@
 #include "components/libcomp.h"
 #include "spicecomponents/xsp_cmlib.h"
 #include "main.h"
+#include "qucs.h"
+#include "subcircuitcache.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QPair>
+#include <QProcess>
+#include <QProgressDialog>
+#include <QStandardPaths>
+#include <QThread>
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -32,6 +45,7 @@ XSPICE_CMbuilder::XSPICE_CMbuilder(Schematic *sch_)
     cmsubdir = "qucs_cmlib/";
     cmdir = QDir::toNativeSeparators(workdir+"/"+cmsubdir);
     spinit_name=QDir::toNativeSeparators(workdir+"/.spiceinit");
+    need_compile = -1;
 }
 
 XSPICE_CMbuilder::~XSPICE_CMbuilder()
@@ -71,16 +85,11 @@ void XSPICE_CMbuilder::ExtractSpiceinitdata(QTextStream &stream)
             stream<<((XSP_CMlib *)pc)->getSpiceInit();
         }
         if (pc->Model=="Sub") {
-            Schematic *d = new Schematic(0, ((Subcircuit *)pc)->getSubcircuitFile());
-            if(!d->loadDocument())      // load document if possible
-            {
-                delete d;
-                continue;
-            }
+            Schematic *d = SubcircuitCache::document(((Subcircuit *)pc)->getSubcircuitFile());
+            if(!d) continue;      // load document if possible
             XSPICE_CMbuilder *bld = new XSPICE_CMbuilder(d);
             bld->ExtractSpiceinitdata(stream);
             delete bld;
-            delete d;
         }
     }
 }
@@ -92,6 +101,7 @@ void XSPICE_CMbuilder::ExtractSpiceinitdata(QTextStream &stream)
  */
 bool XSPICE_CMbuilder::needCompile()
 {
+    if (need_compile >= 0) return need_compile; // the schematic was scanned already
     bool r = false;
     for(Component *pc = Sch->DocComps.first(); pc != 0; pc = Sch->DocComps.next()) {
         if (pc->Model=="XSP_CMod") r = true;
@@ -101,18 +111,14 @@ bool XSPICE_CMbuilder::needCompile()
                 (!libpc->getAttachedMOD().isEmpty())) r = true;
         }
         if (pc->Model=="Sub") { // Scan subcircuits recursively
-            Schematic *d = new Schematic(0, ((Subcircuit *)pc)->getSubcircuitFile());
-            if(!d->loadDocument())      // load document if possible
-            {
-                delete d;
-                continue;
-            }
+            Schematic *d = SubcircuitCache::document(((Subcircuit *)pc)->getSubcircuitFile());
+            if(!d) continue;      // load document if possible
             XSPICE_CMbuilder *bld = new XSPICE_CMbuilder(d);
             if (bld->needCompile()) r = true;
             delete bld;
-            delete d;
         }
     }
+    need_compile = r;
     return r;
 }
 
@@ -158,12 +164,8 @@ void XSPICE_CMbuilder::createCModelTree(QString &output)
     QFile mkfile(cmdir+"/Makefile");
     if (mkfile.open(QIODevice::WriteOnly)) {
         QTextStream stream(&mkfile);
-#ifdef __MINGW32__
-        QString rules_file = QucsSettings.BinDir+"../share/" QUCS_NAME "/xspice_cmlib/cmlib.mingw32.rules.mk";
-#else
-        QString rules_file = QucsSettings.BinDir+"../share/" QUCS_NAME "/xspice_cmlib/cmlib.linux.rules.mk";
-#endif
-        QFileInfo inf(rules_file);  
+        QString rules_file = getRulesFile();
+        QFileInfo inf(rules_file);
         if (!inf.exists())
             output += QString("Make rules file %1 doesn't exist\n").arg(rules_file);
         stream<<"TARGET=qucs_xspice.cm\n";
@@ -262,18 +264,13 @@ void XSPICE_CMbuilder::ExtractModIfsFiles(QStringList &objects, QStringList &lst
         }
 
         if (pc->Model=="Sub") { // Scan subcircuits recursively
-            Schematic *d = new Schematic(0, ((Subcircuit *)pc)->getSubcircuitFile());
-            if(!d->loadDocument())      // load document if possible
-            {
-                delete d;
-                continue;
-            }
+            Schematic *d = SubcircuitCache::document(((Subcircuit *)pc)->getSubcircuitFile());
+            if(!d) continue;      // load document if possible
             XSPICE_CMbuilder *bld = new XSPICE_CMbuilder(d);
             bld->setProcessedFiles(mod_ifs_pairs);
             bld->ExtractModIfsFiles(objects,lst_entries,pc->Name,output);
             bld->getProcessedFiles(mod_ifs_pairs);
             delete bld;
-            delete d;
         }
     }
 }
@@ -296,16 +293,11 @@ void XSPICE_CMbuilder::getModIfsFileList(QStringList &files)
             files.append(libpc->getAttachedMOD());
         }
         if (pc->Model=="Sub") { // Scan subcircuits recursively
-            Schematic *d = new Schematic(0, ((Subcircuit *)pc)->getSubcircuitFile());
-            if(!d->loadDocument())      // load document if possible
-            {
-                delete d;
-                continue;
-            }
+            Schematic *d = SubcircuitCache::document(((Subcircuit *)pc)->getSubcircuitFile());
+            if(!d) continue;      // load document if possible
             XSPICE_CMbuilder *bld = new XSPICE_CMbuilder(d);
             bld->getModIfsFileList(files);
             delete bld;
-            delete d;
         }
     }
 }
@@ -331,23 +323,204 @@ QString XSPICE_CMbuilder::normalizeModelName(QString &file, QString &destdir)
 
 /*!
  * \brief Ngspice::compileCMlib Compile all models and obtain qucs_xspice.cm
+ *        The library is taken from the build cache if the same build tree
+ *        was compiled before, in this or an earlier session. Otherwise make
+ *        runs with one job per core and the result is added to the cache.
+ *        The build is killed after MakeTimeout. On the GUI thread a modal
+ *        progress dialog is shown after a moment and allows to abort it.
+ *        Events are only processed while the dialog is shown, so the
+ *        simulation cannot be started again meanwhile.
  */
 void XSPICE_CMbuilder::compileCMlib(QString &output)
 {
+    QString target = cmdir + "qucs_xspice.cm";
+    QString key = cModelTreeHash();
+    QString cached = getCacheDir() + QDir::separator() + key + ".cm";
+    if (QFile::exists(cached) && QFile::copy(cached,target)) {
+        QFile f(cached); // mark as recently used
+        if (f.open(QIODevice::ReadWrite)) {
+            f.setFileTime(QDateTime::currentDateTime(),QFileDevice::FileModificationTime);
+            f.close();
+        }
+        output += QString("Using cached XSPICE CodeModels %1\n").arg(key);
+        return;
+    }
+
     output += "Executing make to build XSPICE CodeModels ...\n";
     output += QString("Working directory is %1\n").arg(cmdir);
 
+    QStringList args;
+    args<<QString("-j%1").arg(QThread::idealThreadCount());
     QProcess *make = new QProcess();
     make->setProcessChannelMode(QProcess::MergedChannels);
     make->setWorkingDirectory(cmdir);
 #ifdef __MINGW32__
-    make->start("mingw32-make.exe",QStringList()); // For Unix
+    make->start("mingw32-make.exe",args); // For Windows
 #else
-    make->start("make",QStringList()); // For Unix
+    make->start("make",args); // For Unix
 #endif
-    make->waitForFinished();
-    output += make->readAll();
+
+    QProgressDialog *progress = nullptr;
+    bool gui = QucsMain && (QThread::currentThread() == QCoreApplication::instance()->thread());
+    QElapsedTimer timer;
+    timer.start();
+    bool stopped = false;
+    while (!make->waitForFinished(100)) {
+        if (make->state() == QProcess::NotRunning) break;
+        if (gui && (progress == nullptr) && (timer.elapsed() >= 500)) {
+            progress = new QProgressDialog(QObject::tr("Building XSPICE CodeModels..."),
+                                           QObject::tr("Abort"), 0, 0, QucsMain);
+            progress->setWindowModality(Qt::ApplicationModal);
+            progress->setMinimumDuration(0);
+            progress->show();
+        }
+        if (progress != nullptr) QCoreApplication::processEvents();
+        bool aborted = (progress != nullptr) && progress->wasCanceled();
+        if (aborted || (timer.elapsed() > MakeTimeout)) {
+            make->kill();
+            make->waitForFinished();
+            output += make->readAll();
+            if (aborted) output += "Build of XSPICE CodeModels aborted.\n";
+            else output += QString("Build of XSPICE CodeModels did not finish within %1 s.\n")
+                           .arg(MakeTimeout/1000);
+            stopped = true;
+            break;
+        }
+    }
+    delete progress;
+    if (!stopped) output += make->readAll();
+    bool ok = !stopped && (make->exitStatus() == QProcess::NormalExit) &&
+              (make->exitCode() == 0);
     delete make;
+
+    if (ok && QFile::exists(target)) storeInCache(cached);
+}
+
+/*!
+ * \brief XSPICE_CMbuilder::cModelTreeHash Key of the build cache. Hashes
+ *        the names and contents of all files in the build tree and the
+ *        make rules, and the Ngspice and compiler the library is built
+ *        with, see toolchainId(). The build directory itself is left out of
+ *        the key, so equal models share the library across working
+ *        directories.
+ * \return SHA-1 hex digest
+ */
+QString XSPICE_CMbuilder::cModelTreeHash()
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    QByteArray root = QDir(cmdir).absolutePath().toUtf8();
+    hash.addData(toolchainId().toUtf8());
+
+    QStringList files;
+    QDirIterator it(cmdir, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) files.append(QDir(cmdir).relativeFilePath(it.next()));
+    files.sort();
+    files.append(getRulesFile());
+
+    for (const QString &name : files) {
+        QFile f(QFileInfo(name).isAbsolute() ? name : cmdir + name);
+        if (!f.open(QIODevice::ReadOnly)) continue;
+        QByteArray data = f.readAll();
+        f.close();
+        data.replace(root, "$(CMDIR)");
+        hash.addData(name.toUtf8());
+        hash.addData(QByteArray::number(data.size()));
+        hash.addData(data);
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+/*!
+ * \brief XSPICE_CMbuilder::storeInCache Add the compiled library to the
+ *        build cache. The file is renamed into place, so concurrent
+ *        simulations never load a partly written library. Only the most
+ *        recently used libraries are kept.
+ * \param cached[in] File name of the cache entry
+ */
+void XSPICE_CMbuilder::storeInCache(const QString &cached)
+{
+    QDir cache_dir(getCacheDir());
+    if (!cache_dir.exists()) cache_dir.mkpath(".");
+
+    QString tmp = cached + QString(".%1.tmp").arg(QCoreApplication::applicationPid());
+    QFile::remove(tmp);
+    if (!QFile::copy(cmdir + "qucs_xspice.cm", tmp)) return;
+    if (!QFile::rename(tmp, cached)) QFile::remove(tmp); // stored by another process
+
+    const int max_entries = 32;
+    QFileInfoList entries = cache_dir.entryInfoList(QStringList("*.cm"), QDir::Files, QDir::Time);
+    for (int i = max_entries; i < entries.count(); i++)
+        QFile::remove(entries.at(i).absoluteFilePath());
+}
+
+/*!
+ * \brief XSPICE_CMbuilder::toolchainId Versions of Ngspice and of the C
+ *        compiler, the code model library depends on the ABI of both. The
+ *        programs are asked once per executable, identified by path, size
+ *        and modification time.
+ */
+QString XSPICE_CMbuilder::toolchainId()
+{
+#ifdef __MINGW32__
+    QString cc = "gcc.exe";
+#else
+    QString cc = "gcc";
+#endif
+    QFileInfo ngspice(QucsSettings.NgspiceExecutable);
+    if (ngspice.isRelative() && !ngspice.exists())
+        ngspice.setFile(QucsSettings.BinDir + QucsSettings.NgspiceExecutable);
+    if (!ngspice.exists())
+        ngspice.setFile(QStandardPaths::findExecutable(QucsSettings.NgspiceExecutable));
+    QFileInfo compiler(QStandardPaths::findExecutable(cc));
+
+    QString id;
+    for (const QFileInfo &exe : {ngspice, compiler})
+        id += exe.absoluteFilePath() + '\n' + QString::number(exe.size()) + '\n' +
+              QString::number(exe.lastModified().toMSecsSinceEpoch()) + '\n';
+
+    static QString lastId, lastVersions;
+    if (id == lastId) return id + lastVersions;
+
+    QString versions;
+    QList<QPair<QFileInfo, QStringList> > programs;
+    programs << qMakePair(ngspice, QStringList("-v"))
+             << qMakePair(compiler, QStringList("--version"));
+    for (const auto &prog : programs) {
+        if (!prog.first.exists()) continue;
+        QProcess proc;
+        proc.setProcessChannelMode(QProcess::MergedChannels);
+        proc.start(prog.first.absoluteFilePath(), prog.second);
+        if (proc.waitForFinished(5000))
+            versions += QString::fromLocal8Bit(proc.readAll());
+        else
+            proc.kill();
+    }
+    lastId = id;
+    lastVersions = versions;
+    return id + versions;
+}
+
+/*!
+ * \brief XSPICE_CMbuilder::getRulesFile Make rules of the code model build
+ *        shipped with Qucs-S.
+ */
+QString XSPICE_CMbuilder::getRulesFile()
+{
+#ifdef __MINGW32__
+    return QucsSettings.BinDir+"../share/" QUCS_NAME "/xspice_cmlib/cmlib.mingw32.rules.mk";
+#else
+    return QucsSettings.BinDir+"../share/" QUCS_NAME "/xspice_cmlib/cmlib.linux.rules.mk";
+#endif
+}
+
+/*!
+ * \brief XSPICE_CMbuilder::getCacheDir Directory of the code model build
+ *        cache. It is kept in the Qucs home directory, so it survives the
+ *        session and is shared by all simulator working directories.
+ */
+QString XSPICE_CMbuilder::getCacheDir()
+{
+    return QucsSettings.QucsHomeDir.absolutePath() + QDir::separator() + "cmcache";
 }
 
 /*!
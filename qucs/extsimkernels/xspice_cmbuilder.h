@@ -31,10 +31,13 @@ private:
     QString workdir,spinit_name;
 
     QList<QStringList> mod_ifs_pairs;
+    int need_compile;   // result of needCompile(), -1 if not scanned yet
 
     Schematic *Sch;
 
 public:
+    static const int MakeTimeout = 600000;  // ms, limit of one build
+
     XSPICE_CMbuilder(Schematic *sch_);
     ~XSPICE_CMbuilder();
 
@@ -58,6 +61,11 @@ private:
                             const QString &prefix, QString &output);
     bool ModIfsPairProcessed(const QString &mod, const QString &ifs);
     static QString getNgspiceRoot();
+    static QString getRulesFile();
+    static QString getCacheDir();
+    static QString toolchainId();
+    QString cModelTreeHash();
+    void storeInCache(const QString &cached);
 };
 
 #endif // XSPICE_CMBUILDER_H
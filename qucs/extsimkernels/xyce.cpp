@@ -21,6 +21,11 @@
 #include "main.h"
 #include "misc.h"
 
+#include <QSet>
+#include <QThread>
+
+#include <algorithm>
+
 
 /*!
   \file xyce.cpp
@@ -38,6 +43,9 @@ Xyce::Xyce(Schematic *sch_, QObject *parent) :
     simulator_cmd = QucsSettings.XyceExecutable;
     Nprocs = QucsSettings.NProcs;
     Noisesim = false;
+    Parallel = false;
+    StartFailed = false;
+    queueSize = finishedJobs = 0;
 }
 
 /*!
@@ -69,33 +77,36 @@ void Xyce::determineUsedSimulations(QStringList *sim_lst)
 }
 
 /*!
- * \brief Xyce::createNetlist
- * \param[out] stream QTextStream that associated with spice netlist file
- * \param[in] simulations The list of simulations that need to included in netlist.
+ * \brief Xyce::createNetlistBody Build the part of the netlist that is common
+ *        for all analyses: node names, subcircuits, parameters, components
+ *        and models. Also determine the output variables.
+ * \param[out] body Netlist body text
  * \param[out] vars The list of output variables and node names.
- * \param[out] outputs The list of spice output raw text files.
+ * \return true if success, false if netlist preparation fails
  */
-void Xyce::createNetlist(QTextStream &stream, int , QStringList &simulations,
-                    QStringList &vars, QStringList &outputs)
+bool Xyce::createNetlistBody(QString &body, QStringList &vars)
 {
-    QString s;
-    bool hasParSweep = false;
-
-    if(!prepareSpiceNetlist(stream)) return; // Unable to perform spice simulation
+    body.clear();
+    QTextStream stream(&body);
+    if(!prepareSpiceNetlist(stream)) return false; // Unable to perform spice simulation
     startNetlist(stream,true);
+    stream.flush();
 
     // set variable names for named nodes and wires
     vars.clear();
+    QSet<QString> known_vars;
     for(Node *pn = Sch->DocNodes.first(); pn != 0; pn = Sch->DocNodes.next()) {
       if(pn->Label != 0) {
-          if (!vars.contains(pn->Label->Name)) {
+          if (!known_vars.contains(pn->Label->Name)) {
+              known_vars.insert(pn->Label->Name);
               vars.append(pn->Label->Name);
           }
       }
     }
     for(Wire *pw = Sch->DocWires.first(); pw != 0; pw = Sch->DocWires.next()) {
       if(pw->Label != 0) {
-          if (!vars.contains(pw->Label->Name)) {
+          if (!known_vars.contains(pw->Label->Name)) {
+              known_vars.insert(pw->Label->Name);
               vars.append(pw->Label->Name);
           }
       }
@@ -103,7 +114,8 @@ void Xyce::createNetlist(QTextStream &stream, int , QStringList &simulations,
     for(Component *pc = Sch->DocComps.first(); pc != 0; pc = Sch->DocComps.next()) {
         if (pc->isProbe) {
             QString var_pr = pc->getProbeVariable(true);
-            if (!vars.contains(var_pr)) {
+            if (!known_vars.contains(var_pr)) {
+                known_vars.insert(var_pr);
                 vars.append(var_pr);
             }
         }
@@ -118,7 +130,8 @@ void Xyce::createNetlist(QTextStream &stream, int , QStringList &simulations,
     if (DC_OP_only) {
         // Add all remaining nodes, because XYCE has no equivalent for PRINT ALL
         for(Node* pn = Sch->Nodes->first(); pn != 0; pn = Sch->Nodes->next()) {
-            if ((!vars.contains(pn->Name))&&(pn->Name!="gnd")) {
+            if ((!known_vars.contains(pn->Name))&&(pn->Name!="gnd")) {
+                known_vars.insert(pn->Name);
                 vars.append(pn->Name);
             }
         }
@@ -131,6 +144,43 @@ void Xyce::createNetlist(QTextStream &stream, int , QStringList &simulations,
     }
 
     vars.sort();
+    return true;
+}
+
+/*!
+ * \brief Xyce::createNetlist
+ * \param[out] stream QTextStream that associated with spice netlist file
+ * \param[in] simulations The list of simulations that need to included in netlist.
+ * \param[out] vars The list of output variables and node names.
+ * \param[out] outputs The list of spice output raw text files.
+ */
+void Xyce::createNetlist(QTextStream &stream, int , QStringList &simulations,
+                    QStringList &vars, QStringList &outputs)
+{
+    QString body;
+    if (!createNetlistBody(body, vars)) {
+        stream<<body;
+        return; // Unable to perform spice simulation
+    }
+    createAnalysisNetlist(stream, body, simulations, vars, outputs);
+}
+
+/*!
+ * \brief Xyce::createAnalysisNetlist Output the netlist body followed by
+ *        the control section of a single analysis.
+ * \param[out] stream QTextStream that associated with spice netlist file
+ * \param[in] body Netlist body built by createNetlistBody()
+ * \param[in] simulations The list of simulations that need to included in netlist.
+ * \param[in] vars The list of output variables and node names.
+ * \param[out] outputs The list of spice output raw text files.
+ */
+void Xyce::createAnalysisNetlist(QTextStream &stream, const QString &body,
+                                 QStringList &simulations, const QStringList &vars,
+                                 QStringList &outputs)
+{
+    bool hasParSweep = false;
+
+    stream<<body;
 
     //execute simulations
 
@@ -270,7 +320,8 @@ void Xyce::createNetlist(QTextStream &stream, int , QStringList &simulations,
 
 /*!
  * \brief Xyce::slotSimulate Execute Xyce simulator and perform all
- *        simulations from the simulationQueue list
+ *        simulations from the simulationQueue list. The analyses are
+ *        independent of each other and run concurrently, see jobLimit().
  */
 void Xyce::slotSimulate()
 {
@@ -300,7 +351,6 @@ void Xyce::slotSimulate()
         return;
     }
 
-    int num=0;
     netlistQueue.clear();
     output_files.clear();
 
@@ -311,6 +361,15 @@ void Xyce::slotSimulate()
     QFile::remove(workdir+"spice4qucs.sens_tr.cir.SENS.prn");
     QFile::remove(workdir+"spice4qucs.sens_tr.cir.TRADJ.prn");
 
+    // The circuit is the same for all analyses, only the control
+    // section differs. Build it once and reuse it for every netlist.
+    QString body;
+    if (!createNetlistBody(body, vars)) {
+        emit finished();
+        emit errors(QProcess::FailedToStart);
+        return;
+    }
+
     for (const QString& sim : simulationsQueue) {
         QStringList sim_lst;
         sim_lst.clear();
@@ -320,12 +379,26 @@ void Xyce::slotSimulate()
         QFile spice_file(tmp_path);
         if (spice_file.open(QFile::WriteOnly)) {
             QTextStream stream(&spice_file);
-            createNetlist(stream,num,sim_lst,vars,output_files);
+            createAnalysisNetlist(stream,body,sim_lst,vars,output_files);
             spice_file.close();
         }
     }
 
-    output.clear();
+    clearOutput();
+    if (useCachedResult(netlistQueue)) return;
+
+    qDeleteAll(jobLogs);
+    jobLogs.clear();
+    for (int i = 0; i < netlistQueue.count(); i++) {
+        SimLog *log = new SimLog(this);
+        log->setFileName(workdir + QDir::separator() + QString("spice4qucs.job%1.log").arg(i));
+        log->clear();
+        jobLogs.append(log);
+    }
+    queueSize = netlistQueue.count();
+    finishedJobs = 0;
+    Noisesim = false;
+    StartFailed = false;
     emit started();
     nextSimulation();
 
@@ -349,41 +422,73 @@ void Xyce::SaveNetlist(QString filename)
 }
 
 /*!
- * \brief Xyce::slotFinished Simulator finished handler. End simulation or
- *        execute the next simulation from queue.
+ * \brief Xyce::createNetlists Create one netlist per analysis without
+ *        starting Xyce.
+ * \param[out] netlists Netlist text by file name, spice4qucs.<analysis>.cir
+ * \return False if the schematic cannot be simulated
  */
-void Xyce::slotFinished()
-{ 
-    output += SimProcess->readAllStandardOutput();;
+bool Xyce::createNetlists(QMap<QString, QString> &netlists)
+{
+    netlists.clear();
+    clearOutput();
+    output_files.clear();
 
-    if (Noisesim) {
-        QFile logfile(workdir + QDir::separator() + "spice4qucs.noise_log");
-        if (logfile.open(QIODevice::WriteOnly)) {
-            QTextStream ts(&logfile);
-            ts<<output;
-            logfile.close();
-        }
-        Noisesim = false;
-        output_files.append("spice4qucs.noise_log");
+    QStringList incompat;
+    if (!checkSchematic(incompat)) {
+        output.append("There were SPICE-incompatible components. Simulator cannot proceed.");
+        output.append("Incompatible components are: " + incompat.join("; ") + "\n");
+        return false;
+    }
+    if (!checkGround()) {
+        output.append("No Ground found. Please add at least one ground!\n");
+        return false;
     }
 
-    if (netlistQueue.isEmpty()) {
-        emit finished();
-        emit progress(100);
-        return;
-    } else {
-        nextSimulation();
+    QString body;
+    if (!createNetlistBody(body, vars)) return false;
+
+    QStringList sim_queue;
+    simulationsQueue.clear();
+    determineUsedSimulations(&sim_queue);
+    for (const QString& sim : sim_queue) {
+        QStringList sim_lst(sim);
+        QString text;
+        QTextStream stream(&text);
+        createAnalysisNetlist(stream,body,sim_lst,vars,output_files);
+        stream.flush();
+        netlists.insert("spice4qucs."+sim+".cir",text);
     }
+    return !netlists.isEmpty();
+}
+
+/*!
+ * \brief Xyce::simulatorCommand Command line that simulates a netlist.
+ *        The command may be a MPI launcher followed by the Xyce executable.
+ */
+QString Xyce::simulatorCommand(const QString &netlist)
+{
+    return QString("%1 %2 \"%3\"").arg(simulator_cmd,simulator_parameters,netlist);
+}
+
+/*!
+ * \brief Xyce::slotFinished Simulator finished handler. Collect the output
+ *        of the analysis and start the next one from the queue. When the
+ *        last analysis is finished, the outputs are merged in queue order.
+ */
+void Xyce::slotFinished()
+{
+    finishJob(qobject_cast<QProcess*>(sender()));
 }
 
 bool Xyce::waitEndOfSimulation()
 {
-    bool ok = false;
-    while (!netlistQueue.isEmpty()) {
-        ok = SimProcess->waitForFinished(10000);
+    if (ResultCached) return true; // no simulator was started
+    while (!Jobs.isEmpty()) {
+        QProcess *process = Jobs.first().process;
+        if (!process->waitForFinished(-1) && findJob(process) >= 0)
+            finishJob(process);  // already finished, event not delivered yet
     }
-    ok = SimProcess->waitForFinished(10000);
-    return ok;
+    return !StartFailed;
 }
 
 /*!
@@ -391,40 +496,176 @@ bool Xyce::waitEndOfSimulation()
  */
 void Xyce::slotProcessOutput()
 {
+    QProcess *process = qobject_cast<QProcess*>(sender());
+    int j = findJob(process);
+    if (j < 0) return;
+
     //***** Percent complete: 85.4987 %
-    QString s = SimProcess->readAllStandardOutput();
-    if (s.contains("Percent complete:")) {
-        int percent = round(s.section(' ',3,3,QString::SectionSkipEmpty).toFloat());
-        emit progress(percent);
+    QString s = process->readAllStandardOutput();
+    int percent = Jobs[j].progress.scan(s);
+    if (percent >= 0) {
+        Jobs[j].percent = percent;
+        reportProgress();
     }
-    output += s;
+    jobLogs.at(Jobs.at(j).index)->append(s);
+}
+
+/*!
+ * \brief Xyce::slotJobError Simulator error handler. If Xyce cannot be
+ *        started, the remaining analyses are dropped as they would fail
+ *        the same way.
+ */
+void Xyce::slotJobError(QProcess::ProcessError err)
+{
+    QProcess *process = qobject_cast<QProcess*>(sender());
+    ResultKey.clear();
+    SimFailed = true;
+    emit errors(err);
+    if (err != QProcess::FailedToStart) return;  // finished() follows
+
+    StartFailed = true;
+    int j = findJob(process);
+    if (j >= 0) {
+        Jobs.removeAt(j);
+        process->deleteLater();
+    }
+    killThemAll();
+}
 
+/*!
+ * \brief Xyce::killThemAll Stop all running analyses and drop the queue.
+ */
+void Xyce::killThemAll()
+{
+    netlistQueue.clear();
+    QList<XyceJob> jobs = Jobs;
+    for (const XyceJob &job : jobs) {
+        if (job.process->state() != QProcess::NotRunning)
+            job.process->kill();
+    }
+    AbstractSpiceKernel::killThemAll();
 }
 
 /*!
- * \brief Xyce::nextSimulation Execute the next simulation from queue.
+ * \brief Xyce::nextSimulation Start simulations from the queue until the
+ *        job limit is reached.
  */
 void Xyce::nextSimulation()
 {
-    if (!netlistQueue.isEmpty()) {
+    if (netlistQueue.isEmpty()) {
+        if (Jobs.isEmpty()) {
+            output += "No simulations!\n"
+                      "Exiting...\n";
+            emit progress(100);
+            emit finished(); // nothing to simulate
+        }
+        return;
+    }
+
+    int limit = jobLimit();
+    while (!netlistQueue.isEmpty() && Jobs.count() < limit) {
         QString file = netlistQueue.takeFirst();
-        if (file.endsWith(".noise.cir")) Noisesim = true;
-        SimProcess->setWorkingDirectory(workdir);
-        QString cmd = QString("%1 %2 \"%3\"").arg(simulator_cmd,simulator_parameters,file);
+        XyceJob job;
+        job.index = queueSize - netlistQueue.count() - 1;
+        job.percent = 0;
+        job.progress = SimProgressScanner("Percent complete:");
+        job.noise = file.endsWith(".noise.cir");
+        job.process = new QProcess(this);
+        job.process->setProcessChannelMode(QProcess::MergedChannels);
+        job.process->setWorkingDirectory(workdir);
+        connect(job.process,SIGNAL(finished(int)),this,SLOT(slotFinished()));
+        connect(job.process,SIGNAL(readyRead()),this,SLOT(slotProcessOutput()));
+        connect(job.process,SIGNAL(errorOccurred(QProcess::ProcessError)),
+                this,SLOT(slotJobError(QProcess::ProcessError)));
+        Jobs.append(job);
+
+        QString cmd = simulatorCommand(file);
         QStringList cmd_args = misc::parseCmdArgs(cmd);
         QString xyce_cmd = cmd_args.at(0);
         cmd_args.removeAt(0);
-        SimProcess->start(xyce_cmd,cmd_args);
-    } else {
-        output += "No simulations!\n"
-                  "Exiting...\n";
-        emit progress(100);
-        emit finished(); // nothing to simulate
+        job.process->start(xyce_cmd,cmd_args);
+    }
+}
+
+/*!
+ * \brief Xyce::jobLimit Number of analyses which may run at the same time.
+ *        A parallel Xyce run occupies NProcs cores, so fewer of them are
+ *        started. The limit set in the simulator settings is an upper bound.
+ */
+int Xyce::jobLimit()
+{
+    int perJob = Parallel ? std::max(1u, Nprocs) : 1;
+    int limit = std::max(1, QThread::idealThreadCount() / perJob);
+    if (QucsSettings.XyceJobs > 0)
+        limit = std::min(limit, (int) QucsSettings.XyceJobs);
+    return limit;
+}
+
+// ---------------------------------------------------------------------
+int Xyce::findJob(QProcess *process)
+{
+    for (int j = 0; j < Jobs.count(); j++)
+        if (Jobs.at(j).process == process) return j;
+    return -1;
+}
+
+// ---------------------------------------------------------------------
+void Xyce::finishJob(QProcess *process)
+{
+    int j = findJob(process);
+    if (j < 0) return;
+    XyceJob job = Jobs.takeAt(j);
+    QString s = process->readAllStandardOutput();
+    job.progress.scan(s);
+    SimLog *log = jobLogs.at(job.index);
+    log->append(s + job.progress.remainder());
+    log->flush();
+    if ((process->exitStatus() != QProcess::NormalExit) || (process->exitCode() != 0)) {
+        ResultKey.clear();
+        SimFailed = true;
+    }
+    if (log->hasErrors()) SimFailed = true;  // the beginning may be dropped below
+    process->deleteLater();
+    finishedJobs++;
+
+    if (job.noise) {  // the noise results are parsed from the whole output
+        QString logfile = workdir + QDir::separator() + "spice4qucs.noise_log";
+        QFile::remove(logfile);
+        QFile::copy(log->fileName(), logfile);
+        Noisesim = true;
+    }
+
+    if (!netlistQueue.isEmpty()) nextSimulation();
+    if (!Jobs.isEmpty()) {
+        reportProgress();
+        return;
+    }
+
+    for (SimLog *log : jobLogs)  // the whole outputs stay in the job logs
+        appendOutput(log->text());
+    if (Noisesim) {
+        output_files.append("spice4qucs.noise_log");
+        Noisesim = false;
     }
+    if (StartFailed) return;  // errors() was emitted already
+    emit finished();
+    emit progress(100);
+}
+
+// ---------------------------------------------------------------------
+// Progress of all analyses, finished ones count as 100 percent.
+void Xyce::reportProgress()
+{
+    if (queueSize <= 0) return;
+    int sum = finishedJobs * 100;
+    for (const XyceJob &job : Jobs)
+        sum += job.percent;
+    emit progress(sum / queueSize);
 }
 
 void Xyce::setParallel(bool par)
 {
+    Parallel = par;
     if (par) {
         QString xyce_par = QucsSettings.XyceParExecutable;
         xyce_par.replace("%p",QString::number(QucsSettings.NProcs));
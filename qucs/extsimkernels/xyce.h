@@ -36,30 +36,58 @@ class Xyce : public AbstractSpiceKernel
 {
     Q_OBJECT
 private:
+    //! One running analysis of the queue
+    struct XyceJob {
+        QProcess *process;
+        int index;       //!< position in the analysis queue
+        int percent;     //!< progress reported by Xyce
+        SimProgressScanner progress;
+        bool noise;      //!< noise analysis, output goes into the noise log
+    };
+
     bool Noisesim;
+    bool Parallel;
+    bool StartFailed;
 
     unsigned int Nprocs;
     QStringList simulationsQueue;
     QStringList netlistQueue;
+    QList<XyceJob> Jobs;      // running analyses
+    QList<SimLog*> jobLogs;   // simulator output per analysis in queue order
+    int queueSize;
+    int finishedJobs;
+
     void nextSimulation();
+    int jobLimit();
+    int findJob(QProcess *process);
+    void finishJob(QProcess *process);
+    void reportProgress();
+    bool createNetlistBody(QString &body, QStringList &vars);
+    void createAnalysisNetlist(QTextStream &stream, const QString &body,
+                               QStringList &simulations, const QStringList &vars,
+                               QStringList &outputs);
 
 public:
     void determineUsedSimulations(QStringList *sim_lst = NULL);
     explicit Xyce(Schematic *sch_, QObject *parent = 0);
 
     void SaveNetlist(QString filename);
+    bool createNetlists(QMap<QString, QString> &netlists);
+    QString simulatorCommand(const QString &netlist);
     void setParallel(bool par);
     bool waitEndOfSimulation();
-    
+
 protected:
     void createNetlist(QTextStream &stream, int NumPorts, QStringList &simulations,
                   QStringList &vars, QStringList &outputs);
 protected slots:
     void slotFinished();
     void slotProcessOutput();
+    void slotJobError(QProcess::ProcessError err);
 
 public slots:
     void slotSimulate();
+    void killThemAll();
     
 };
 
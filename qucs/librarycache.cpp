@@ -0,0 +1,292 @@
+/***************************************************************************
+                             librarycache.cpp
+                            ------------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "librarycache.h"
+#include "main.h"
+#include "misc.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QRegularExpression>
+
+#include <algorithm>
+
+/*!
+  \file librarycache.cpp
+  \brief Implementation of the LibraryCache class
+*/
+
+QMutex LibraryCache::Mutex;
+QHash<QString, LibraryCache::Entry> LibraryCache::Libraries;
+quint64 LibraryCache::UseCounter = 0;
+
+// sections extracted when a library is parsed, others are looked up
+// in the component text on request
+static const char *PreparsedSections[] = {
+    "Symbol", "Model", "Spice", "VHDLModel", "VerilogModel", 0 };
+
+/*!
+ * \brief LibraryCache::library Return the parsed library file. The file is
+ *        read on the first request and again only if its modification time
+ *        has changed.
+ * \param file Absolute library file name
+ * \return Parsed library or a null pointer if the file cannot be read.
+ */
+LibraryCache::LibraryPtr LibraryCache::library(const QString &file)
+{
+    QDateTime mtime = QFileInfo(file).lastModified();
+
+    Mutex.lock();
+    QHash<QString, Entry>::iterator it = Libraries.find(file);
+    if (it != Libraries.end() && it->mtime == mtime) {
+        it->used = ++UseCounter;
+        LibraryPtr lib = it->lib;
+        Mutex.unlock();
+        return lib;
+    }
+    Mutex.unlock();
+
+    // parse without holding the lock, other libraries stay available
+    LibraryPtr lib = parse(file);
+    if (lib.isNull()) return lib;
+
+    Entry entry;
+    entry.lib = lib;
+    entry.mtime = mtime;
+    Mutex.lock();
+    entry.used = ++UseCounter;
+    Libraries.insert(file, entry);
+    trim();
+    Mutex.unlock();
+    return lib;
+}
+
+/*!
+ * \brief LibraryCache::section Look up one section of a library component.
+ *        Same semantics and error codes as the former file based
+ *        LibComp::loadSection(): the library default symbol is returned
+ *        for a component without own symbol.
+ * \param file Absolute library file name
+ * \param component Component name
+ * \param name Section name, e.g. "Model"
+ * \param text Section text
+ * \param Includes If given, the files of the <nameIncludes> tag are appended
+ * \param Attach If given, the files of the <nameAttach> tag are appended
+ * \return 0 on success, negative error code otherwise
+ */
+int LibraryCache::section(const QString &file, const QString &component,
+                          const QString &name, QString &text,
+                          QStringList *Includes, QStringList *Attach)
+{
+    LibraryPtr lib = library(file);
+    if (lib.isNull()) return -1;
+    if (lib->headerError < 0) return lib->headerError;
+
+    VersionTriplet LibVersion = VersionTriplet(lib->version);
+    if (LibVersion > QucsVersion) {// wrong version number ?
+        if (!QucsSettings.IgnoreFutureVersion) {
+            return -3;
+        }
+    }
+    if (name == "Symbol" && lib->defaultSymbolCorrupt) return -9;
+
+    int i = lib->index.value(component, -1);
+    if (i < 0) return -4;  // component not found
+    const Component &comp = lib->components.at(i);
+
+    QHash<QString, Section>::const_iterator it = comp.sections.constFind(name);
+    Section s = (it != comp.sections.constEnd()) ? *it :
+        parseSection(comp.definition.mid(comp.bodyStart, comp.bodyLength), name);
+
+    if (Includes) {
+        if (s.includesError < 0) return s.includesError;
+        *Includes += s.includes;
+    }
+    if (Attach) {
+        if (s.attachError < 0) return s.attachError;
+        *Attach += s.attach;
+    }
+
+    if (s.error == -7 && name == "Symbol" && !lib->defaultSymbol.isEmpty()) {
+        // component does not define its own symbol but the library defines a default symbol
+        text = lib->defaultSymbol;
+        return 0;
+    }
+    if (s.error < 0) return s.error;
+    text = s.text;
+    return 0;
+}
+
+// ---------------------------------------------------------------------
+void LibraryCache::clear()
+{
+    QMutexLocker locker(&Mutex);
+    Libraries.clear();
+}
+
+// ---------------------------------------------------------------------
+// Drops the libraries whose files were modified or deleted and the least
+// recently used ones beyond MaxLibraries. Called with the mutex locked.
+void LibraryCache::trim()
+{
+    for (auto it = Libraries.begin(); it != Libraries.end(); ) {
+        QFileInfo inf(it.key());
+        if (!inf.exists() || (inf.lastModified() != it->mtime))
+            it = Libraries.erase(it);
+        else ++it;
+    }
+    if (Libraries.size() <= MaxLibraries) return;
+
+    QList<quint64> stamps;
+    for (const Entry &entry : Libraries) stamps.append(entry.used);
+    std::sort(stamps.begin(), stamps.end());
+    quint64 oldest = stamps.at(Libraries.size() - MaxLibraries - 1);
+    for (auto it = Libraries.begin(); it != Libraries.end(); ) {
+        if (it->used <= oldest) it = Libraries.erase(it);
+        else ++it;
+    }
+}
+
+// ---------------------------------------------------------------------
+// Reads the library file and splits it into its components.
+LibraryCache::LibraryPtr LibraryCache::parse(const QString &file)
+{
+    QFile File(file);
+    if (!File.open(QIODevice::ReadOnly))
+        return LibraryPtr();
+
+    QTextStream ReadWhole(&File);
+    QString LibraryString = ReadWhole.readAll();
+    File.close();
+    LibraryString.replace(QRegularExpression("\\r\\n"), "\n");
+
+    QSharedPointer<Library> lib(new Library);
+    lib->headerError = 0;
+    lib->headerFound = false;
+    lib->empty = false;
+    lib->defaultSymbolCorrupt = false;
+
+    // version line as checked by LibComp
+    int Start, End = LibraryString.indexOf(' ', 14);
+    if (LibraryString.left(14) != "<Qucs Library ")
+        lib->headerError = -2;
+    else if (End < 15)
+        lib->headerError = -3;
+    else
+        lib->version = LibraryString.mid(14, End-14);
+
+    // header statement: <Qucs Library 0.0.18 "libname">
+    Start = LibraryString.indexOf("<Qucs Library ");
+    if (Start < 0) return lib;
+    End = LibraryString.indexOf('>', Start);
+    if (End < 0) return lib;
+    lib->headerFound = true;
+    lib->name = LibraryString.mid(Start, End-Start).section('"', 1, 1);
+
+    Start = LibraryString.indexOf("\n<", End);
+    if (Start < 0) {
+        lib->empty = true;
+        return lib;
+    }
+
+    // libraries can have a default symbol section
+    if (LibraryString.mid(Start+2, 14) == "DefaultSymbol>") {
+        End = LibraryString.indexOf("\n</DefaultSymbol>", Start);
+        if (End < 0) {
+            lib->defaultSymbolCorrupt = true;
+            return lib;
+        }
+        lib->defaultSymbol = LibraryString.mid(Start+16, End-Start-16);
+        Start = End + 3;
+    }
+
+    int NameStart, NameEnd;
+    while ((Start = LibraryString.indexOf("\n<Component ", Start)) > 0) {
+        Start++;
+        NameStart = Start + 11;
+        NameEnd = LibraryString.indexOf('>', NameStart);
+        if (NameEnd < 0) continue;
+
+        End = LibraryString.indexOf("\n</Component>", NameEnd);
+        if (End < 0) continue;
+
+        Component comp;
+        comp.name = LibraryString.mid(NameStart, NameEnd-NameStart);
+        comp.definition = LibraryString.mid(Start, End+13-Start);
+        comp.bodyStart = comp.definition.indexOf('\n') + 1;
+        comp.bodyLength = End - Start + 1 - comp.bodyStart;
+
+        QString body = comp.definition.mid(comp.bodyStart, comp.bodyLength);
+        for (int i = 0; PreparsedSections[i]; i++) {
+            QString name = QString::fromLatin1(PreparsedSections[i]);
+            comp.sections.insert(name, parseSection(body, name));
+        }
+
+        if (!lib->index.contains(comp.name))
+            lib->index.insert(comp.name, lib->components.size());
+        lib->components.append(comp);
+
+        Start = End + 13;
+    }
+
+    return lib;
+}
+
+// ---------------------------------------------------------------------
+// Extracts the section "name" and its include and attach lists from
+// the text of one component.
+LibraryCache::Section LibraryCache::parseSection(const QString &body,
+                                                 const QString &name)
+{
+    Section s;
+    s.includesError = parseFileList(body, "<"+name+"Includes", s.includes);
+    s.attachError = parseFileList(body, "<"+name+"Attach", s.attach);
+
+    int Start = body.indexOf("<"+name+">");
+    if (Start < 0) return s;  // -7, section not found
+    Start = body.indexOf('\n', Start);
+    if (Start < 0) {
+        s.error = -8;  // file corrupt
+        return s;
+    }
+    do Start++; while (Start < body.length() && body.at(Start) == ' ');
+    int End = body.indexOf("</"+name+">", Start);
+    if (End < 0) {
+        s.error = -9;  // file corrupt
+        return s;
+    }
+
+    s.error = 0;
+    s.text = body.mid(Start, End-Start);
+    return s;
+}
+
+// ---------------------------------------------------------------------
+// Parses a file list like <ModelIncludes "a.inc" "b.inc">.
+int LibraryCache::parseFileList(const QString &body, const QString &tag,
+                                QStringList &files)
+{
+    int StartI = body.indexOf(tag);
+    if (StartI < 0) return 0;  // no files
+    StartI = body.indexOf('"', StartI);
+    if (StartI < 0) return -10;  // file corrupt
+    int EndI = body.indexOf('>', StartI);
+    if (EndI < 0) return -11;  // file corrupt
+    StartI++; EndI--;
+    files = body.mid(StartI, EndI-StartI).split(QRegularExpression("\"\\s+\""));
+    return 0;
+}
@@ -0,0 +1,111 @@
+/***************************************************************************
+                              librarycache.h
+                             ----------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef LIBRARYCACHE_H
+#define LIBRARYCACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+#include <QDateTime>
+#include <QMutex>
+#include <QSharedPointer>
+
+/*!
+  \file librarycache.h
+  \brief Declaration of the LibraryCache class
+*/
+
+/*!
+ * \brief The LibraryCache class is a process-wide cache of parsed Qucs
+ *        component libraries (*.lib). Every library file is read and split
+ *        into its components only once per modification; the sections of
+ *        each component (symbol, model, SPICE and HDL models together with
+ *        their includes and attached files) are extracted at the same time.
+ *        LibComp and parseQucsComponentLibrary() share it, so placing many
+ *        devices of one library no longer rescans the whole file for every
+ *        symbol and netlist.
+ *
+ *        Libraries are keyed by absolute file name and validated by
+ *        modification time. Lookups are thread-safe; parsed libraries are
+ *        immutable and handed out as shared pointers. Whenever a library
+ *        is parsed, the entries of modified or deleted files and the least
+ *        recently used ones beyond MaxLibraries are dropped; holders of a
+ *        pointer keep their copy.
+ */
+class LibraryCache
+{
+public:
+    //! One section of a component, e.g. <Model> ... </Model>
+    struct Section {
+        Section() : error(-7), includesError(0), attachError(0) {}
+        int error;           //!< 0 or the LibComp::loadSection() error code
+        QString text;
+        int includesError;
+        QStringList includes;
+        int attachError;
+        QStringList attach;
+    };
+
+    struct Component {
+        QString name;
+        QString definition;  //!< <Component name> ... </Component>
+        int bodyStart, bodyLength; //!< lines between the tags, in definition
+        QHash<QString, Section> sections;
+    };
+
+    struct Library {
+        int headerError;     //!< 0, -2 (no library) or -3 (bad version line)
+        QString version;
+        bool headerFound;    //!< "<Qucs Library ...>" found anywhere
+        bool empty;          //!< nothing behind the header
+        QString name;
+        QString defaultSymbol;
+        bool defaultSymbolCorrupt;
+        QList<Component> components;  //!< in file order
+        QHash<QString, int> index;    //!< name -> position in components
+    };
+
+    typedef QSharedPointer<const Library> LibraryPtr;
+
+    static LibraryPtr library(const QString &file);
+    static int section(const QString &file, const QString &component,
+                       const QString &name, QString &text,
+                       QStringList *Includes = 0, QStringList *Attach = 0);
+    static void clear();
+
+    static const int MaxLibraries = 16;
+
+private:
+    struct Entry {
+        LibraryPtr lib;
+        QDateTime mtime;
+        quint64 used;    // for least recently used eviction
+    };
+
+    static LibraryPtr parse(const QString &file);
+    static Section parseSection(const QString &body, const QString &name);
+    static int parseFileList(const QString &body, const QString &tag,
+                             QStringList &files);
+    static void trim();
+
+    static QMutex Mutex;
+    static QHash<QString, Entry> Libraries;
+    static quint64 UseCounter;
+};
+
+#endif // LIBRARYCACHE_H
@@ -0,0 +1,251 @@
+/***************************************************************************
+                             libraryindex.cpp
+                            ------------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QRegularExpression>
+
+#include "libraryindex.h"
+#include "main.h"
+#include "qucslib_common.h"
+
+/*!
+  \file libraryindex.cpp
+  \brief Implementation of the LibraryIndex class
+*/
+
+QMutex LibraryIndex::Mutex;
+bool LibraryIndex::Loaded = false;
+bool LibraryIndex::Modified = false;
+QHash<QString, LibraryIndex::Library> LibraryIndex::Libraries;
+QSet<QString> LibraryIndex::Used;
+
+static const quint32 IndexMagic = 0x51494458;  // "QIDX"
+static const quint32 IndexVersion = 1;
+
+static QDataStream& operator<<(QDataStream &s, const LibraryIndex::Item &item)
+{
+    return s << item.name << item.description << item.modelString
+             << item.offset << item.length;
+}
+
+static QDataStream& operator>>(QDataStream &s, LibraryIndex::Item &item)
+{
+    return s >> item.name >> item.description >> item.modelString
+             >> item.offset >> item.length;
+}
+
+static QDataStream& operator<<(QDataStream &s, const LibraryIndex::Library &lib)
+{
+    return s << lib.libPath << lib.file << lib.mtime << lib.size
+             << qint32(lib.result) << lib.name << lib.components;
+}
+
+static QDataStream& operator>>(QDataStream &s, LibraryIndex::Library &lib)
+{
+    qint32 result;
+    s >> lib.libPath >> lib.file >> lib.mtime >> lib.size
+      >> result >> lib.name >> lib.components;
+    lib.result = result;
+    return s;
+}
+
+/*!
+ * \brief LibraryIndex::library Get the index entry of a library. The entry
+ *        is taken from the index if the library file is unchanged, else the
+ *        library is parsed and the entry is rebuilt.
+ * \param libPath Library path as used by parseComponentLibrary()
+ * \param lib Index entry
+ * \return false if the library cannot be indexed (SPICE library, read error
+ *         or corrupt library). The caller has to parse it itself then.
+ */
+bool LibraryIndex::library(const QString &libPath, Library &lib)
+{
+    QString file = getLibAbsPath(libPath);
+    QFileInfo inf(file);
+
+    QMutexLocker locker(&Mutex);
+    load();
+
+    QHash<QString, Library>::const_iterator it = Libraries.constFind(file);
+    if (it != Libraries.constEnd() && it->libPath == libPath &&
+        it->mtime == inf.lastModified() && it->size == inf.size()) {
+        lib = *it;
+        Used.insert(file);
+        return true;
+    }
+
+    locker.unlock();
+    if (!build(libPath, file, lib)) return false;
+    locker.relock();
+
+    Libraries.insert(file, lib);
+    Used.insert(file);
+    Modified = true;
+    return true;
+}
+
+/*!
+ * \brief LibraryIndex::definition Read the definition of an indexed
+ *        component from its library file. Falls back to parsing the
+ *        library if the file has changed since it was indexed.
+ * \return Component definition <Component name> ... </Component>
+ */
+QString LibraryIndex::definition(const QString &libPath, const Item &item)
+{
+    QFile file(getLibAbsPath(libPath));
+    if (file.open(QIODevice::ReadOnly) && file.seek(item.offset)) {
+        QString def = QString::fromUtf8(file.read(item.length));
+        file.close();
+        def.replace(QRegularExpression("\\r\\n"), "\n");
+        if (def.startsWith("<Component " + item.name + ">") &&
+            def.endsWith("</Component>"))
+            return def;
+    }
+
+    ComponentLibrary parsedlibrary;
+    if (parseComponentLibrary(libPath, parsedlibrary) == QUCS_COMP_LIB_OK) {
+        for (const ComponentLibraryItem &comp : parsedlibrary.components)
+            if (comp.name == item.name) return comp.definition;
+    }
+    return QString();
+}
+
+/*!
+ * \brief LibraryIndex::save Write the index to the Qucs home directory if
+ *        it has changed. Only the libraries requested in this session are
+ *        kept.
+ */
+void LibraryIndex::save()
+{
+    QMutexLocker locker(&Mutex);
+    if (!Modified && Used.size() == Libraries.size()) return;
+
+    QFile file(indexFile());
+    if (!file.open(QIODevice::WriteOnly)) return;
+
+    QList<Library> libs;
+    for (const QString &f : Used)
+        libs.append(Libraries.value(f));
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << IndexMagic << IndexVersion << QString(PACKAGE_VERSION) << libs;
+    file.close();
+    Modified = false;
+}
+
+// ---------------------------------------------------------------------
+// Reads the index file once, must be called with the mutex locked.
+void LibraryIndex::load()
+{
+    if (Loaded) return;
+    Loaded = true;
+
+    QFile file(indexFile());
+    if (!file.open(QIODevice::ReadOnly)) return;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic, version;
+    QString package;
+    stream >> magic >> version >> package;
+    if (magic != IndexMagic || version != IndexVersion ||
+        package != PACKAGE_VERSION) return;  // rebuild index
+
+    QList<Library> libs;
+    stream >> libs;
+    if (stream.status() != QDataStream::Ok) return;
+    for (const Library &lib : libs)
+        Libraries.insert(lib.file, lib);
+}
+
+// ---------------------------------------------------------------------
+// Parses a library and locates the definitions of its components in
+// the library file.
+bool LibraryIndex::build(const QString &libPath, const QString &file,
+                         Library &lib)
+{
+    ComponentLibrary parsedlibrary;
+    int result = parseQucsComponentLibrary(libPath, parsedlibrary);
+    if (result != QUCS_COMP_LIB_OK && result != QUCS_COMP_LIB_EMPTY)
+        return false;
+
+    QFile File(file);
+    if (!File.open(QIODevice::ReadOnly)) return false;
+    QFileInfo inf(file);
+    lib.libPath = libPath;
+    lib.file = file;
+    lib.mtime = inf.lastModified();
+    lib.size = inf.size();
+    QByteArray data = File.readAll();
+    File.close();
+
+    lib.result = result;
+    lib.name = parsedlibrary.name;
+    lib.components.clear();
+
+    // same scan as parseQucsComponentLibrary(), but on the raw bytes
+    int Start, End, NameStart, NameEnd;
+    Start = data.indexOf("<Qucs Library ");
+    End = data.indexOf('>', Start);
+    Start = data.indexOf("\n<", End);
+    if (Start >= 0 && data.mid(Start+2, 14) == "DefaultSymbol>") {
+        End = data.indexOf("\n</DefaultSymbol>");
+        Start = End + 3;
+    }
+
+    int i = 0;
+    while (Start >= 0 && (Start = data.indexOf("\n<Component ", Start)) > 0) {
+        Start++;
+        NameStart = Start + 11;
+        NameEnd = data.indexOf('>', NameStart);
+        if (NameEnd < 0) continue;
+        End = data.indexOf("\n</Component>", NameEnd);
+        if (End < 0) continue;
+        End += 13;
+
+        if (i >= parsedlibrary.components.count()) return false;
+        const ComponentLibraryItem &comp = parsedlibrary.components.at(i++);
+        if (QString::fromUtf8(data.mid(NameStart, NameEnd-NameStart)) != comp.name)
+            return false;  // offsets do not match, do not index
+
+        Item item;
+        item.name = comp.name;
+        item.modelString = comp.modelString;
+        item.offset = Start;
+        item.length = End - Start;
+        QString description = comp.definition;
+        getSection("Description", description, item.description);
+        lib.components.append(item);
+
+        Start = End;
+    }
+
+    return i == parsedlibrary.components.count();
+}
+
+// ---------------------------------------------------------------------
+QString LibraryIndex::indexFile()
+{
+    return QucsSettings.QucsHomeDir.absoluteFilePath("library.idx");
+}
@@ -0,0 +1,84 @@
+/***************************************************************************
+                              libraryindex.h
+                             ----------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef LIBRARYINDEX_H
+#define LIBRARYINDEX_H
+
+#include <QString>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QDateTime>
+#include <QMutex>
+
+/*!
+  \file libraryindex.h
+  \brief Declaration of the LibraryIndex class
+*/
+
+/*!
+ * \brief The LibraryIndex class is a persistent index of the Qucs component
+ *        libraries shown in the library tree. For every library it keeps
+ *        the component names, descriptions, model strings and the byte
+ *        ranges of the component definitions in the library file. The index
+ *        is stored in the Qucs home directory and every entry is validated
+ *        by modification time and size of its library file, so the library
+ *        tree is built at startup without reading the libraries. A
+ *        definition is read from the library file only when the component
+ *        is selected.
+ *
+ *        Libraries which are no Qucs libraries (SPICE libraries) are not
+ *        indexed; library() returns false for them and they are parsed
+ *        as before.
+ */
+class LibraryIndex
+{
+public:
+    struct Item {
+        QString name;
+        QString description;
+        QString modelString;
+        qint64 offset;       //!< byte offset of the definition in the file
+        qint64 length;       //!< byte length of the definition
+    };
+
+    struct Library {
+        QString libPath;     //!< library path as given to library()
+        QString file;        //!< absolute library file name
+        QDateTime mtime;
+        qint64 size;
+        int result;          //!< QUCS_COMP_LIB_OK or QUCS_COMP_LIB_EMPTY
+        QString name;
+        QList<Item> components;
+    };
+
+    static bool library(const QString &libPath, Library &lib);
+    static QString definition(const QString &libPath, const Item &item);
+    static void save();
+
+private:
+    static void load();
+    static bool build(const QString &libPath, const QString &file, Library &lib);
+    static QString indexFile();
+
+    static QMutex Mutex;
+    static bool Loaded;
+    static bool Modified;
+    static QHash<QString, Library> Libraries; // absolute file -> entry
+    static QSet<QString> Used;
+};
+
+#endif // LIBRARYINDEX_H
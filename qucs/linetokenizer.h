@@ -0,0 +1,102 @@
+/***************************************************************************
+                              linetokenizer.h
+                             -----------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef LINETOKENIZER_H
+#define LINETOKENIZER_H
+
+#include <QString>
+#include <QVarLengthArray>
+
+/*!
+  \file linetokenizer.h
+  \brief Declaration of the LineTokenizer class
+*/
+
+/*!
+ * \brief The LineTokenizer class splits one line of a schematic file in a
+ *        single pass. It remembers the positions of all blanks and all
+ *        double quotes of the line, so that
+ *
+ *          field(i)   == line.section(' ', i, i)
+ *          section(i) == line.section('"', i, i)
+ *          quotes()   == line.count('"')
+ *
+ *        without rescanning the line for every field. The *View() methods
+ *        return strings which share the data of the line (no copy); they
+ *        are meant for immediate conversion (toInt(), toDouble(), ...) and
+ *        must not outlive the tokenized line.
+ */
+class LineTokenizer
+{
+public:
+    /*!
+     * \param line Line to tokenize; it must stay alive and unchanged
+     * \param first Index of the first character to consider
+     * \param last Index of the last character to consider, -1 for the end
+     *        of the line. Use (1, length-2) to skip the "<" and ">".
+     */
+    explicit LineTokenizer(const QString &line, int first = 0, int last = -1)
+        : Data(line.constData()), First(first),
+          End(last < 0 ? line.length() : last + 1)
+    {
+        for (int i = First; i < End; i++) {
+            if (Data[i] == QLatin1Char(' ')) Blanks.append(i);
+            else if (Data[i] == QLatin1Char('"')) Quotes.append(i);
+        }
+    }
+
+    int fields() const { return Blanks.size() + 1; }
+    int quotes() const { return Quotes.size(); }
+
+    QString field(int i) const { return copy(Blanks, i); }
+    QString section(int i) const { return copy(Quotes, i); }
+
+    QString fieldView(int i) const { return view(Blanks, i); }
+    QString sectionView(int i) const { return view(Quotes, i); }
+
+    int toInt(int i, bool *ok = nullptr) const { return fieldView(i).toInt(ok); }
+    double toDouble(int i, bool *ok = nullptr) const { return fieldView(i).toDouble(ok); }
+
+private:
+    typedef QVarLengthArray<int, 32> Positions;
+
+    bool range(const Positions &sep, int i, int &from, int &to) const
+    {
+        if (i < 0 || i > sep.size()) return false;
+        from = (i == 0) ? First : sep[i-1] + 1;
+        to = (i == sep.size()) ? End : sep[i];
+        return true;
+    }
+    QString view(const Positions &sep, int i) const
+    {
+        int from, to;
+        if (!range(sep, i, from, to)) return QString();
+        return QString::fromRawData(Data + from, to - from);
+    }
+    QString copy(const Positions &sep, int i) const
+    {
+        int from, to;
+        if (!range(sep, i, from, to)) return QString();
+        return QString(Data + from, to - from);
+    }
+
+    const QChar *Data;
+    int First, End;
+    Positions Blanks;
+    Positions Quotes;
+};
+
+#endif // LINETOKENIZER_H
@@ -42,6 +42,7 @@
 #include "node.h"
 #include "printerwriter.h"
 #include "imagewriter.h"
+#include "batchrunner.h"
 
 #include "schematic.h"
 #include "module.h"
@@ -153,6 +154,10 @@ bool loadSettings()
     else QucsSettings.SpiceOpusExecutable = "spiceopus";
     if(settings.contains("Nprocs")) QucsSettings.NProcs = settings.value("Nprocs").toInt();
     else QucsSettings.NProcs = 4;
+    if(settings.contains("XyceJobs")) QucsSettings.XyceJobs = settings.value("XyceJobs").toInt();
+    else QucsSettings.XyceJobs = 0;
+    if(settings.contains("NgspiceShards")) QucsSettings.NgspiceShards = settings.value("NgspiceShards").toInt();
+    else QucsSettings.NgspiceShards = 1;
     if(settings.contains("S4Q_workdir")) QucsSettings.S4Qworkdir = settings.value("S4Q_workdir").toString();
     else QucsSettings.S4Qworkdir = QDir::toNativeSeparators(QucsSettings.QucsWorkDir.absolutePath()+"/spice4qucs");
     if(settings.contains("SimParameters")) QucsSettings.SimParameters = settings.value("SimParameters").toString();
@@ -263,6 +268,8 @@ bool saveApplSettings()
     settings.setValue("SpiceOpusExecutable",QucsSettings.SpiceOpusExecutable);
     settings.setValue("Qucsator",QucsSettings.Qucsator);
     settings.setValue("Nprocs",QucsSettings.NProcs);
+    settings.setValue("XyceJobs",QucsSettings.XyceJobs);
+    settings.setValue("NgspiceShards",QucsSettings.NgspiceShards);
     settings.setValue("S4Q_workdir",QucsSettings.S4Qworkdir);
     settings.setValue("SimParameters",QucsSettings.SimParameters);
     // settings.setValue("OctaveBinDir", QucsSettings.OctaveBinDir.canonicalPath());
@@ -803,6 +810,37 @@ void createListComponentEntry(){
     } // category
 }
 
+/*!
+ * \brief isHeadlessCommand Check whether the command line asks for an
+ *        operation which opens no window: netlisting, simulation, component
+ *        listing, help and version. Printing and icon creation render the
+ *        schematic and keep the full setup.
+ */
+static bool isHeadlessCommand(int argc, char *argv[])
+{
+  bool headless = false;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "-n") || !strcmp(argv[i], "--netlist") ||
+        !strcmp(argv[i], "-list-entries") || !strcmp(argv[i], "--batch") ||
+        !strcmp(argv[i], "-h") || !strcmp(argv[i], "--help") ||
+        !strcmp(argv[i], "-v") || !strcmp(argv[i], "--version")) {
+      headless = true;
+    }
+    else if (!strcmp(argv[i], "-p") || !strcmp(argv[i], "--print") ||
+             !strcmp(argv[i], "-icons") || !strcmp(argv[i], "-doc")) {
+      return false;
+    }
+    else if (!strcmp(argv[i], "-i") || !strcmp(argv[i], "-o") ||
+             !strcmp(argv[i], "--page") || !strcmp(argv[i], "--dpi") ||
+             !strcmp(argv[i], "--color") || !strcmp(argv[i], "--orin") ||
+             !strcmp(argv[i], "-j") || !strcmp(argv[i], "--jobs") ||
+             !strcmp(argv[i], "--timeout")) {
+      ++i;  // skip the option value
+    }
+  }
+  return headless;
+}
+
 // #########################################################################
 // ##########                                                     ##########
 // ##########                  Program Start                      ##########
@@ -820,19 +858,34 @@ int main(int argc, char *argv[])
   QucsSettings.maxUndo = 20;
   QucsSettings.NodeWiring = 0;
 
+  // Netlisting and simulation from the command line need no display and
+  // skip the setup of the main window. The schematic is still a widget,
+  // so without an X11 or Wayland display they run on the offscreen
+  // platform, unless the user has chosen a platform. Windows and macOS
+  // always have their native platform, which may be the only one shipped.
+  bool headless = isHeadlessCommand(argc, argv);
+#if defined(Q_OS_UNIX) && !defined(Q_OS_DARWIN)
+  if (headless && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM") &&
+      qEnvironmentVariableIsEmpty("DISPLAY") &&
+      qEnvironmentVariableIsEmpty("WAYLAND_DISPLAY"))
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+#endif
+
   // initially center the application
   QApplication a(argc, argv);
   //QDesktopWidget *d = a.desktop();
   QucsSettings.font = QApplication::font();
   QucsSettings.appFont = QApplication::font();
   QucsSettings.font.setPointSize(12);
-  QSize size = QGuiApplication::primaryScreen()->size();
-  int w = size.width();
-  int h = size.height();
-  QucsSettings.x = w/8;
-  QucsSettings.y = h/8;
-  QucsSettings.dx = w*3/4;
-  QucsSettings.dy = h*3/4;
+  if (!headless) {
+    QSize size = QGuiApplication::primaryScreen()->size();
+    int w = size.width();
+    int h = size.height();
+    QucsSettings.x = w/8;
+    QucsSettings.y = h/8;
+    QucsSettings.dx = w*3/4;
+    QucsSettings.dy = h*3/4;
+  }
 
   // default
   QString QucsWorkdirPath = QDir::homePath()+QDir::toNativeSeparators ("/.qucs");
@@ -922,45 +975,47 @@ int main(int argc, char *argv[])
       QucsSettings.QucsOctave.clear();
   }
 
-  if(!QucsSettings.BGColor.isValid())
-    QucsSettings.BGColor.setRgb(255, 250, 225);
-
-  // syntax highlighting
-  if(!QucsSettings.Comment.isValid())
-    QucsSettings.Comment = Qt::gray;
-  if(!QucsSettings.String.isValid())
-    QucsSettings.String = Qt::red;
-  if(!QucsSettings.Integer.isValid())
-    QucsSettings.Integer = Qt::blue;
-  if(!QucsSettings.Real.isValid())
-    QucsSettings.Real = Qt::darkMagenta;
-  if(!QucsSettings.Character.isValid())
-    QucsSettings.Character = Qt::magenta;
-  if(!QucsSettings.Type.isValid())
-    QucsSettings.Type = Qt::darkRed;
-  if(!QucsSettings.Attribute.isValid())
-    QucsSettings.Attribute = Qt::darkCyan;
-  if(!QucsSettings.Directive.isValid())
-    QucsSettings.Directive = Qt::darkCyan;
-  if(!QucsSettings.Task.isValid())
-    QucsSettings.Task = Qt::darkRed;
-
-  QucsSettings.sysDefaultFont = QApplication::font();
-  a.setFont(QucsSettings.appFont);
-
   // set codecs
   //QTextCodec::setCodecForLocale(QTextCodec::codecForName("UTF-8"));
 //  QTextCodec::setCodecForTr(QTextCodec::codecForName("UTF-8"));
 
+  // colors, fonts and translations of the user interface
   QTranslator tor( 0 );
-  QString lang = QucsSettings.Language;
-  if(lang.isEmpty()) {
-      QLocale loc;
-      lang = loc.name();
-//    lang = QTextCodec::locale();
+  if (!headless) {
+    if(!QucsSettings.BGColor.isValid())
+      QucsSettings.BGColor.setRgb(255, 250, 225);
+
+    // syntax highlighting
+    if(!QucsSettings.Comment.isValid())
+      QucsSettings.Comment = Qt::gray;
+    if(!QucsSettings.String.isValid())
+      QucsSettings.String = Qt::red;
+    if(!QucsSettings.Integer.isValid())
+      QucsSettings.Integer = Qt::blue;
+    if(!QucsSettings.Real.isValid())
+      QucsSettings.Real = Qt::darkMagenta;
+    if(!QucsSettings.Character.isValid())
+      QucsSettings.Character = Qt::magenta;
+    if(!QucsSettings.Type.isValid())
+      QucsSettings.Type = Qt::darkRed;
+    if(!QucsSettings.Attribute.isValid())
+      QucsSettings.Attribute = Qt::darkCyan;
+    if(!QucsSettings.Directive.isValid())
+      QucsSettings.Directive = Qt::darkCyan;
+    if(!QucsSettings.Task.isValid())
+      QucsSettings.Task = Qt::darkRed;
+
+    QucsSettings.sysDefaultFont = QApplication::font();
+    a.setFont(QucsSettings.appFont);
+
+    QString lang = QucsSettings.Language;
+    if(lang.isEmpty()) {
+        QLocale loc;
+        lang = loc.name();
+    }
+    tor.load( QString("qucs_") + lang, QucsSettings.LangDir);
+    a.installTranslator( &tor );
   }
-  tor.load( QString("qucs_") + lang, QucsSettings.LangDir);
-  a.installTranslator( &tor );
 
   // This seems to be necessary on a few system to make strtod()
   // work properly !???!
@@ -974,6 +1029,10 @@ int main(int argc, char *argv[])
   bool ngspice_flag = false;
   bool xyce_flag = false;
   bool run_flag = false;
+  bool batch_flag = false;
+  int jobs = 0;
+  int timeout = 0;
+  QStringList batch_inputs;
   QString page = "A4";
   int dpi = 96;
   QString color = "RGB";
@@ -985,7 +1044,8 @@ int main(int argc, char *argv[])
       fprintf(stdout,
   "Usage: %s [-hv] \n"
   "       qucs -n -i FILENAME -o FILENAME\n"
-  "       qucs -p -i FILENAME -o FILENAME.[pdf|png|svg|eps] \n\n"
+  "       qucs -p -i FILENAME -o FILENAME.[pdf|png|svg|eps] \n"
+  "       qucs --batch [--ngspice|--xyce] [-j N] [--timeout SEC] [-o FILENAME] FILES\n\n"
   "  -h, --help     display this help and exit\n"
   "  -v, --version  display version information and exit\n"
   "  -n, --netlist  convert Qucs schematic into netlist\n"
@@ -999,6 +1059,14 @@ int main(int argc, char *argv[])
   "     --ngspice   create Ngspice netlist\n"
   "     --xyce      Xyce netlist\n"
   "     --run       execute Ngspice/Xyce immediately\n"
+  "  --batch        simulate schematics and SPICE netlists concurrently with\n"
+  "                 Ngspice (default) or Xyce. FILES are file names, wildcard\n"
+  "                 patterns or @LISTFILE. Datasets are written next to the\n"
+  "                 schematics, a JSON summary to -o FILENAME or stdout\n"
+  "     -j, --jobs N     number of concurrent simulations (default: cores);\n"
+  "                      each gets cores/N for its own Xyce jobs and\n"
+  "                      Ngspice sweep shards\n"
+  "     --timeout SEC    wall-clock limit per simulation (default: none)\n"
   "  -icons         create component icons under ./bitmaps_generated\n"
   "  -doc           dump data for documentation:\n"
   "                 * file with of categories: categories.txt\n"
@@ -1050,6 +1118,15 @@ int main(int argc, char *argv[])
     else if (!strcmp(argv[i], "--run")) {
       run_flag = true;
     }
+    else if (!strcmp(argv[i], "--batch")) {
+      batch_flag = true;
+    }
+    else if (!strcmp(argv[i], "-j") || !strcmp(argv[i], "--jobs")) {
+      jobs = QString(argv[++i]).toInt();
+    }
+    else if (!strcmp(argv[i], "--timeout")) {
+      timeout = QString(argv[++i]).toInt();
+    }
     else if(!strcmp(argv[i], "-icons")) {
       createIcons();
       return 0;
@@ -1062,12 +1139,37 @@ int main(int argc, char *argv[])
       createListComponentEntry();
       return 0;
     }
+    else if (argv[i][0] != '-') {
+      batch_inputs.append(QString::fromLocal8Bit(argv[i]));
+    }
     else {
       fprintf(stderr, "Error: Unknown option: %s\n", argv[i]);
       return -1;
     }
   }
 
+  // simulate a list of schematics and netlists
+  if (batch_flag) {
+    if (netlist_flag || print_flag) {
+      fprintf(stderr, "Error: --batch cannot be used with --netlist or --print\n");
+      return -1;
+    }
+    if (!inputfile.isEmpty()) batch_inputs.prepend(inputfile);
+    BatchRunner runner;
+    if (runner.addInputs(batch_inputs) == 0) {
+      fprintf(stderr, "Error: Expected input files.\n");
+      return -1;
+    }
+    runner.setSimulator(xyce_flag ? spicecompat::simXyceSer : spicecompat::simNgspice);
+    runner.setJobs(jobs);
+    runner.setTimeout(timeout);
+    runner.setSummaryFile(outputfile);
+    return runner.run();
+  } else if (!batch_inputs.isEmpty()) {
+    fprintf(stderr, "Error: Unknown option: %s\n", batch_inputs.first().toLocal8Bit().data());
+    return -1;
+  }
+
   // check operation and its required arguments
   if (netlist_flag and print_flag) {
     fprintf(stderr, "Error: --print and --netlist cannot be used together\n");
@@ -88,6 +88,8 @@ struct tQucsSettings {
   QString S4Qworkdir;
   QString SimParameters;
   unsigned int NProcs; // Number of processors for Xyce
+  unsigned int XyceJobs; // Concurrent Xyce analyses, 0: as many as cores allow
+  unsigned int NgspiceShards; // Ngspice processes for parameter sweeps, 0: one per core
   QString OctaveExecutable; // OctaveExecutable location
   QString QucsOctave; // OUCS_OCTAVE variable
 
@@ -14,10 +14,20 @@
  *   (at your option) any later version.                                   *
  *                                                                         *
  ***************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
 #include <QHash>
 #include <QString>
 #include <QStringList>
 #include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
 #include <QDebug>
 
 #include "element.h"
@@ -36,6 +46,11 @@ QList<Category *> Category::Categories;
 
 QMap<QString, QString> Module::vaComponents;
 
+// Registration state, see beginRegistration().
+static QMutex RegistrationMutex;
+static QWaitCondition RegistrationDone;
+static bool RegistrationPending = false;
+
 // Constructor creates instance of module object.
 Module::Module () {
   info = 0;
@@ -52,33 +67,101 @@ void Module::registerModule (QString category, pInfoFunc info) {
   Module * m = new Module ();
   m->info = info;
   m->category = category;
+  char * File = 0;
+  (*info) (m->name, File, false);
+  m->bitmap = File;
   intoCategory (m);
 }
 
+// Model names of the registered components.  With these the registration
+// does not need to create an instance of every component just to read
+// its "Model" property.  They are learnt from the instances the first
+// time a build of the program registers its components and kept in the
+// Qucs home directory for the next start; a different executable
+// discards them, so they cannot get out of date.
+static QMutex ModelsMutex;
+static QHash<QString, QString> KnownModels;   // class + display name -> model
+static bool ModelsLoaded = false;
+static bool ModelsChanged = false;
+
+// Identifies the build of the program the known models were learnt from.
+static QString modelsBuildId (void) {
+  QFileInfo exe (QCoreApplication::applicationFilePath ());
+  return QString ("%1 %2 %3 %4").arg (PACKAGE_VERSION, exe.absoluteFilePath ())
+    .arg (exe.size ()).arg (exe.lastModified ().toMSecsSinceEpoch ());
+}
+
+static QString modelsFile (void) {
+  return QucsSettings.QucsHomeDir.filePath ("componentmodels.cache");
+}
+
+// Reads the known models once, unless they were written by another build.
+static void loadKnownModels (void) {
+  if (ModelsLoaded) return;
+  ModelsLoaded = true;
+  QFile file (modelsFile ());
+  if (!file.open (QIODevice::ReadOnly)) return;
+  if (QString::fromUtf8 (file.readLine ()).trimmed () != modelsBuildId ()) return;
+  while (!file.atEnd ()) {
+    QStringList fields = QString::fromUtf8 (file.readLine ()).trimmed ().split ('\t');
+    if (fields.count () == 3)
+      KnownModels.insert (fields.at (0) + '\t' + fields.at (1), fields.at (2));
+  }
+}
+
+// Writes the known models if registration has learnt new ones.
+static void saveKnownModels (void) {
+  QMutexLocker locker (&ModelsMutex);
+  if (!ModelsChanged) return;
+  ModelsChanged = false;
+  QSaveFile file (modelsFile ());
+  if (!file.open (QIODevice::WriteOnly)) return;
+  QString text = modelsBuildId () + '\n';
+  for (auto it = KnownModels.constBegin (); it != KnownModels.constEnd (); ++it)
+    text += it.key () + '\t' + it.value () + '\n';
+  file.write (text.toUtf8 ());
+  file.commit ();
+}
+
 // Component registration using a category name and the appropriate
 // function returning a components instance object.
-void Module::registerComponent (QString category, pInfoFunc info) {
+void Module::registerComponent (QString category, pInfoFunc info,
+                                const char * className) {
   Module * m = new Module ();
   m->info = info;
   m->category = category;
-
-  // instantiation of the component once in order to obtain "Model"
-  // property of the component
-  QString Name, Model;
-  char * File;
-  Component * c = (Component *) info (Name, File, true);
-  Model = c->Model;
-  delete c;
+  char * File = 0;
+  (*info) (m->name, File, false);
+  m->bitmap = File;
+
+  QString key = QString (className ? className : "") + '\t' + m->name;
+  QMutexLocker locker (&ModelsMutex);
+  loadKnownModels ();
+  m->model = KnownModels.value (key);
+  if (m->model.isEmpty ()) {
+    // instantiation of the component once in order to obtain "Model"
+    // property of the component
+    QString Name;
+    Component * c = (Component *) info (Name, File, true);
+    m->model = c->Model;
+    delete c;
+    if (className) {
+      KnownModels.insert (key, m->model);
+      ModelsChanged = true;
+    }
+  }
+  locker.unlock ();
 
   // put into category and the component hash
   intoCategory (m);
-  if (!Modules.contains (Model))
-    Modules.insert (Model, m);
+  if (!Modules.contains (m->model))
+    Modules.insert (m->model, m);
 }
 
 // Returns instantiated component based on the given "Model" name.  If
 // there is no such component registers the function returns NULL.
 Component * Module::getComponent (QString Model) {
+  waitForRegistration ();
   if ( Modules.contains(Model)) {
     Module *m = Modules.find(Model).value();
     QString Name;
@@ -109,8 +192,6 @@ void Module::registerDynamicComponents()
 
      Module * m = new Module ();
 
-     // what now? pointer to info?
-
      // the typedef needs to be different
      //passes the pointer, but it has no idea how to call the JSON
      m->infoVA = &vacomponent::info;
@@ -118,22 +199,16 @@ void Module::registerDynamicComponents()
      // TODO maybe allow user load into custom category?
      m->category = QObject::tr("verilog-a user devices");
 
-     // instantiation of the component once in order
-     // to obtain "Model" property of the component
-     //QString Name, Model;
-     //char * File;
-     QString Name, Model, vaBitmap;
-//     char * File;
-     Component * c = (Component *)
-             vacomponent::info (Name, vaBitmap, true, vaComponents[i.key()]);
-     Model = c->Model;
-     delete c;
+     // the "Model" property of a Verilog-A component is the name
+     // returned by info(), so no instance is needed
+     vacomponent::info (m->name, m->bitmap, false, i.value());
+     m->model = m->name;
 
      // put into category and the component hash
      intoCategory (m);
 
-     if (!Modules.contains (Model))
-         Modules.insert (Model, m);
+     if (!Modules.contains (m->model))
+         Modules.insert (m->model, m);
 
    } // while
 }
@@ -172,14 +247,14 @@ void Module::intoCategory (Module * m) {
   registerModule (cat, &val::inf3)
 
 #define REGISTER_COMP_1(cat,val) \
-  registerComponent (cat, &val::info)
+  registerComponent (cat, &val::info, #val)
 #define REGISTER_COMP_2(cat,val,inf1,inf2) \
-  registerComponent (cat, &val::inf1); \
-  registerComponent (cat, &val::inf2)
+  registerComponent (cat, &val::inf1, #val); \
+  registerComponent (cat, &val::inf2, #val)
 #define REGISTER_COMP_3(cat,val,inf1,inf2,inf3) \
-  registerComponent (cat, &val::inf1); \
-  registerComponent (cat, &val::inf2); \
-  registerComponent (cat, &val::inf3)
+  registerComponent (cat, &val::inf1, #val); \
+  registerComponent (cat, &val::inf2, #val); \
+  registerComponent (cat, &val::inf3, #val)
 
 #define REGISTER_LUMPED_1(val) \
   REGISTER_COMP_1 (QObject::tr("lumped components"),val)
@@ -522,8 +597,7 @@ void Module::registerModules (void) {
   }
   REGISTER_SIMULATION_1 (Param_Sweep);
   REGISTER_SIMULATION_1 (Digi_Sim);
-  if (QucsSettings.DefaultSimulator == spicecompat::simQucsator)
-      REGISTER_SIMULATION_1 (Optimize_Sim);
+  REGISTER_SIMULATION_1 (Optimize_Sim); // ASCO or SpiceOptimizer
   if (QucsSettings.DefaultSimulator != spicecompat::simQucsator) {
       REGISTER_SIMULATION_1 (SpiceFourier);
       REGISTER_SIMULATION_1 (SpiceNoise);
@@ -537,6 +611,10 @@ void Module::registerModules (void) {
       REGISTER_SIMULATION_1 (SpiceSENS);
       REGISTER_SIMULATION_1 (SpiceSENS_AC);
   }
+  if (QucsSettings.DefaultSimulator == spicecompat::simNgspice) {
+      // setseed, sunif, sgauss and alterparam exist in Ngspice only
+      REGISTER_SIMULATION_1 (SpiceMonteCarlo);
+  }
 
   if ((QucsSettings.DefaultSimulator == spicecompat::simXycePar)||
       (QucsSettings.DefaultSimulator == spicecompat::simXyceSer)) {
@@ -614,11 +692,34 @@ void Module::registerModules (void) {
   REGISTER_PAINT_2 (qucs::Rectangle, info, info_filled);
   REGISTER_PAINT_1 (EllipseArc);
 
+  saveKnownModels ();
+}
+
+// Marks the module registry as being filled on a worker thread.  Until
+// endRegistration() is called, all lookups block in waitForRegistration().
+void Module::beginRegistration (void) {
+  QMutexLocker locker (&RegistrationMutex);
+  RegistrationPending = true;
+}
+
+// Marks the registration as complete and wakes up waiting lookups.
+void Module::endRegistration (void) {
+  QMutexLocker locker (&RegistrationMutex);
+  RegistrationPending = false;
+  RegistrationDone.wakeAll ();
+}
+
+// Blocks until a background registration is complete.
+void Module::waitForRegistration (void) {
+  QMutexLocker locker (&RegistrationMutex);
+  while (RegistrationPending)
+    RegistrationDone.wait (&RegistrationMutex);
 }
 
 // This function has to be called once at application end.  It removes
 // all categories and registered modules from memory.
 void Module::unregisterModules (void) {
+  waitForRegistration ();
   while(!Category::Categories.isEmpty()) {
     delete Category::Categories.takeFirst();
   }
@@ -657,6 +758,7 @@ Category::~Category () {
 
 // Returns the available category names in a list of strings.
 QStringList Category::getCategories (void) {
+  Module::waitForRegistration ();
   QStringList res;
   QList<Category *>::const_iterator it;
   for (it = Category::Categories.constBegin(); 
@@ -670,6 +772,7 @@ QStringList Category::getCategories (void) {
 // as a pointer list.  The pointer list is empty if there is no such
 // category available.
 QList<Module *> Category::getModules (QString category) {
+  Module::waitForRegistration ();
   QList<Module *> res;
   QList<Category *>::const_iterator it;
   for (it = Category::Categories.constBegin();
@@ -685,6 +788,7 @@ QList<Module *> Category::getModules (QString category) {
 // category name.  The function returns minus 1 if there is no such
 // category.
 int Category::getModulesNr (QString category) {
+  Module::waitForRegistration ();
   for (int i = 0; i < Category::Categories.size(); i++) {
     if (category == Category::Categories.at(i)->Name)
       return i;
@@ -33,7 +33,7 @@ class Module
   Module ();
   ~Module ();
   static void registerModule (QString, pInfoFunc);
-  static void registerComponent (QString, pInfoFunc);
+  static void registerComponent (QString, pInfoFunc, const char * = 0);
   static void intoCategory (Module *);
   static Component * getComponent (QString);
   static void registerDynamicComponents(void);
@@ -45,11 +45,20 @@ class Module
  public:
   static void registerModules (void);
   static void unregisterModules (void);
+  static void beginRegistration (void);
+  static void endRegistration (void);
+  static void waitForRegistration (void);
 
  public:
   pInfoFunc info = 0;
   pInfoVAFunc infoVA = 0;
   QString category;
+
+  // metadata for the component palette and search, so that no
+  // instance has to be created to show the module
+  QString model;   // "Model" property, components only
+  QString name;    // display name
+  QString bitmap;  // icon base name
 };
 
 class Category
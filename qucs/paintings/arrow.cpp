@@ -23,6 +23,7 @@
 #include "arrow.h"
 #include "arrowdialog.h"
 #include "schematic.h"
+#include "linetokenizer.h"
 #include <cmath>
 
 #include <QPolygon>
@@ -149,47 +150,48 @@ Element* Arrow::info(QString& Name, char* &BitmapFile, bool getNewOne)
 bool Arrow::load(const QString& s)
 {
   bool ok;
+  LineTokenizer tok(s);
 
   QString n;
-  n  = s.section(' ',1,1);    // cx
+  n  = tok.fieldView(1);    // cx
   cx = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',2,2);    // cy
+  n  = tok.fieldView(2);    // cy
   cy = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',3,3);    // x2
+  n  = tok.fieldView(3);    // x2
   x2 = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',4,4);    // y2
+  n  = tok.fieldView(4);    // y2
   y2 = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',5,5);    // height
+  n  = tok.fieldView(5);    // height
   Height = n.toDouble(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',6,6);    // width
+  n  = tok.fieldView(6);    // width
   Width = n.toDouble(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',7,7);    // color
+  n  = tok.fieldView(7);    // color
   QColor co;
   co.setNamedColor(n);
   Pen.setColor(co);
   if(!Pen.color().isValid()) return false;
 
-  n  = s.section(' ',8,8);    // thickness
+  n  = tok.fieldView(8);    // thickness
   Pen.setWidth(n.toInt(&ok));
   if(!ok) return false;
 
-  n  = s.section(' ',9,9);    // line style
+  n  = tok.fieldView(9);    // line style
   Pen.setStyle((Qt::PenStyle)n.toInt(&ok));
   if(!ok) return false;
 
-  n  = s.section(' ',10,10);    // arrow style
+  n  = tok.fieldView(10);    // arrow style
   if(!n.isEmpty()) {            // backward compatible
     Style = n.toInt(&ok);
     if(!ok) return false;
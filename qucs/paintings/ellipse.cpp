@@ -26,6 +26,7 @@
 #include <QCheckBox>
 
 #include "misc.h"
+#include "linetokenizer.h"
 
 qucs::Ellipse::Ellipse(bool _filled)
 {
@@ -118,48 +119,49 @@ Element* qucs::Ellipse::info_filled(QString& Name, char* &BitmapFile, bool getNe
 bool qucs::Ellipse::load(const QString& s)
 {
   bool ok;
+  LineTokenizer tok(s);
 
   QString n;
-  n  = s.section(' ',1,1);    // cx
+  n  = tok.fieldView(1);    // cx
   cx = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',2,2);    // cy
+  n  = tok.fieldView(2);    // cy
   cy = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',3,3);    // x2
+  n  = tok.fieldView(3);    // x2
   x2 = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',4,4);    // y2
+  n  = tok.fieldView(4);    // y2
   y2 = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',5,5);    // color
+  n  = tok.fieldView(5);    // color
   QColor co;
   co.setNamedColor(n);
   Pen.setColor(co);
   if(!Pen.color().isValid()) return false;
 
-  n  = s.section(' ',6,6);    // thickness
+  n  = tok.fieldView(6);    // thickness
   Pen.setWidth(n.toInt(&ok));
   if(!ok) return false;
 
-  n  = s.section(' ',7,7);    // line style
+  n  = tok.fieldView(7);    // line style
   Pen.setStyle((Qt::PenStyle)n.toInt(&ok));
   if(!ok) return false;
 
-  n  = s.section(' ',8,8);    // fill color
+  n  = tok.fieldView(8);    // fill color
   co.setNamedColor(n);
   Brush.setColor(co);
   if(!Brush.color().isValid()) return false;
 
-  n  = s.section(' ',9,9);    // fill style
+  n  = tok.fieldView(9);    // fill style
   Brush.setStyle((Qt::BrushStyle)n.toInt(&ok));
   if(!ok) return false;
 
-  n  = s.section(' ',10,10);    // filled
+  n  = tok.fieldView(10);    // filled
   if(n.toInt(&ok) == 0) filled = false;
   else filled = true;
   if(!ok) return false;
@@ -25,6 +25,7 @@
 #include <QComboBox>
 
 #include "misc.h"
+#include "linetokenizer.h"
 
 #include <cmath>
 
@@ -101,43 +102,44 @@ Element* EllipseArc::info(QString& Name, char* &BitmapFile, bool getNewOne)
 bool EllipseArc::load(const QString& s)
 {
   bool ok;
+  LineTokenizer tok(s);
   QString n;
 
-  n  = s.section(' ',1,1);    // cx
+  n  = tok.fieldView(1);    // cx
   cx = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',2,2);    // cy
+  n  = tok.fieldView(2);    // cy
   cy = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',3,3);    // x2
+  n  = tok.fieldView(3);    // x2
   x2 = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',4,4);    // y2
+  n  = tok.fieldView(4);    // y2
   y2 = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',5,5);    // start angle
+  n  = tok.fieldView(5);    // start angle
   Angle = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',6,6);    // arc length
+  n  = tok.fieldView(6);    // arc length
   ArcLen = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',7,7);    // color
+  n  = tok.fieldView(7);    // color
   QColor co;
   co.setNamedColor(n);
   Pen.setColor(co);
   if(!Pen.color().isValid()) return false;
 
-  n  = s.section(' ',8,8);    // thickness
+  n  = tok.fieldView(8);    // thickness
   Pen.setWidth(n.toInt(&ok));
   if(!ok) return false;
 
-  n  = s.section(' ',9,9);    // line style
+  n  = tok.fieldView(9);    // line style
   Pen.setStyle((Qt::PenStyle)n.toInt(&ok));
   if(!ok) return false;
 
@@ -24,6 +24,7 @@
 #include <QComboBox>
 
 #include "misc.h"
+#include "linetokenizer.h"
 
 GraphicLine::GraphicLine(int cx_, int cy_, int x2_, int y2_, QPen Pen_)
 {
@@ -100,35 +101,36 @@ Element* GraphicLine::info(QString& Name, char* &BitmapFile, bool getNewOne)
 bool GraphicLine::load(const QString& s)
 {
   bool ok;
+  LineTokenizer tok(s);
 
   QString n;
-  n  = s.section(' ',1,1);    // cx
+  n  = tok.fieldView(1);    // cx
   cx = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',2,2);    // cy
+  n  = tok.fieldView(2);    // cy
   cy = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',3,3);    // x2
+  n  = tok.fieldView(3);    // x2
   x2 = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',4,4);    // y2
+  n  = tok.fieldView(4);    // y2
   y2 = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',5,5);    // color
+  n  = tok.fieldView(5);    // color
   QColor co;
   co.setNamedColor(n);
   Pen.setColor(co);
   if(!Pen.color().isValid()) return false;
 
-  n  = s.section(' ',6,6);    // thickness
+  n  = tok.fieldView(6);    // thickness
   Pen.setWidth(n.toInt(&ok));
   if(!ok) return false;
 
-  n  = s.section(' ',7,7);    // line style
+  n  = tok.fieldView(7);    // line style
   Pen.setStyle((Qt::PenStyle)n.toInt(&ok));
   if(!ok) return false;
 
@@ -21,6 +21,7 @@
 #include "graphictextdialog.h"
 #include "schematic.h"
 #include "misc.h"
+#include "linetokenizer.h"
 
 #include <QPainter>
 #include <QPushButton>
@@ -137,25 +138,26 @@ Element* GraphicText::info(QString& Name, char* &BitmapFile, bool getNewOne)
 bool GraphicText::load(const QString& s)
 {
   bool ok;
+  LineTokenizer tok(s);
 
   QString n;
-  n  = s.section(' ',1,1);    // cx
+  n  = tok.fieldView(1);    // cx
   cx = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',2,2);    // cy
+  n  = tok.fieldView(2);    // cy
   cy = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',3,3);    // Size
+  n  = tok.fieldView(3);    // Size
   Font.setPointSize(n.toInt(&ok));
   if(!ok) return false;
 
-  n  = s.section(' ',4,4);    // Color
+  n  = tok.fieldView(4);    // Color
   Color.setNamedColor(n);
   if(!Color.isValid()) return false;
 
-  n  = s.section(' ',5,5);    // Angle
+  n  = tok.fieldView(5);    // Angle
   Angle = n.toInt(&ok);
   if(!ok) return false;
 
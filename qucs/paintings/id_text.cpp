@@ -17,6 +17,7 @@
 #include "id_text.h"
 #include "id_dialog.h"
 #include "schematic.h"
+#include "linetokenizer.h"
 
 #include <QPainter>
 
@@ -94,22 +95,23 @@ void ID_Text::setCenter(int x, int y, bool relative)
 bool ID_Text::load(const QString& s)
 {
   bool ok;
+  LineTokenizer tok(s);
 
   QString n;
-  n  = s.section(' ',1,1);    // cx
+  n  = tok.fieldView(1);    // cx
   cx = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',2,2);    // cy
+  n  = tok.fieldView(2);    // cy
   cy = n.toInt(&ok);
   if(!ok) return false;
 
-  Prefix = s.section(' ',3,3);    // Prefix
+  Prefix = tok.field(3);    // Prefix
   if(Prefix.isEmpty()) return false;
 
   int i = 1;
   for(;;) {
-    n = s.section('"', i,i);
+    n = tok.sectionView(i);
     if(n.isEmpty())  break;
 
     Parameter.append(new SubParameter(
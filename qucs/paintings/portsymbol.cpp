@@ -17,6 +17,7 @@
 #include "main.h"
 #include "portsymbol.h"
 #include "schematic.h"
+#include "linetokenizer.h"
 
 #include <QPainter>
 
@@ -137,20 +138,21 @@ void PortSymbol::setCenter(int x, int y, bool relative)
 bool PortSymbol::load(const QString& s)
 {
   bool ok;
+  LineTokenizer tok(s);
 
   QString n;
-  n  = s.section(' ',1,1);    // cx
+  n  = tok.fieldView(1);    // cx
   cx = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',2,2);    // cy
+  n  = tok.fieldView(2);    // cy
   cy = n.toInt(&ok);
   if(!ok) return false;
 
-  numberStr  = s.section(' ',3,3);    // number
+  numberStr  = tok.field(3);    // number
   if(numberStr.isEmpty()) return false;
 
-  n  = s.section(' ',4,4);      // Angel
+  n  = tok.fieldView(4);      // Angel
   if(n.isEmpty()) return true;  // be backward-compatible
   Angel = n.toInt(&ok);
   if(!ok) return false;
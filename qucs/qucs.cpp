@@ -55,6 +55,7 @@
 #include "messagedock.h"
 #include "wire.h"
 #include "module.h"
+#include "componenticons.h"
 #include "projectView.h"
 #include "components/components.h"
 #include "paintings/paintings.h"
@@ -75,10 +76,15 @@
 //#include "dialogs/vtabwidget.h"
 //#include "dialogs/vtabbeddockwidget.h"
 #include "extsimkernels/externsimdialog.h"
+#include "extsimkernels/ngspicesession.h"
 #include "octave_window.h"
 #include "printerwriter.h"
 #include "imagewriter.h"
 #include "qucslib_common.h"
+#include "libraryindex.h"
+#include "startupscanner.h"
+#include "subcircuitcache.h"
+#include "librarycache.h"
 #include "misc.h"
 #include "extsimkernels/verilogawriter.h"
 #include "extsimkernels/simsettingsdialog.h"
@@ -152,8 +158,18 @@ QucsApp::QucsApp()
     tr("Spice Files") + QString(" (") + QucsSettings.spiceExtensions.join(" ") + QString(");;") +
     tr("Any File")+" (*)";
 
-  updateSchNameHash();
-  updateSpiceNameHash();
+  // scan the path list, register the components and index the
+  // libraries in the background, see slotNamesReady() etc.
+  ModulesReady = false;
+  CompChooseAll = true;
+  SchNamesPending = SpiceNamesPending = true;
+  updatePathList();
+  Scanner = new StartupScanner(this);
+  connect(Scanner, SIGNAL(namesReady()), SLOT(slotNamesReady()));
+  connect(Scanner, SIGNAL(modulesReady()), SLOT(slotModulesReady()));
+  connect(Scanner, SIGNAL(librariesReady()), SLOT(slotLibrariesReady()));
+  Scanner->start(qucsPathList, QucsSettings.QucsWorkDir,
+                 QucsSettings.spiceExtensions);
 
   move  (QucsSettings.x,  QucsSettings.y);
   resize(QucsSettings.dx, QucsSettings.dy);
@@ -174,7 +190,6 @@ QucsApp::QucsApp()
   slotViewOctaveDock(false);
   slotUpdateRecentFiles();
   initCursorMenu();
-  Module::registerModules ();
 
   fileToolbar->setVisible(QucsSettings.FileToolbar);
   editToolbar->setVisible(QucsSettings.EditToolbar);
@@ -194,7 +209,8 @@ QucsApp::QucsApp()
 
   lastExportFilename = QDir::homePath() + QDir::separator() + "export.png";
 
-  // load documents given as command line arguments
+  // load documents given as command line arguments, as soon as the
+  // subcircuit search paths are known
   for(int z=1; z<qApp->arguments().size(); z++) {
     QString arg = qApp->arguments()[z];
     QByteArray ba = arg.toLatin1();
@@ -203,7 +219,7 @@ QucsApp::QucsApp()
       QFileInfo Info(arg);
       QucsSettings.QucsWorkDir.setPath(Info.absoluteDir().absolutePath());
       arg = QucsSettings.QucsWorkDir.filePath(Info.fileName());
-      gotoPage(arg);
+      StartupFiles.append(arg);
     }
   }
 
@@ -213,13 +229,23 @@ QucsApp::QucsApp()
                                          "If you have no simulators except Qucs installed\n"
                                          "in your system leave default Qucsator setting\n"
                                          "and simple press Apply button"));
+      Module::waitForRegistration(); // registration depends on the simulator
       slotSimSettings();
   }
-  fillLibrariesTreeView();
+
+  // placeholder until the library index is ready
+  libTreeWidget->clear();
+  libTreeWidget->addTopLevelItem(new QTreeWidgetItem((QTreeWidget*)0,
+                                 QStringList(tr("Loading libraries..."))));
 }
 
 QucsApp::~QucsApp()
 {
+  // the startup scans still may use the component registry
+  delete Scanner;
+  Scanner = 0;
+  SubcircuitCache::clear();
+  LibraryCache::clear();
   Module::unregisterModules ();
 }
 
@@ -486,6 +512,78 @@ void QucsApp::initView()
   readProjects(); // reads all projects and inserts them into the ListBox
 }
 
+// Creates the tree item of one library with its components. Qucs
+// libraries are taken from the library index, their definitions are read
+// when a component is selected. Other libraries are parsed completely.
+static int makeLibraryItem(const QString &libPath, const QString &fileName,
+                           QTreeWidgetItem *&libitem)
+{
+    LibraryIndex::Library index;
+    if (LibraryIndex::library(libPath, index)) {
+        QStringList nameAndFileName;
+        nameAndFileName.append (index.name);
+        nameAndFileName.append (fileName);
+        libitem = new QTreeWidgetItem((QTreeWidget*)nullptr, nameAndFileName);
+
+        for (int i = 0; i < index.components.count (); i++)
+        {
+            const LibraryIndex::Item &comp = index.components.at(i);
+            QStringList compNameAndDefinition;
+
+            compNameAndDefinition.append (comp.name);
+
+            QString s = "<Qucs Schematic " PACKAGE_VERSION ">\n";
+
+            s +=  "<Components>\n  " +
+                  comp.modelString + "\n" +
+                  "</Components>\n";
+
+            compNameAndDefinition.append (s);
+            compNameAndDefinition.append (QString()); // read on selection
+            compNameAndDefinition.append (libPath);
+
+            QTreeWidgetItem* newcompitem = new QTreeWidgetItem(libitem, compNameAndDefinition);
+            newcompitem->setToolTip (0, comp.description);
+            newcompitem->setData (0, Qt::UserRole, comp.offset);
+            newcompitem->setData (0, Qt::UserRole+1, comp.length);
+        }
+        return index.result;
+    }
+
+    ComponentLibrary parsedlibrary;
+
+    int result = parseComponentLibrary (libPath , parsedlibrary);
+    QStringList nameAndFileName;
+    nameAndFileName.append (parsedlibrary.name);
+    nameAndFileName.append (fileName);
+
+    libitem = new QTreeWidgetItem((QTreeWidget*)nullptr, nameAndFileName);
+
+    for (int i = 0; i < parsedlibrary.components.count (); i++)
+    {
+        QStringList compNameAndDefinition;
+
+        compNameAndDefinition.append (parsedlibrary.components[i].name);
+
+        QString s = "<Qucs Schematic " PACKAGE_VERSION ">\n";
+
+        s +=  "<Components>\n  " +
+              parsedlibrary.components[i].modelString + "\n" +
+              "</Components>\n";
+
+        compNameAndDefinition.append (s);
+        compNameAndDefinition.append(parsedlibrary.components[i].definition);
+        compNameAndDefinition.append(libPath);
+
+        QTreeWidgetItem* newcompitem = new QTreeWidgetItem(libitem, compNameAndDefinition);
+
+        // Silence warning from the compiler about unused variable newcompitem
+        // we pass the pointer to the parent item in the constructor
+        Q_UNUSED( newcompitem )
+    }
+    return result;
+}
+
 // Put all available libraries into ComboBox.
 void QucsApp::fillLibrariesTreeView ()
 {
@@ -518,14 +616,8 @@ void QucsApp::fillLibrariesTreeView ()
         QString libPath(*it);
         libPath.chop(4); // remove extension
 
-        ComponentLibrary parsedlibrary;
-
-        int result = parseComponentLibrary (libPath , parsedlibrary);
-        QStringList nameAndFileName;
-        nameAndFileName.append (parsedlibrary.name);
-        nameAndFileName.append (QucsSettings.LibDir + *it);
-
-        QTreeWidgetItem* newlibitem = new QTreeWidgetItem((QTreeWidget*)nullptr, nameAndFileName);
+        QTreeWidgetItem* newlibitem = nullptr;
+        int result = makeLibraryItem (libPath, QucsSettings.LibDir + *it, newlibitem);
 
         switch (result)
         {
@@ -542,29 +634,6 @@ void QucsApp::fillLibrariesTreeView ()
                 break;
         }
 
-        for (int i = 0; i < parsedlibrary.components.count (); i++)
-        {
-            QStringList compNameAndDefinition;
-
-            compNameAndDefinition.append (parsedlibrary.components[i].name);
-
-            QString s = "<Qucs Schematic " PACKAGE_VERSION ">\n";
-
-            s +=  "<Components>\n  " +
-                  parsedlibrary.components[i].modelString + "\n" +
-                  "</Components>\n";
-
-            compNameAndDefinition.append (s);
-            compNameAndDefinition.append(parsedlibrary.components[i].definition);
-            compNameAndDefinition.append(libPath);
-
-            QTreeWidgetItem* newcompitem = new QTreeWidgetItem(newlibitem, compNameAndDefinition);
-
-            // Silence warning from the compiler about unused variable newcompitem
-            // we pass the pointer to the parent item in the constructor
-            Q_UNUSED( newcompitem )
-        }
-
         topitems.append (newlibitem);
     }
 
@@ -595,14 +664,8 @@ void QucsApp::fillLibrariesTreeView ()
             QString libPath(UserLibDir.absoluteFilePath(*it));
             libPath.chop(4); // remove extension
 
-            ComponentLibrary parsedlibrary;
-
-            int result = parseComponentLibrary (libPath, parsedlibrary);
-            QStringList nameAndFileName;
-            nameAndFileName.append (parsedlibrary.name);
-            nameAndFileName.append (UserLibDir.absolutePath() +"/"+ *it);
-
-            QTreeWidgetItem* newlibitem = new QTreeWidgetItem((QTreeWidget*)0, nameAndFileName);
+            QTreeWidgetItem* newlibitem = nullptr;
+            int result = makeLibraryItem (libPath, UserLibDir.absolutePath() +"/"+ *it, newlibitem);
 
             switch (result)
             {
@@ -619,29 +682,6 @@ void QucsApp::fillLibrariesTreeView ()
                     break;
             }
 
-            for (int i = 0; i < parsedlibrary.components.count (); i++)
-            {
-                QStringList compNameAndDefinition;
-
-                compNameAndDefinition.append (parsedlibrary.components[i].name);
-
-                QString s = "<Qucs Schematic " PACKAGE_VERSION ">\n";
-
-                s +=  "<Components>\n  " +
-                      parsedlibrary.components[i].modelString + "\n" +
-                      "</Components>\n";
-
-                compNameAndDefinition.append (s);
-                compNameAndDefinition.append(parsedlibrary.components[i].definition);
-                compNameAndDefinition.append(libPath);
-
-                QTreeWidgetItem* newcompitem = new QTreeWidgetItem(newlibitem, compNameAndDefinition);
-
-                // Silence warning from the compiler about unused variable newcompitem
-                // we pass the pointer to the parent item in the constructor
-                Q_UNUSED( newcompitem )
-            }
-
             topitems.append (newlibitem);
         }
         libTreeWidget->insertTopLevelItems(0, topitems);
@@ -656,6 +696,7 @@ void QucsApp::fillLibrariesTreeView ()
     }
 
     libTreeWidget->insertTopLevelItems(0, topitems);
+    LibraryIndex::save();
 }
 
 
@@ -707,6 +748,12 @@ void QucsApp::fillComboBox (bool setAll)
   CompChoose->clear ();
   CompSearch->clear(); // clear the search box, in case search was active...
 
+  CompChooseAll = setAll;
+  if (!ModulesReady) { // filled in slotModulesReady()
+    CompChoose->insertItem(CompChoose->count(), tr("Loading components..."));
+    return;
+  }
+
   if (!setAll) {
     CompChoose->insertItem(CompChoose->count(), QObject::tr("paintings"));
   } else {
@@ -728,6 +775,7 @@ void QucsApp::slotSetCompView (int index)
 
   QList<Module *> Comps;
   if (CompChoose->count () <= 0) return;
+  if (!ModulesReady) return;
 
   // was in "search mode" ?
   if (CompChoose->itemText(0) == tr("Search results")) {
@@ -749,41 +797,21 @@ void QucsApp::slotSetCompView (int index)
   int catIdx = Category::getModulesNr(item);
 
   Comps = Category::getModules(item);
-  QString Name;
-  pInfoFunc Infos = 0;
 
   // if something was registered dynamically, get and draw icons into dock
   if (item == QObject::tr("verilog-a user devices")) {
 
     compIdx = 0;
-    QMapIterator<QString, QString> i(Module::vaComponents);
-    while (i.hasNext()) {
-      i.next();
-
-      // default icon initially matches the module name
-      //Name = i.key();
-
-      // Just need path to bitmap, do not create an object
-      QString Name, vaBitmap;
-      Component * c = (Component *)
-              vacomponent::info (Name, vaBitmap, false, i.value());
-      if (c) delete c;
+    for (Module *m : Comps) {
+      // name and bitmap were read at registration
+      const QString &Name = m->name;
 
-      // check if icon exists, fall back to default
-      QString iconPath = QucsSettings.QucsWorkDir.filePath(vaBitmap+".png");
-
-      QFile iconFile(iconPath);
-      QPixmap vaIcon;
-
-      if(iconFile.exists())
-      {
-        // load bitmap defined on the JSON symbol file
-        vaIcon = QPixmap(iconPath);
-      }
-      else
+      // bitmap defined on the JSON symbol file, fall back to default
+      QPixmap vaIcon = ComponentIcons::pixmap(m);
+      if (vaIcon.isNull())
       {
         QMessageBox::information(this, tr("Info"),
-                     tr("Default icon not found:\n %1.png").arg(vaBitmap));
+                     tr("Default icon not found:\n %1.png").arg(m->bitmap));
         // default icon
         vaIcon = QPixmap(":/bitmaps/editdelete.png");
       }
@@ -797,18 +825,13 @@ void QucsApp::slotSetCompView (int index)
     }
   } else {
     // static components
-    char * File;
     // Populate list of component bitmaps
     compIdx = 0;
     QList<Module *>::const_iterator it;
     for (it = Comps.constBegin(); it != Comps.constEnd(); it++) {
-      Infos = (*it)->info;
-      if (Infos) {
-        /// \todo warning: expression result unused, can we rewrite this?
-        (void) *((*it)->info) (Name, File, false);
-        QString icon_path = misc::getIconPath(QString (File) + ".png", qucs::compIcons);
-        QListWidgetItem *icon = new QListWidgetItem(QPixmap(icon_path), Name);
-        icon->setToolTip(Name);
+      if ((*it)->info) {
+        QListWidgetItem *icon = new QListWidgetItem(ComponentIcons::pixmap(*it), (*it)->name);
+        icon->setToolTip((*it)->name);
         iconCompInfo = iconCompInfoStruct{catIdx, compIdx};
         v.setValue(iconCompInfo);
         icon->setData(Qt::UserRole, v);
@@ -825,6 +848,7 @@ void QucsApp::slotSetCompView (int index)
 void QucsApp::slotSearchComponent(const QString &searchText)
 {
   qDebug() << "User search: " << searchText;
+  if (!ModulesReady) return;
   CompComps->clear ();   // clear the IconView
 
   // not already in "search mode"
@@ -841,82 +865,51 @@ void QucsApp::slotSearchComponent(const QString &searchText)
     CompChoose->setCurrentIndex(0); // make sure the "Search results" category is selected
     editText->setHidden (true); // disable text edit of component property
 
-    //traverse all component and match searchText with name
-    QString Name;
-    char * File;
-    QList<Module *> Comps;
+    // match searchText with the prebuilt index of component names
     iconCompInfoStruct iconCompInfo{};
     QVariant v;
+    QString key = searchText.toLower();
 
-    QStringList cats = Category::getCategories ();
-    int catIdx = 0;
-    for (const QString& it : cats) {
-      // this will go also over the "verilog-a user devices" category, if present
-      //   but since modules there have no 'info' function it won't handle them
-      Comps = Category::getModules(it);
-      QList<Module *>::const_iterator modit;
-      int compIdx = 0;
-      for (modit = Comps.constBegin(); modit != Comps.constEnd(); modit++) {
-        if ((*modit)->info) {
-          /// \todo warning: expression result unused, can we rewrite this?
-          (void) *((*modit)->info) (Name, File, false);
-
-          if((Name.indexOf(searchText, 0, Qt::CaseInsensitive)) != -1) {
-            //match
-            QString icon_path = misc::getIconPath(QString (File) + ".png", qucs::compIcons);
-            QListWidgetItem *icon = new QListWidgetItem(QPixmap(icon_path), Name);
-            icon->setToolTip(it + ": " + Name);
-            // add component category and module indexes to the icon
-            iconCompInfo = iconCompInfoStruct{catIdx, compIdx};
-            v.setValue(iconCompInfo);
-            icon->setData(Qt::UserRole, v);
-            CompComps->addItem(icon);
-          }
-        }
-        compIdx++;
-      }
-      catIdx++;
+    for (const CompSearchEntry &entry : CompSearchIndex) {
+      if (!entry.key.contains(key)) continue;
+      //match
+      QPixmap pixmap = ComponentIcons::pixmap(entry.module);
+      if (pixmap.isNull())
+        // default icon
+        pixmap = QPixmap(":/bitmaps/editdelete.png");
+      const QString &Name = entry.module->name;
+      QListWidgetItem *icon = new QListWidgetItem(pixmap, Name);
+      icon->setToolTip(entry.category + ": " + Name);
+      // add component category and module indexes to the icon
+      iconCompInfo = iconCompInfoStruct{entry.catIdx, entry.compIdx};
+      v.setValue(iconCompInfo);
+      icon->setData(Qt::UserRole, v);
+      CompComps->addItem(icon);
     }
-    // the "verilog-a user devices" is the last category, if present
-    QMapIterator<QString, QString> i(Module::vaComponents);
-    int compIdx = 0;
-    while (i.hasNext()) {
-      i.next();
-      // Just need path to bitmap, do not create an object
-      QString Name, vaBitmap;
-      vacomponent::info (Name, vaBitmap, false, i.value());
-
-      if((Name.indexOf(searchText, 0, Qt::CaseInsensitive)) != -1) {
-        //match
-
-        // check if icon exists, fall back to default
-        QString iconPath = QucsSettings.QucsWorkDir.filePath(vaBitmap+".png");
-
-        QFile iconFile(iconPath);
-        QPixmap vaIcon;
-
-        if(iconFile.exists())
-        {
-          // load bitmap defined on the JSON symbol file
-          vaIcon = QPixmap(iconPath);
-        }
-        else
-        {
-          // default icon
-          vaIcon = QPixmap(":/bitmaps/editdelete.png");
-        }
+  }
+}
 
-        // Add icon an name tag to dock
-        QListWidgetItem *icon = new QListWidgetItem(vaIcon, Name);
-        icon->setToolTip(tr("verilog-a user devices") + ": " + Name);
-        // Verilog-A is the last category
-        iconCompInfo = iconCompInfoStruct{catIdx-1, compIdx};
-        v.setValue(iconCompInfo);
-        icon->setData(Qt::UserRole, v);
-        CompComps->addItem(icon);
-      }
-      compIdx++;
+// ------------------------------------------------------------------
+// Collects all registered modules into the list searched by
+// slotSearchComponent().
+void QucsApp::buildCompSearchIndex()
+{
+  CompSearchIndex.clear();
+  QStringList cats = Category::getCategories ();
+  int catIdx = 0;
+  for (const QString& it : cats) {
+    QList<Module *> Comps = Category::getModules(it);
+    int compIdx = 0;
+    for (Module *m : Comps) {
+      CompSearchEntry entry;
+      entry.key = m->name.toLower();
+      entry.category = it;
+      entry.catIdx = catIdx;
+      entry.compIdx = compIdx++;
+      entry.module = m;
+      CompSearchIndex.append(entry);
     }
+    catIdx++;
   }
 }
 
@@ -1882,12 +1875,14 @@ void QucsApp::slotChangeView()
     magAll->setDisabled(true);
     if(cursorLeft->isEnabled())
       switchSchematicDoc (false);
+    simTune->setChecked(false);
   }
   // for schematic documents
   else {
     Schematic *d = (Schematic*)w;
     Doc = (QucsDoc*)d;
     magAll->setDisabled(false);
+    simTune->setChecked(d->findChild<NgspiceSession*>() != nullptr);
     // already in schematic?
     if(cursorLeft->isEnabled()) {
       // which mode: schematic or symbol editor ?
@@ -2542,6 +2537,13 @@ void QucsApp::slotSelectLibComponent(QTreeWidgetItem *item)
         QString name = item->text(0);
         QString list = item->text(2);
         QString lib = item->text(3);
+        if(list.isEmpty()) { // indexed library, read the definition now
+            LibraryIndex::Item comp;
+            comp.name = name;
+            comp.offset = item->data(0, Qt::UserRole).toLongLong();
+            comp.length = item->data(0, Qt::UserRole+1).toLongLong();
+            list = LibraryIndex::definition(lib, comp);
+        }
         cb->setText(item->text(1));
         qDebug()<<name<<lib;
 
@@ -2902,32 +2904,9 @@ void QucsApp::updateSchNameHash(void)
     // in directories at the end of the list take precedence over those at the
     // start of the list, we should warn about shadowing of schematic files in
     // this way in the future
-    QStringList nameFilter;
-    nameFilter << "*.sch";
-
-    // clear out any existing hash table entries
-    schNameHash.clear();
-
-    for (const QString& qucspath : qucsPathList) {
-        QDir thispath(qucspath);
-        // get all the schematic files in the directory
-        QFileInfoList schfilesList = thispath.entryInfoList( nameFilter, QDir::Files );
-        // put each one in the hash table with the unique key the base name of
-        // the file, note this will overwrite the value if the key already exists
-        for (const QFileInfo& schfile : schfilesList) {
-            QString bn = schfile.completeBaseName();
-            schNameHash[schfile.completeBaseName()] = schfile.absoluteFilePath();
-        }
-    }
-
-    // finally check the home/working directory
-    QDir thispath(QucsSettings.QucsWorkDir);
-    QFileInfoList schfilesList = thispath.entryInfoList( nameFilter, QDir::Files );
-    // put each one in the hash table with the unique key the base name of
-    // the file, note this will overwrite the value if the key already exists
-    for (const QFileInfo& schfile : schfilesList) {
-        schNameHash[schfile.completeBaseName()] = schfile.absoluteFilePath();
-    }
+    schNameHash = StartupScanner::scanFiles(qucsPathList, QucsSettings.QucsWorkDir,
+                                            QStringList("*.sch"));
+    SchNamesPending = false; // newer than the startup scan
 }
 
 // -----------------------------------------------------------
@@ -2939,36 +2918,42 @@ void QucsApp::updateSpiceNameHash()
     // removes nonexisting entries
     updatePathList();
 
-    // now go through the paths creating a map to all the spice files
-    // found in the directories. Note that we go through the list of paths from
-    // first index to last index. Since keys are unique it means spice files
-    // in directories at the end of the list take precedence over those at the
-    // start of the list, we should warn about shadowing of spice files in
-    // this way in the future
+    // same precedence as for the schematic files
+    spiceNameHash = StartupScanner::scanFiles(qucsPathList, QucsSettings.QucsWorkDir,
+                                              QucsSettings.spiceExtensions);
+    SpiceNamesPending = false; // newer than the startup scan
+}
 
-    // clear out any existing hash table entries
-    spiceNameHash.clear();
-
-    for (const QString& qucspath : qucsPathList) {
-        QDir thispath(qucspath);
-        // get all the schematic files in the directory
-        QFileInfoList spicefilesList = thispath.entryInfoList( QucsSettings.spiceExtensions, QDir::Files );
-        // put each one in the hash table with the unique key the base name of
-        // the file, note this will overwrite the value if the key already exists
-        for (const QFileInfo& spicefile : spicefilesList) {
-            QString bn = spicefile.completeBaseName();
-            schNameHash[spicefile.completeBaseName()] = spicefile.absoluteFilePath();
-        }
-    }
+// -----------------------------------------------------------
+// The name hashes of the startup scan are ready, open the documents
+// given on the command line.
+void QucsApp::slotNamesReady()
+{
+    if (SchNamesPending) schNameHash = Scanner->schNames();
+    if (SpiceNamesPending) spiceNameHash = Scanner->spiceNames();
+    SchNamesPending = SpiceNamesPending = false;
 
-    // finally check the home/working directory
-    QDir thispath(QucsSettings.QucsWorkDir);
-    QFileInfoList spicefilesList = thispath.entryInfoList( QucsSettings.spiceExtensions, QDir::Files );
-    // put each one in the hash table with the unique key the base name of
-    // the file, note this will overwrite the value if the key already exists
-    for (const QFileInfo& spicefile : spicefilesList) {
-        spiceNameHash[spicefile.completeBaseName()] = spicefile.absoluteFilePath();
-    }
+    for (const QString &file : StartupFiles)
+        gotoPage(file);
+    StartupFiles.clear();
+}
+
+// -----------------------------------------------------------
+// All components are registered, fill the component dock.
+void QucsApp::slotModulesReady()
+{
+    ModulesReady = true;
+    buildCompSearchIndex();
+    fillComboBox(CompChooseAll);
+    slotSetCompView(0);
+    Scanner->warmIcons();
+}
+
+// -----------------------------------------------------------
+// The library index is up to date, build the library tree.
+void QucsApp::slotLibrariesReady()
+{
+    fillLibrariesTreeView();
 }
 
 // -----------------------------------------------------------
@@ -3073,6 +3058,56 @@ void QucsApp::slotAfterSpiceSimulation()
     }
 }
 
+// Starts or stops tuning the current schematic. Every edit of the schematic
+// is simulated by a resident Ngspice and the diagrams are updated.
+void QucsApp::slotTune(bool on)
+{
+    QWidget *w = DocumentTab->currentWidget();
+    if ((w == nullptr) || isTextDocument(w)) {
+        simTune->setChecked(false);
+        return;
+    }
+    Schematic *sch = (Schematic*)w;
+    NgspiceSession *session = sch->findChild<NgspiceSession*>();
+    if (!on) {
+        delete session;
+        return;
+    }
+    if (session != nullptr) return;
+
+    if (QucsSettings.DefaultSimulator != spicecompat::simNgspice) {
+        QMessageBox::information(this, tr("Tune with Ngspice"),
+                                 tr("Tuning needs Ngspice as the default simulator."));
+        simTune->setChecked(false);
+        return;
+    }
+
+    session = new NgspiceSession(sch, sch);
+    session->setSimulatorParameters(QucsSettings.SimParameters);
+    connect(session,SIGNAL(finished()),this,SLOT(slotAfterTuning()));
+    connect(session,SIGNAL(errors(QProcess::ProcessError)),this,SLOT(slotTuningErrors()));
+    session->slotStart();
+}
+
+// Shows the results of a tuning step in the diagrams of its schematic,
+// which is not necessarily the current one.
+void QucsApp::slotAfterTuning()
+{
+    NgspiceSession *session = qobject_cast<NgspiceSession*>(sender());
+    if (session == nullptr) return;
+    Schematic *sch = (Schematic*)session->parent();
+    sch->reloadGraphs();
+    sch->viewport()->update();
+}
+
+void QucsApp::slotTuningErrors()
+{
+    NgspiceSession *session = qobject_cast<NgspiceSession*>(sender());
+    if (session == nullptr) return;
+    QStringList lines = session->getOutput().trimmed().split('\n');
+    statusBar()->showMessage(tr("Tuning failed: ") + lines.last(), 5000);
+}
+
 void QucsApp::slotBuildVAModule()
 {
     if (!isTextDocument(DocumentTab->currentWidget())) {
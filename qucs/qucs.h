@@ -61,6 +61,8 @@ class QTextEdit;
 class QFrame;
 
 class SymbolWidget;
+class StartupScanner;
+class Module;
 
 typedef bool (Schematic::*pToggleFunc) ();
 typedef void (MouseActions::*pMouseFunc) (Schematic*, QMouseEvent*);
@@ -181,6 +183,9 @@ private slots:
   void slotSimSettings();
   void slotSimulateWithSpice();
   void slotAfterSpiceSimulation();
+  void slotTune(bool);
+  void slotAfterTuning();
+  void slotTuningErrors();
   void slotBuildVAModule();
   void slotBuildXSPICEIfs(int mode = 0);
   void slotEDDtoIFS();
@@ -188,6 +193,9 @@ private slots:
   void slotShowModel();
   void slotSearchLibComponent(const QString &);
   void slotSearchLibClear();
+  void slotNamesReady();
+  void slotModulesReady();
+  void slotLibrariesReady();
 
 signals:
   void signalKillEmAll();
@@ -212,7 +220,8 @@ public:
           *fileSaveAll, *fileClose, *fileExamples, *fileSettings, *filePrint, *fileQuit,
           *projNew, *projOpen, *projDel, *projClose, *applSettings, *refreshSchPath,
           *editCut, *editCopy, *magAll, *magOne, *magMinus, *filePrintFit,
-          *symEdit, *intoH, *popH, *simulate, *dpl_sch, *undo, *redo, *dcbias;
+          *symEdit, *intoH, *popH, *simulate, *dpl_sch, *undo, *redo, *dcbias,
+          *simTune;
 
   QAction *exportAsImage;
 
@@ -241,6 +250,23 @@ private:
   QFileSystemModel *m_projModel;
   int ccCurIdx; // CompChooser current index (used during search)
 
+  // background scans at startup
+  StartupScanner *Scanner;
+  bool ModulesReady;      // component registry filled
+  bool CompChooseAll;     // last fillComboBox() request
+  bool SchNamesPending;   // scanned schematic name hash not applied yet
+  bool SpiceNamesPending; // scanned SPICE name hash not applied yet
+  QStringList StartupFiles; // documents to load after the scans
+
+  // flat list of all modules for the incremental component search
+  struct CompSearchEntry {
+    QString key;       // lower case display name
+    QString category;
+    int catIdx, compIdx;
+    Module *module;
+  };
+  QList<CompSearchEntry> CompSearchIndex;
+
 // ********** Methods ***************************************************
   void initView();
   void initCursorMenu();
@@ -254,6 +280,7 @@ private:
   bool deleteProject(const QString &);
   void updatePortNumber(QucsDoc*, int);
   void fillComboBox(bool);
+  void buildCompSearchIndex();
   void switchSchematicDoc(bool);
   void switchEditMode(bool);
   void changeSchematicSymbolMode(Schematic*);
@@ -61,6 +61,7 @@
 #include "dialogs/packagedialog.h"
 #include "dialogs/aboutdialog.h"
 #include "module.h"
+#include "componenticons.h"
 
 #include "extsimkernels/xyce.h"
 
@@ -1431,6 +1432,8 @@ void QucsApp::slotLoadModule()
 
     if (ld->exec() == QDialog::Accepted) {
 
+      // the startup scanner may still fill the registry on a pool thread
+      Module::waitForRegistration();
       Module::vaComponents = ld->selectedComponents;
 
       // dialog write new bitmap into JSON
@@ -1449,10 +1452,20 @@ void QucsApp::slotLoadModule()
           it.remove();
         }
       }
+      // and from their category, which owns them
+      for (Category *cat : Category::Categories) {
+        if (cat->Name == QObject::tr("verilog-a user devices")) {
+          qDeleteAll(cat->Content);
+          cat->Content.clear();
+        }
+      }
+      ComponentIcons::clear();
+      buildCompSearchIndex();
 
       if (! Module::vaComponents.isEmpty()) {
         // Register whatever is in Module::vaComponents
         Module::registerDynamicComponents();
+        buildCompSearchIndex();
 
         // update the combobox, set new category in view
         // pick up new category 'verilog-a user components' from `Module::category`
@@ -549,6 +549,12 @@ void QucsApp::initActions()
   dcbias->setWhatsThis(tr("Calculate DC bias\n\nCalculates DC bias and shows it"));
   connect(dcbias, SIGNAL(triggered()), SLOT(slotDCbias()));
 
+  simTune = new QAction(tr("Tune with Ngspice"), this);
+  simTune->setStatusTip(tr("Simulates every change of the schematic"));
+  simTune->setWhatsThis(tr("Tune with Ngspice\n\nKeeps Ngspice running and simulates every change of the schematic"));
+  simTune->setCheckable(true);
+  connect(simTune, SIGNAL(triggered(bool)), SLOT(slotTune(bool)));
+
   setMarker = new QAction(QIcon((":/bitmaps/marker.png")),	tr("Set Marker on Graph"), this);
   setMarker->setShortcut(Qt::CTRL+Qt::Key_B);
   setMarker->setStatusTip(tr("Sets a marker on a diagram's graph"));
@@ -757,6 +763,7 @@ void QucsApp::initMenuBar()
   simMenu->addAction(simulate);
   simMenu->addAction(dpl_sch);
   simMenu->addAction(dcbias);
+  simMenu->addAction(simTune);
   simMenu->addAction(showMsg);
   simMenu->addAction(showNet);
   simMenu->addAction(simSettings);
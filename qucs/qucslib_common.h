@@ -24,6 +24,7 @@
 #include <QDebug>
 
 #include "../qucs/extsimkernels/spicecompat.h"
+#include "../qucs/librarycache.h"
 
 // global functions and data structures for the processing of
 // qucs library files
@@ -221,68 +222,37 @@ inline int makeModelString (QString libPath, QString compname, QString compstrin
 
 inline int parseQucsComponentLibrary (QString libPath, ComponentLibrary &library, LIB_PARSE_WHAT what = QUCS_COMP_LIB_FULL)
 {
-    int Start, End, NameStart, NameEnd;
-
-    QString filename = getLibAbsPath(libPath);
-
-    QFile file (filename);
-
-    if(!file.open(QIODevice::ReadOnly))
+    // The library file is read and split into its components only once
+    // per modification, see LibraryCache
+    LibraryCache::LibraryPtr lib = LibraryCache::library(getLibAbsPath(libPath));
+    if(lib.isNull())
     {
         return QUCS_COMP_LIB_IO_ERROR;
     }
 
-    // Read the whole library file into a string then close it
-    QTextStream ReadWhole(&file);
-    QString LibraryString = ReadWhole.readAll();
-    file.close();
-
-    LibraryString.replace(QRegularExpression("\\r\\n"), "\n");
-
     // The libraries have a header statement like the following:
     //
     // <Qucs Library 0.0.18 "libname">
     //
-    // First do some checking on this statement
-    //
-    // Check for presence of correctly formatted header statement
     // if it's not present assume it is corrupt and exit
-    Start = LibraryString.indexOf("<Qucs Library ");
-    if(Start < 0)
+    if(!lib->headerFound)
     {
         return QUCS_COMP_LIB_CORRUPT;
     }
-    // The library was ok so far, look for the closing > of the header
-    End = LibraryString.indexOf('>', Start);
-    // If the closing > is not found assume corrupt and exit
-    if(End < 0)
-    {
-
-        return QUCS_COMP_LIB_CORRUPT;
-    }
-    // Still ok, so try to extract the library name
-    library.name = LibraryString.mid(Start, End-Start).section('"', 1, 1);
-    // look for nex opening brace of a tag sequence
-    Start = LibraryString.indexOf("\n<", End);
+    library.name = lib->name;
 
-    if(Start < 0)
+    if(lib->empty)
     {
         // nothing else found, library is empty
         return QUCS_COMP_LIB_EMPTY;
     }
 
-    // libraries can have a default symbol section, parse this
-    if(LibraryString.mid(Start+2, 14) == "DefaultSymbol>")
+    // libraries can have a default symbol section
+    if(lib->defaultSymbolCorrupt)
     {
-        End = LibraryString.indexOf("\n</DefaultSymbol>");
-        if(End < 0)
-        {
-            return QUCS_COMP_LIB_CORRUPT;
-        }
-        // copy the contents of default symbol section to a string
-        library.defaultSymbol = LibraryString.mid(Start+16, End-Start-16);
-        Start = End + 3;
+        return QUCS_COMP_LIB_CORRUPT;
     }
+    library.defaultSymbol = lib->defaultSymbol;
 
     if (what == QUCS_COMP_LIB_HEADER_ONLY)
     {
@@ -290,31 +260,18 @@ inline int parseQucsComponentLibrary (QString libPath, ComponentLibrary &library
         return QUCS_COMP_LIB_OK;
     }
 
-    // Now go through the rest of the component library, extracting each
-    // component name
-    while((Start=LibraryString.indexOf("\n<Component ", Start)) > 0)
+    for (const LibraryCache::Component &comp : lib->components)
     {
-        Start++;
-        NameStart = Start + 11;
-        NameEnd = LibraryString.indexOf('>', NameStart);
-        if(NameEnd < 0)  continue;
-
-        End = LibraryString.indexOf("\n</Component>", NameEnd);
-        if(End < 0)  continue;
-        End += 13;
-
         ComponentLibraryItem component;
 
-        component.name = LibraryString.mid(NameStart, NameEnd-NameStart);
-        component.definition = LibraryString.mid(Start, End-Start);
+        component.name = comp.name;
+        component.definition = comp.definition;
 
         // construct model string
         int result = makeModelString (libPath, component.name, component.definition, component.modelString, library.defaultSymbol);
         if (result != QUCS_COMP_LIB_OK) return result;
 
         library.components.append (component);
-
-        Start = End;
     }
 
     return QUCS_COMP_LIB_OK;
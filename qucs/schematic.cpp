@@ -258,6 +258,8 @@ void Schematic::setChanged(bool c, bool fillStack, char Op)
   if(!fillStack)
     return;
 
+  emit signalEdited();  // e.g. to re-run a tuning session, see also undo()
+
 
   // ................................................
   if(symbolMode) {  // for symbol edit mode
@@ -1611,6 +1613,7 @@ bool Schematic::undo()
 
     rebuildSymbol(undoSymbol.at(--undoSymbolIdx));
     adjustPortNumbers();  // set port names
+    emit signalEdited();  // not passed through setChanged()
 
     emit signalUndoState(undoSymbolIdx != 0);
     emit signalRedoState(undoSymbolIdx != undoSymbol.size()-1);
@@ -1631,6 +1634,7 @@ bool Schematic::undo()
 
   rebuild(undoAction.at(--undoActionIdx));
   reloadGraphs();  // load recent simulation data
+  emit signalEdited();  // not passed through setChanged()
 
   emit signalUndoState(undoActionIdx != 0);
   emit signalRedoState(undoActionIdx != undoAction.size()-1);
@@ -1658,6 +1662,7 @@ bool Schematic::redo()
 
     rebuildSymbol(undoSymbol.at(++undoSymbolIdx));
     adjustPortNumbers();  // set port names
+    emit signalEdited();  // not passed through setChanged()
 
     emit signalUndoState(undoSymbolIdx != 0);
     emit signalRedoState(undoSymbolIdx != undoSymbol.size()-1);
@@ -1679,6 +1684,7 @@ bool Schematic::redo()
 
   rebuild(undoAction.at(++undoActionIdx));
   reloadGraphs();  // load recent simulation data
+  emit signalEdited();  // not passed through setChanged()
 
   emit signalUndoState(undoActionIdx != 0);
   emit signalRedoState(undoActionIdx != undoAction.size()-1);
@@ -170,6 +170,7 @@ signals:
   void signalUndoState(bool);
   void signalRedoState(bool);
   void signalFileChanged(bool);
+  void signalEdited();
 
 protected:
   void paintFrame(ViewPainter*);
@@ -283,6 +284,7 @@ public:
   int  prepareNetlist(QTextStream&, QStringList&, QPlainTextEdit*);
   QString createNetlist(QTextStream&, int);
   bool loadDocument();
+  bool loadDocument(QTextStream&);
   void highlightWireLabels (void);
   void clearSignalsAndFileList();
   void clearSignals();
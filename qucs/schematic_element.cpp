@@ -2606,6 +2606,10 @@ void Schematic::recreateComponent(Component *Comp)
 // ---------------------------------------------------
 void Schematic::insertComponent(Component *c)
 {
+    // placed components share the geometry and model strings of equal ones
+    c->shareSymbol();
+    c->internStrings();
+
     // connect every node of component to corresponding schematic node
     insertComponentNodes(c, false);
 
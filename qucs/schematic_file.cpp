@@ -39,14 +39,19 @@
 #include "components/vhdlfile.h"
 #include "components/verilogfile.h"
 #include "components/libcomp.h"
+#include "components/spiceconvcache.h"
 #include "module.h"
 #include "misc.h"
+#include "subcircuitcache.h"
 #include "extsimkernels/abstractspicekernel.h"
 
 
 // Here the subcircuits, SPICE components etc are collected. It must be
 // global to also work within the subcircuits.
 SubMap FileList;
+// Keys of FileList entries which were found again and not emitted a second
+// time. A cached subcircuit netlist must not depend on one of them.
+static QStringList ReusedFiles;
 
 
 // -------------------------------------------------------------
@@ -922,16 +927,29 @@ bool Schematic::loadDocument()
     return false;
   }
 
+  QTextStream stream(&file);
+  bool r = loadDocument(stream);
+  file.close();
+  return r;
+}
+
+/*!
+ * \brief Schematic::loadDocument loads a schematic document from text
+ *        which was already read from the file "DocName", e.g. by the
+ *        subcircuit prefetcher.
+ * \param stream stream holding the whole document
+ * \return true/false in case of success/failure
+ */
+bool Schematic::loadDocument(QTextStream &stream)
+{
   // Keep reference to source file (the schematic file)
   setFileInfo(DocName);
 
   QString Line;
-  QTextStream stream(&file);
 
   // read header **************************
   do {
     if(stream.atEnd()) {
-      file.close();
       return true;
     }
 
@@ -939,7 +957,6 @@ bool Schematic::loadDocument()
   } while(Line.isEmpty());
 
   if(Line.left(16) != "<Qucs Schematic ") {  // wrong file type ?
-    file.close();
     QMessageBox::critical(0, QObject::tr("Error"),
  		 QObject::tr("Wrong document type: ")+DocName);
     return false;
@@ -957,7 +974,6 @@ bool Schematic::loadDocument()
                                   QMessageBox::Yes|QMessageBox::No);
 
     if (result==QMessageBox::No) {
-        file.close();
         return false;
     }
 
@@ -972,36 +988,31 @@ bool Schematic::loadDocument()
     if(Line.isEmpty()) continue;
 
     if(Line == "<Symbol>") {
-      if(!loadPaintings(&stream, &SymbolPaints)) {
-        file.close();
-        return false;
-      }
+      if(!loadPaintings(&stream, &SymbolPaints)) return false;
     }
     else
     if(Line == "<Properties>") {
-      if(!loadProperties(&stream)) { file.close(); return false; } }
+      if(!loadProperties(&stream)) return false; }
     else
     if(Line == "<Components>") {
-      if(!loadComponents(&stream)) { file.close(); return false; } }
+      if(!loadComponents(&stream)) return false; }
     else
     if(Line == "<Wires>") {
-      if(!loadWires(&stream)) { file.close(); return false; } }
+      if(!loadWires(&stream)) return false; }
     else
     if(Line == "<Diagrams>") {
-      if(!loadDiagrams(&stream, &DocDiags)) { file.close(); return false; } }
+      if(!loadDiagrams(&stream, &DocDiags)) return false; }
     else
     if(Line == "<Paintings>") {
-      if(!loadPaintings(&stream, &DocPaints)) { file.close(); return false; } }
+      if(!loadPaintings(&stream, &DocPaints)) return false; }
     else {
        qDebug() << Line;
        QMessageBox::critical(0, QObject::tr("Error"),
 		   QObject::tr("File Format Error:\nUnknown field!"));
-      file.close();
       return false;
     }
   }
 
-  file.close();
   return true;
 }
 
@@ -1337,6 +1348,7 @@ bool Schematic::throughAllComps(QTextStream *stream, int& countInit,
             i++;
           }
         }
+        ReusedFiles.append(f);
         continue;   // insert each subcircuit just one time
       }
 
@@ -1344,13 +1356,43 @@ bool Schematic::throughAllComps(QTextStream *stream, int& countInit,
       SubFile sub = SubFile("SCH", f);
       FileList.insert(f, sub);
 
+      s = pc->Props.first()->Value;
+
+      // SPICE subcircuit netlists don't depend on the node set counter,
+      // so they can be reused from previous simulations
+      bool cacheable = isAnalog && !creatingLib &&
+          (QucsSettings.DefaultSimulator != spicecompat::simQucsator);
+      QString dialect = QString::number(QucsSettings.DefaultSimulator) + '\n' + s;
+      QString subText;
+      QStringList subPortTypes;
+      SubMap nested;
+      bool hit = cacheable &&
+          SubcircuitCache::netlist(f, dialect, subText, subPortTypes, nested);
+      // the cached text defines the nested subcircuits, too, so it cannot
+      // be used if one of them has already been emitted
+      for (auto n = nested.constBegin(); hit && (n != nested.constEnd()); ++n)
+        if (FileList.contains(n.key())) hit = false;
+      if (hit)
+      {
+        (*stream) << subText;
+        i = 0;
+        for (Port *pp : pc->Ports)
+        {
+          pp->Type = subPortTypes[i];
+          pp->Connection->DType = pp->Type;
+          i++;
+        }
+        sub.PortTypes = subPortTypes;
+        FileList.insert(f, sub);
+        for (auto n = nested.constBegin(); n != nested.constEnd(); ++n)
+          FileList.insert(n.key(), n.value());
+        continue;
+      }
 
       // load subcircuit schematic
-      s = pc->Props.first()->Value;
-      Schematic *d = new Schematic(0, pc->getSubcircuitFile());
-      if(!d->loadDocument())      // load document if possible
+      Schematic *d = SubcircuitCache::document(f);
+      if(!d)      // load document if possible
       {
-          delete d;
           /// \todo implement error/warning message dispatcher for GUI and CLI modes.
           QString message = QObject::tr("ERROR: Cannot load subcircuit \"%1\".").arg(s);
           if (QucsMain) // GUI is running
@@ -1359,11 +1401,21 @@ bool Schematic::throughAllComps(QTextStream *stream, int& countInit,
             qCritical() << "Schematic::throughAllComps" << message;
           return false;
       }
+      d->clearSignals();
       d->DocName = s;
       d->isVerilog = isVerilog;
       d->isAnalog = isAnalog;
       d->creatingLib = creatingLib;
-      r = d->createSubNetlist(stream, countInit, Collect, ErrText, NumPorts);
+      SubMap before = FileList;
+      int reusedFrom = ReusedFiles.size();
+      if (cacheable) {
+        QTextStream subStream(&subText);
+        r = d->createSubNetlist(&subStream, countInit, Collect, ErrText, NumPorts);
+        subStream.flush();
+        (*stream) << subText;
+      } else {
+        r = d->createSubNetlist(stream, countInit, Collect, ErrText, NumPorts);
+      }
       if (r)
       {
         i = 0;
@@ -1378,8 +1430,18 @@ bool Schematic::throughAllComps(QTextStream *stream, int& countInit,
         sub.PortTypes = d->PortTypes;
         FileList.insert(f,sub);
         //FileList.replace(f, sub);
+        // store the text only if it contains all nested definitions,
+        // i.e. none of them was emitted before this subcircuit
+        bool complete = true;
+        for (int k = reusedFrom; k < ReusedFiles.size(); k++)
+          if (before.contains(ReusedFiles.at(k))) complete = false;
+        if (cacheable && complete) {
+          nested.clear();
+          for (auto n = FileList.constBegin(); n != FileList.constEnd(); ++n)
+            if (!before.contains(n.key())) nested.insert(n.key(), n.value());
+          SubcircuitCache::storeNetlist(f, dialect, subText, d->PortTypes, nested);
+        }
       }
-      delete d;
       if(!r)
       {
         return false;
@@ -1397,8 +1459,10 @@ bool Schematic::throughAllComps(QTextStream *stream, int& countInit,
       QString scfile = pc->getSubcircuitFile();
       s = scfile + "/" + pc->Props.at(1)->Value;
       SubMap::Iterator it = FileList.find(s);
-      if(it != FileList.end())
+      if(it != FileList.end()) {
+        ReusedFiles.append(s);
         continue;   // insert each library subcircuit just one time
+      }
       FileList.insert(s, SubFile("LIB", s));
 
 
@@ -1434,8 +1498,10 @@ bool Schematic::throughAllComps(QTextStream *stream, int& countInit,
       }
       QString f = pc->getSubcircuitFile();
       SubMap::Iterator it = FileList.find(f);
-      if(it != FileList.end())
+      if(it != FileList.end()) {
+        ReusedFiles.append(f);
         continue;   // insert each spice component just one time
+      }
       FileList.insert(f, SubFile("CIR", f));
 
       SpiceFile *sf = (SpiceFile*)pc;
@@ -1464,8 +1530,10 @@ bool Schematic::throughAllComps(QTextStream *stream, int& countInit,
       }
       QString f = pc->getSubcircuitFile();
       SubMap::Iterator it = FileList.find(f);
-      if(it != FileList.end())
+      if(it != FileList.end()) {
+        ReusedFiles.append(f);
         continue;   // insert each vhdl/verilog component just one time
+      }
       s = ((pc->Model == "VHDL") ? "VHD" : "VER");
       FileList.insert(f, SubFile(s, f));
 
@@ -1545,6 +1613,7 @@ bool Schematic::createLibNetlist(QTextStream *stream, QPlainTextEdit *ErrText,
   QStringList Collect;
   Collect.clear();
   FileList.clear();
+  ReusedFiles.clear();
   Signals.clear();
   // Apply node names and collect subcircuits and file include
   creatingLib = true;
@@ -1973,9 +2042,21 @@ int Schematic::prepareNetlist(QTextStream& stream, QStringList& Collect,
     stream << "\n`timescale 1ps/100fs\n";
   }
 
+  // no cached subcircuit document is in use between two netlists
+  SubcircuitCache::trim();
+  if (QucsSettings.DefaultSimulator == spicecompat::simQucsator) {
+    // convert the SPICE files not cached yet in parallel
+    SpiceConvCache::prefetch(this);
+  } else {
+    // read the subcircuit files of the hierarchy in the background
+    SubcircuitCache::prefetch(this);
+  }
+
   int countInit = 0;  // counts the nodesets to give them unique names
 
-  if(!giveNodeNames(&stream, countInit, Collect, ErrText, NumPorts)){
+  bool named = giveNodeNames(&stream, countInit, Collect, ErrText, NumPorts);
+  SubcircuitCache::dropPrefetched();
+  if(!named){
     fprintf(stderr, "Error giving NodeNames\n");
     return -10;
   }
@@ -2046,6 +2127,7 @@ QString Schematic::createNetlist(QTextStream& stream, int NumPorts)
 
   Signals.clear();  // was filled in "giveNodeNames()"
   FileList.clear();
+  ReusedFiles.clear();
 
   QString s, Time;
   for(Component *pc = DocComps.first(); pc != 0; pc = DocComps.next()) {
@@ -2092,6 +2174,7 @@ void Schematic::clearSignalsAndFileList()
 {
     Signals.clear();  // was filled in "giveNodeNames()"
     FileList.clear();
+    ReusedFiles.clear();
 }
 
 void Schematic::clearSignals()
@@ -0,0 +1,252 @@
+/***************************************************************************
+                                simlog.cpp
+                               ------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "simlog.h"
+
+#include <QDir>
+#include <QPlainTextEdit>
+#include <QTextCursor>
+
+#include <algorithm>
+
+/*!
+  \file simlog.cpp
+  \brief Implementation of the SimLog and SimProgressScanner classes
+*/
+
+SimLog::SimLog(QObject *parent) : QObject(parent)
+{
+    Dropped = 0;
+    Errors = false;
+    View = nullptr;
+    Frame.setSingleShot(true);
+    Frame.setInterval(FrameInterval);
+    connect(&Frame,SIGNAL(timeout()),this,SLOT(slotFrame()));
+}
+
+SimLog::~SimLog()
+{
+    File.close();
+}
+
+/*!
+ * \brief SimLog::setFileName Set the log file. It is written from the
+ *        next output on.
+ */
+void SimLog::setFileName(const QString &file)
+{
+    File.close();
+    File.setFileName(file);
+}
+
+QString SimLog::fileName()
+{
+    return File.fileName();
+}
+
+/*!
+ * \brief SimLog::setView Show the output in a text view. The view keeps
+ *        the last MaxLines lines.
+ */
+void SimLog::setView(QPlainTextEdit *view)
+{
+    View = view;
+    if (View != nullptr) View->setMaximumBlockCount(MaxLines);
+}
+
+/*!
+ * \brief SimLog::clear Start a new log, the log file is truncated.
+ */
+void SimLog::clear()
+{
+    Frame.stop();
+    if (!File.fileName().isEmpty()) {
+        File.close();
+        File.remove();
+    }
+    Tail.clear();
+    Pending.clear();
+    Dropped = 0;
+    Errors = false;
+    ErrorCarry.clear();
+}
+
+/*!
+ * \brief SimLog::append Add a chunk of simulator output. The tail in
+ *        memory is trimmed to MaxChars when it has grown to twice the
+ *        size, so every character is copied a bounded number of times.
+ */
+void SimLog::append(const QString &text)
+{
+    if (text.isEmpty()) return;
+
+    if (!File.isOpen() && !File.fileName().isEmpty())
+        File.open(QIODevice::WriteOnly | QIODevice::Append);
+    if (File.isOpen()) File.write(text.toUtf8());
+
+    if (!Errors) {
+        QString s = ErrorCarry + text;
+        Errors = s.contains("error",Qt::CaseInsensitive);
+        ErrorCarry = s.right(4);
+    }
+
+    Tail += text;
+    if (Tail.size() > 2*MaxChars) Dropped += keepTail(Tail,MaxChars);
+
+    if (View != nullptr) {
+        Pending += text;
+        if (Pending.size() > 2*MaxChars) keepTail(Pending,MaxChars);
+        if (!Frame.isActive()) Frame.start();
+    }
+}
+
+/*!
+ * \brief SimLog::flush Show the pending output in the view now and write
+ *        the log file, e.g. before other messages are added to the view.
+ */
+void SimLog::flush()
+{
+    Frame.stop();
+    if (File.isOpen()) File.flush();
+    if ((View == nullptr) || Pending.isEmpty()) return;
+    View->moveCursor(QTextCursor::End);
+    View->insertPlainText(Pending);
+    View->moveCursor(QTextCursor::End);
+    Pending.clear();
+}
+
+void SimLog::slotFrame()
+{
+    flush();
+}
+
+/*!
+ * \brief SimLog::text The output kept in memory. If the beginning was
+ *        dropped, a note refers to the log file.
+ */
+QString SimLog::text()
+{
+    if (Dropped == 0) return Tail;
+    if (File.isOpen()) File.flush();
+    return QString("[... %1 characters omitted, the whole output is in %2]\n")
+            .arg(Dropped).arg(QDir::toNativeSeparators(File.fileName())) + Tail;
+}
+
+/*!
+ * \brief SimLog::hasErrors Whether "error" appeared anywhere in the output
+ *        since the last clear().
+ */
+bool SimLog::hasErrors()
+{
+    return Errors;
+}
+
+// ---------------------------------------------------------------------
+// Keeps the last limit characters, starting at a line if there is one
+// nearby. Returns the number of characters removed.
+qint64 SimLog::keepTail(QString &text, int limit)
+{
+    if (text.size() <= limit) return 0;
+    int cut = text.size() - limit;
+    int lf = text.indexOf('\n',cut);
+    if ((lf >= 0) && (lf - cut < 1024)) cut = lf + 1;
+    text.remove(0,cut);
+    return cut;
+}
+
+
+/*!
+ * \brief SimProgressScanner::SimProgressScanner Class constructor
+ * \param marker Text in front of the percentage
+ * \param strip Remove the reports from the output
+ */
+SimProgressScanner::SimProgressScanner(const QString &marker, bool strip)
+{
+    Marker = marker;
+    Strip = strip;
+}
+
+/*!
+ * \brief SimProgressScanner::scan Find the progress reports in a chunk of
+ *        output. With strip, the reports and the backspaces Ngspice writes
+ *        over them are removed from the chunk. A possible report at the
+ *        end of the chunk is held back until the next call.
+ * \param chunk[in,out] Simulator output
+ * \return Last percentage in the chunk, or -1 if there is none
+ */
+int SimProgressScanner::scan(QString &chunk)
+{
+    if (Marker.isEmpty()) return -1;
+
+    QString text = Carry + chunk;
+    Carry.clear();
+    if (Strip) text.remove(QChar('\010'));
+
+    int end = text.size();
+    // a marker cut off at the end of the chunk
+    for (int k = std::min<int>(Marker.size() - 1, end); k > 0; k--) {
+        if (text.endsWith(Marker.left(k))) {
+            end -= k;
+            break;
+        }
+    }
+
+    int percent = -1;
+    QString out;
+    int from = 0, i;
+    while (((i = text.indexOf(Marker,from)) >= 0) && (i < end)) {
+        int num = i + Marker.size();
+        while ((num < text.size()) && (text.at(num) == ' ')) num++;
+        int j = num;
+        bool point = false;
+        while ((j < text.size()) && (text.at(j).isDigit() || (text.at(j) == '.'))) {
+            if (text.at(j) == '.') point = true;
+            j++;
+        }
+        if (j == text.size()) {  // the number may go on in the next chunk
+            end = i;
+            break;
+        }
+
+        bool ok = false;
+        double value = text.mid(num,j-num).toDouble(&ok);
+        if (!ok || !point) {  // no report, e.g. a percent sign in a message
+            out += text.mid(from,j-from);
+            from = j;
+            continue;
+        }
+        percent = qRound(value);
+        out += text.mid(from,(Strip ? i : j) - from);
+        from = j;
+    }
+
+    end = std::max(end,from);
+    out += text.mid(from,end-from);
+    Carry = text.mid(end);
+    chunk = out;
+    return percent;
+}
+
+/*!
+ * \brief SimProgressScanner::remainder Output held back at the end of the
+ *        last chunk, to be added when the simulator has finished.
+ */
+QString SimProgressScanner::remainder()
+{
+    QString s = Carry;
+    Carry.clear();
+    return s;
+}
@@ -0,0 +1,100 @@
+/***************************************************************************
+                                 simlog.h
+                                ----------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SIMLOG_H
+#define SIMLOG_H
+
+#include <QObject>
+#include <QString>
+#include <QFile>
+#include <QTimer>
+
+class QPlainTextEdit;
+
+/*!
+  \file simlog.h
+  \brief Declaration of the SimLog and SimProgressScanner classes
+*/
+
+/*!
+ * \brief The SimLog class collects the output of a simulator. The whole
+ *        output goes into a log file, only its tail is kept in memory.
+ *
+ *        A text view can be attached to show the output while the
+ *        simulator runs. The output is not passed on chunk by chunk but
+ *        once per frame, and the view keeps a limited number of lines.
+ *        Error messages are noted as the output comes in, so they are
+ *        found even if they are gone from memory.
+ */
+class SimLog : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SimLog(QObject *parent = 0);
+    ~SimLog();
+
+    static const int MaxChars = 1 << 20;    //!< tail kept in memory
+    static const int MaxLines = 20000;      //!< lines kept by the view
+    static const int FrameInterval = 50;    //!< ms between view updates
+
+    void setFileName(const QString &file);
+    QString fileName();
+    void setView(QPlainTextEdit *view);
+
+    void clear();
+    void append(const QString &text);
+    void flush();
+    QString text();
+    bool hasErrors();
+
+private slots:
+    void slotFrame();
+
+private:
+    QFile File;
+    QString Tail;
+    qint64 Dropped;      // characters dropped from the tail
+    bool Errors;         // "error" somewhere in the output
+    QString ErrorCarry;  // end of the last chunk, "error" may be split
+    QString Pending;     // not shown in the view yet
+    QPlainTextEdit *View;
+    QTimer Frame;
+
+    static qint64 keepTail(QString &text, int limit);
+};
+
+/*!
+ * \brief The SimProgressScanner class finds the progress reports in the
+ *        output of a simulator, chunk by chunk and without regular
+ *        expressions. A report is a marker followed by a decimal number,
+ *        e.g. "%42.17" of Ngspice. The start of a report at the end of a
+ *        chunk is kept and completed with the next chunk.
+ */
+class SimProgressScanner
+{
+public:
+    explicit SimProgressScanner(const QString &marker = QString(), bool strip = false);
+
+    int scan(QString &chunk);
+    QString remainder();
+
+private:
+    QString Marker;
+    bool Strip;      // remove the reports from the output
+    QString Carry;   // possible start of a report
+};
+
+#endif // SIMLOG_H
@@ -0,0 +1,234 @@
+/***************************************************************************
+                             simresultcache.cpp
+                            --------------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "simresultcache.h"
+#include "main.h"
+#include "misc.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QStandardPaths>
+
+/*!
+  \file simresultcache.cpp
+  \brief Implementation of the SimResultCache class
+*/
+
+// limits of the cache directory, the oldest datasets are removed first
+#define CACHE_MAX_ENTRIES  200
+#define CACHE_MAX_BYTES    (256 * 1024 * 1024)
+
+// referenced files are scanned for further references only if smaller
+#define SCAN_MAX_BYTES     (8 * 1024 * 1024)
+
+/*!
+ * \brief SimResultCache::key Compute the cache key of a simulation.
+ * \param files Netlists and other input files written for the simulator
+ * \param simulator Simulator command, the executable may be followed by
+ *        arguments (e.g. mpirun for parallel Xyce)
+ * \param options Simulator command line options and settings that change
+ *        the result
+ * \param workdir Simulator working directory. It is masked in all files,
+ *        so the same circuit gets the same key in every working directory.
+ *        May be empty if the simulator writes no files besides the dataset.
+ * \return SHA-1 hex digest, or an empty string if the result changes
+ *         from run to run, see scanRandom()
+ */
+QString SimResultCache::key(const QStringList &files, const QString &simulator,
+                            const QString &options, const QString &workdir)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(PACKAGE_VERSION); // the dataset conversion may change
+
+    QString exe = misc::parseCmdArgs(simulator).value(0);
+    QFileInfo sim(exe);
+    if (!sim.exists()) sim = QFileInfo(QStandardPaths::findExecutable(exe));
+    hash.addData(simulator.toUtf8());
+    hash.addData(sim.absoluteFilePath().toUtf8());
+    hash.addData(QByteArray::number(sim.size()));
+    hash.addData(QByteArray::number(sim.lastModified().toMSecsSinceEpoch()));
+    hash.addData(options.toUtf8());
+
+    QSet<QString> visited;
+    bool random = false, seeded = options.contains("seed",Qt::CaseInsensitive);
+    for (const QString &file : files)
+        addFile(hash, file, workdir, visited, random, seeded);
+    if (random && !seeded) return QString();  // see scanRandom()
+
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+/*!
+ * \brief SimResultCache::contains Check if a dataset is cached for the key.
+ */
+bool SimResultCache::contains(const QString &key)
+{
+    return !key.isEmpty() && QFile::exists(cacheFile(key));
+}
+
+/*!
+ * \brief SimResultCache::fetch Copy the cached dataset of a simulation.
+ * \param key Cache key of the simulation
+ * \param dataset File name of the Qucs dataset to create
+ * \return True if the dataset was restored from the cache
+ */
+bool SimResultCache::fetch(const QString &key, const QString &dataset)
+{
+    if (!contains(key)) return false;
+    QFile::remove(dataset);
+    if (!QFile::copy(cacheFile(key), dataset)) return false;
+
+    QFile f(cacheFile(key)); // mark as recently used
+    if (f.open(QIODevice::ReadWrite)) {
+        f.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+        f.close();
+    }
+    return true;
+}
+
+/*!
+ * \brief SimResultCache::store Add the dataset of a successful simulation
+ *        to the cache. The file is renamed into place, so a concurrent
+ *        simulation never reads a partly written dataset.
+ * \param key Cache key of the simulation
+ * \param dataset File name of the converted Qucs dataset
+ */
+void SimResultCache::store(const QString &key, const QString &dataset)
+{
+    if (key.isEmpty() || !QFile::exists(dataset)) return;
+    QString cached = cacheFile(key);
+    QDir().mkpath(QFileInfo(cached).absolutePath());
+
+    QString tmp = cached + QString(".%1.tmp").arg(QCoreApplication::applicationPid());
+    QFile::remove(tmp);
+    if (!QFile::copy(dataset, tmp)) return;
+    QFile::remove(cached);
+    if (!QFile::rename(tmp, cached)) QFile::remove(tmp);
+
+    prune();
+}
+
+// ---------------------------------------------------------------------
+// Hashes the name and the content of a file and of every file it refers
+// to. Each file is taken once, even if it is included several times.
+void SimResultCache::addFile(QCryptographicHash &hash, const QString &file,
+                             const QString &workdir, QSet<QString> &visited,
+                             bool &random, bool &seeded)
+{
+    QFileInfo inf(file);
+    QString name = inf.canonicalFilePath();
+    if (name.isEmpty() || visited.contains(name)) return;
+    visited.insert(name);
+
+    QFile f(name);
+    if (!f.open(QIODevice::ReadOnly)) return;
+    QByteArray data = f.readAll();
+    f.close();
+
+    if (!workdir.isEmpty()) {
+        data.replace(QDir(workdir).absolutePath().toUtf8(), "$(WORKDIR)");
+        name.replace(QDir(workdir).canonicalPath(), "$(WORKDIR)");
+    }
+    hash.addData(name.toUtf8());
+    hash.addData(QByteArray::number(data.size()));
+    hash.addData(data);
+
+    if (data.size() > SCAN_MAX_BYTES || data.contains('\0')) return; // not a netlist
+    QString text = QString::fromUtf8(data);
+    scanRandom(text, random, seeded);
+    QStringList refs = referencedFiles(text, inf.absolutePath(), workdir);
+    for (const QString &ref : refs)
+        addFile(hash, ref, workdir, visited, random, seeded);
+}
+
+// ---------------------------------------------------------------------
+// Notes whether a netlist draws random numbers (noise sources, statistical
+// functions, Monte Carlo loops) and whether it fixes the seed of the
+// generator. The seed is part of the netlist text and hence of the key.
+void SimResultCache::scanRandom(const QString &text, bool &random, bool &seeded)
+{
+    static const QRegularExpression randomFunc(
+        "\\b(trnoise|trrandom|agauss|aunif|gauss|unif|sgauss|sunif|rnd|rand|ranexp|poisson)\\s*\\(",
+        QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression seed("\\b(rndseed|seed)\\s*=?\\s*\\d",
+        QRegularExpression::CaseInsensitiveOption);
+    if (!random) random = text.contains(randomFunc);
+    if (!seeded) seeded = text.contains(seed);
+}
+
+// ---------------------------------------------------------------------
+// Returns the existing files a netlist or model file names, i.e. the
+// arguments of SPICE .include/.lib statements and all quoted strings,
+// which covers the file properties of Qucsator components. Files in the
+// simulator working directory are simulator outputs and are skipped.
+QStringList SimResultCache::referencedFiles(const QString &text, const QString &dir,
+                                            const QString &workdir)
+{
+    QStringList candidates;
+    static const QRegularExpression quoted("\"([^\"\\n]+)\"");
+    QRegularExpressionMatchIterator it = quoted.globalMatch(text);
+    while (it.hasNext()) candidates.append(it.next().captured(1));
+
+    static const QRegularExpression include("^\\s*\\.(include|incl|inc|lib)\\s+'?([^\\s']+)",
+                                            QRegularExpression::CaseInsensitiveOption |
+                                            QRegularExpression::MultilineOption);
+    it = include.globalMatch(text);
+    while (it.hasNext()) candidates.append(it.next().captured(2));
+
+    QString outputs = workdir.isEmpty() ? QString() : QDir(workdir).canonicalPath() + "/";
+    QStringList files;
+    for (QString name : candidates) {
+        name = name.trimmed();
+        if (name.startsWith('{') && name.endsWith('}')) name = name.mid(1, name.length() - 2);
+        if (name.isEmpty()) continue;
+        QFileInfo inf(name);
+        if (inf.isRelative()) inf = QFileInfo(dir + QDir::separator() + name);
+        if (!inf.isFile()) continue;
+        if (!outputs.isEmpty() && inf.canonicalFilePath().startsWith(outputs)) continue;
+        files.append(inf.absoluteFilePath());
+    }
+    return files;
+}
+
+// ---------------------------------------------------------------------
+QString SimResultCache::cacheFile(const QString &key)
+{
+    return QucsSettings.QucsHomeDir.absolutePath() + QDir::separator() + "simcache" +
+           QDir::separator() + key + ".dat";
+}
+
+// ---------------------------------------------------------------------
+// Removes the least recently used datasets beyond the size limits.
+void SimResultCache::prune()
+{
+    QDir dir(QucsSettings.QucsHomeDir.absolutePath() + QDir::separator() + "simcache");
+    QFileInfoList entries = dir.entryInfoList(QStringList("*.dat"), QDir::Files, QDir::Time);
+    qint64 total = 0;
+    for (int i = 0; i < entries.count(); i++) {
+        total += entries.at(i).size();
+        if (i >= CACHE_MAX_ENTRIES || (i > 0 && total > CACHE_MAX_BYTES))
+            QFile::remove(entries.at(i).absoluteFilePath());
+    }
+}
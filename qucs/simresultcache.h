@@ -0,0 +1,65 @@
+/***************************************************************************
+                              simresultcache.h
+                             ------------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SIMRESULTCACHE_H
+#define SIMRESULTCACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QSet>
+
+class QCryptographicHash;
+
+/*!
+  \file simresultcache.h
+  \brief Declaration of the SimResultCache class
+*/
+
+/*!
+ * \brief The SimResultCache class keeps converted Qucs datasets of earlier
+ *        simulations on disk, so an unchanged circuit is not simulated
+ *        again. A result is keyed by the content of the netlists, the
+ *        simulator executable (path, size and modification time), its
+ *        options and the content of all files the netlists refer to, such
+ *        as SPICE libraries, model includes and S-parameter files.
+ *        Netlists drawing random numbers without a fixed seed are not
+ *        cached, their results differ from run to run.
+ *
+ *        The cache lives in the Qucs home directory and is shared by all
+ *        sessions. The least recently used datasets are dropped when it
+ *        grows beyond its size limit.
+ */
+class SimResultCache
+{
+public:
+    static QString key(const QStringList &files, const QString &simulator,
+                       const QString &options, const QString &workdir);
+    static bool contains(const QString &key);
+    static bool fetch(const QString &key, const QString &dataset);
+    static void store(const QString &key, const QString &dataset);
+
+private:
+    static void addFile(QCryptographicHash &hash, const QString &file,
+                        const QString &workdir, QSet<QString> &visited,
+                        bool &random, bool &seeded);
+    static void scanRandom(const QString &text, bool &random, bool &seeded);
+    static QStringList referencedFiles(const QString &text, const QString &dir,
+                                       const QString &workdir);
+    static QString cacheFile(const QString &key);
+    static void prune();
+};
+
+#endif // SIMRESULTCACHE_H
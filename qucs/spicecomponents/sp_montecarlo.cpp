@@ -0,0 +1,204 @@
+/***************************************************************************
+                             sp_montecarlo.cpp
+                            -------------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "sp_montecarlo.h"
+#include "main.h"
+#include "misc.h"
+
+#include <QRegularExpression>
+
+#include <algorithm>
+
+// corner runs take every combination of the parameter limits
+#define MAX_CORNER_PARAMS 12
+
+
+SpiceMonteCarlo::SpiceMonteCarlo()
+{
+  Description = QObject::tr("Monte Carlo analysis");
+
+  qDeleteAll(Texts);
+  Texts.clear();
+  QString  s = Description;
+  int a = s.lastIndexOf(" ");
+  if (a != -1) s[a] = '\n';    // break line
+
+  Texts.append(new Text(0, 0, s.left(a), Qt::darkRed, QucsSettings.largeFontSize));
+  if (a != -1)
+    Texts.append(new Text(0, 0, s.mid(a+1), Qt::darkRed, QucsSettings.largeFontSize));
+
+  Model = ".MC";
+  Name  = "MC";
+  SpiceModel = "MC";
+
+  // The property "Sim" must be the first one. Used by the Ngspice netlister.
+  Props.clear();
+  Props.append(new Property("Sim", "", true,
+		QObject::tr("simulation to repeat")));
+  Props.append(new Property("Type", "montecarlo", true,
+		QObject::tr("analysis type")+" [montecarlo, corner]"));
+  Props.append(new Property("Param", "R1", true,
+		QObject::tr("parameters to vary, separated by semicolons")));
+  Props.append(new Property("Nominal", "1k", false,
+		QObject::tr("nominal values of the parameters")));
+  Props.append(new Property("Tolerance", "5%", true,
+		QObject::tr("relative tolerances of the parameters, 3 sigma of the gaussian distribution")));
+  Props.append(new Property("Distribution", "gauss", false,
+		QObject::tr("distributions of the parameters")+" [gauss, unif]"));
+  Props.append(new Property("Runs", "100", true,
+		QObject::tr("number of Monte Carlo runs")));
+  Props.append(new Property("Seed", "1", false,
+		QObject::tr("number of the first run, the runs are seeded with their number")));
+}
+
+SpiceMonteCarlo::~SpiceMonteCarlo()
+{
+}
+
+Component* SpiceMonteCarlo::newOne()
+{
+  return new SpiceMonteCarlo();
+}
+
+Element* SpiceMonteCarlo::info(QString& Name, char* &BitmapFile, bool getNewOne)
+{
+  Name = QObject::tr("Monte Carlo analysis");
+  BitmapFile = (char *) "sweep";
+
+  if(getNewOne)  return new SpiceMonteCarlo();
+  return 0;
+}
+
+/*!
+ * \brief SpiceMonteCarlo::getSweepValues Run numbers, starting at the seed.
+ *        A corner analysis has one run for each combination of limits.
+ */
+QStringList SpiceMonteCarlo::getSweepValues()
+{
+    int runs;
+    if (getProperty("Type")->Value == "corner") {
+        int params = getProperty("Param")->Value.split(param_split_str,qucs::SkipEmptyParts).count();
+        runs = 1 << std::min(params, MAX_CORNER_PARAMS);
+    } else {
+        runs = std::max(1, getProperty("Runs")->Value.toInt());
+    }
+
+    QStringList values;
+    int first = getFirstRun();
+    for (int i = 0; i < runs; i++)
+        values.append(QString::number(first + i));
+    return values;
+}
+
+/*!
+ * \brief SpiceMonteCarlo::getNgspiceBeforeSim Open the loop over the runs
+ *        and set the parameters of the run. The values are computed by
+ *        Ngspice from its random number generator, seeded with the run
+ *        number.
+ */
+QString SpiceMonteCarlo::getNgspiceBeforeSim(QString sim, int lvl)
+{
+    if (isActive != COMP_IS_ACTIVE) return QString("");
+
+    bool corner = (getProperty("Type")->Value == "corner");
+    QStringList params = getProperty("Param")->Value.split(param_split_str,qucs::SkipEmptyParts);
+
+    // once, before the loop: the parameters beyond the limit are not varied
+    QString s;
+    if (corner && (params.count() > MAX_CORNER_PARAMS)) {
+        QStringList fixed = params.mid(MAX_CORNER_PARAMS);
+        for (QString &par : fixed) par = par.trimmed();
+        s += QString("echo Warning: corner analysis %1 varies only the first %2 parameters, "
+                     "%3 keep their values\n")
+                .arg(Name).arg(MAX_CORNER_PARAMS).arg(fixed.join(" "));
+    }
+
+    QString step_var = getStepVar();
+    s += getLoopStart(sim,lvl,step_var);
+    s += QString("setseed $%1_act\n").arg(step_var);
+    if (corner) s += QString("let mc_run = $%1_act - %2\n").arg(step_var).arg(getFirstRun());
+
+    QStringList nominals = getProperty("Nominal")->Value.split(param_split_str);
+    QStringList tolerances = getProperty("Tolerance")->Value.split(param_split_str);
+    QStringList distributions = getProperty("Distribution")->Value.split(param_split_str);
+
+    for (int i = 0; i < params.count(); i++) {
+        QString par = params.at(i).trimmed();
+        QString nom = QString::number(toNumber(nominals.value(i)),'g',12);
+        QString tol = QString::number(toNumber(tolerances.value(i)),'g',12);
+
+        if (corner) { // bit i of the run selects the lower or upper limit
+            if (i >= MAX_CORNER_PARAMS) continue;
+            double weight = 1 << i;
+            s += QString("let mc_bit = floor(mc_run/%1) - 2*floor(mc_run/%2)\n")
+                    .arg(weight).arg(2*weight);
+            s += QString("let mc_val = %1*(1+%2*(2*mc_bit-1))\n").arg(nom).arg(tol);
+        } else if (distributions.value(i).trimmed() == "unif") {
+            s += QString("let mc_val = %1*(1+%2*sunif(0))\n").arg(nom).arg(tol);
+        } else {
+            s += QString("let mc_val = %1*(1+%2/3*sgauss(0))\n").arg(nom).arg(tol);
+        }
+        s += getAlterScript(par, "$&mc_val", par, false);
+    }
+    return s;
+}
+
+QString SpiceMonteCarlo::getNgspiceAfterSim(QString sim, int lvl)
+{
+    if (isActive != COMP_IS_ACTIVE) return QString("");
+    return getLoopEnd(sim,lvl,getStepVar());
+}
+
+QString SpiceMonteCarlo::getCounterVar()
+{
+    return QString("number_%1").arg(getStepVar());
+}
+
+QString SpiceMonteCarlo::spice_netlist(bool)
+{
+    return QString(""); // the analysis is a part of the .control section only
+}
+
+// ---------------------------------------------------------------------
+// The run number is named after the component, e.g. "mc1".
+QString SpiceMonteCarlo::getStepVar()
+{
+    QString var = Name.toLower();
+    var.remove(QRegularExpression("[\\.\\[\\]@:]"));
+    return var;
+}
+
+// ---------------------------------------------------------------------
+int SpiceMonteCarlo::getFirstRun()
+{
+    bool ok;
+    int first = getProperty("Seed")->Value.toInt(&ok);
+    return ok ? first : 1;
+}
+
+// ---------------------------------------------------------------------
+// Converts a value with unit or a percentage into a plain number.
+double SpiceMonteCarlo::toNumber(const QString &value)
+{
+    QString s = value.trimmed();
+    if (s.endsWith('%')) {
+        s.chop(1);
+        return s.toDouble() / 100.0;
+    }
+    double num, fac;
+    QString unit;
+    misc::str2num(s, num, unit, fac);
+    return num * fac;
+}
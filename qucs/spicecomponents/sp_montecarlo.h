@@ -0,0 +1,57 @@
+/***************************************************************************
+                              sp_montecarlo.h
+                             -----------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SP_MONTECARLO_H
+#define SP_MONTECARLO_H
+
+#include "components/param_sweep.h"
+
+/*!
+ * \brief The SpiceMonteCarlo class is a Monte Carlo and corner analysis
+ *        for Ngspice. It is a parameter sweep over the run number: every
+ *        run sets the varied parameters to new values and repeats the
+ *        simulation. Monte Carlo runs draw the values from a gaussian or
+ *        uniform distribution around the nominal value, corner runs take
+ *        every combination of the lower and upper tolerance limits.
+ *
+ *        The random numbers of a run are seeded with the run number, so a
+ *        run gives the same values however the runs are split across
+ *        simulator processes. The results get the run number as outer
+ *        dependency, like a swept parameter named after the component.
+ */
+class SpiceMonteCarlo : public Param_Sweep  {
+public:
+  SpiceMonteCarlo();
+  ~SpiceMonteCarlo();
+  Component* newOne();
+  static Element* info(QString&, char* &, bool getNewOne=false);
+  void recreate(Schematic*) {}
+
+  QString getNgspiceBeforeSim(QString sim, int lvl=0);
+  QString getNgspiceAfterSim(QString sim, int lvl=0);
+  QString getCounterVar();
+  QStringList getSweepValues();
+
+protected:
+  QString spice_netlist(bool isXyce);
+
+private:
+  QString getStepVar();
+  int getFirstRun();
+  static double toNumber(const QString &value);
+};
+
+#endif
@@ -80,6 +80,7 @@
 #include "sp_fourier.h"
 #include "sp_disto.h"
 #include "sp_customsim.h"
+#include "sp_montecarlo.h"
 #include "sp_noise.h"
 #include "sp_pz.h"
 #include "xyce_script.h"
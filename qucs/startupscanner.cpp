@@ -0,0 +1,168 @@
+/***************************************************************************
+                            startupscanner.cpp
+                           --------------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "startupscanner.h"
+#include "libraryindex.h"
+#include "module.h"
+#include "componenticons.h"
+#include "main.h"
+
+#include <QThreadPool>
+#include <QRunnable>
+
+/*!
+  \file startupscanner.cpp
+  \brief Implementation of the StartupScanner class
+*/
+
+/*!
+ * \brief The StartupScanJob class runs one scan of a StartupScanner on
+ *        a pool thread.
+ */
+class StartupScanJob : public QRunnable
+{
+public:
+    typedef void (StartupScanner::*Scan)();
+    StartupScanJob(StartupScanner *scanner, Scan scan)
+        : Scanner(scanner), Function(scan) {}
+    void run() { (Scanner->*Function)(); }
+
+private:
+    StartupScanner *Scanner;
+    Scan Function;
+};
+
+// own pool, so the scans do not compete with simulations and builds
+static QThreadPool *scanPool()
+{
+    static QThreadPool pool;
+    return &pool;
+}
+
+StartupScanner::StartupScanner(QObject *parent)
+    : QObject(parent)
+{
+}
+
+StartupScanner::~StartupScanner()
+{
+    // the jobs use this object
+    scanPool()->waitForDone();
+}
+
+/*!
+ * \brief StartupScanner::start Start all scans.
+ * \param paths Path list to search for schematic and SPICE files
+ * \param workDir Working directory, searched last
+ * \param spiceExtensions File name filters of SPICE files
+ */
+void StartupScanner::start(const QStringList &paths, const QDir &workDir,
+                           const QStringList &spiceExtensions)
+{
+    Paths = paths;
+    WorkDir = workDir;
+    SpiceExtensions = spiceExtensions;
+
+    Module::beginRegistration();
+    scanPool()->start(new StartupScanJob(this, &StartupScanner::registerModules));
+    scanPool()->start(new StartupScanJob(this, &StartupScanner::scanNames));
+    scanPool()->start(new StartupScanJob(this, &StartupScanner::scanLibraries));
+}
+
+/*!
+ * \brief StartupScanner::scanFiles Map the base names of all files matching
+ *        the filters in the path list and in the working directory to
+ *        their absolute file names. Files in directories at the end of the
+ *        list take precedence over those at the start, the working
+ *        directory takes precedence over all.
+ */
+QHash<QString, QString> StartupScanner::scanFiles(const QStringList &paths,
+                                                  const QDir &workDir,
+                                                  const QStringList &filters)
+{
+    QHash<QString, QString> hash;
+    QStringList dirs = paths;
+    dirs.append(workDir.absolutePath());
+
+    for (const QString& path : dirs) {
+        QDir thispath(path);
+        QFileInfoList filesList = thispath.entryInfoList(filters, QDir::Files);
+        for (const QFileInfo& file : filesList) {
+            hash[file.completeBaseName()] = file.absoluteFilePath();
+        }
+    }
+    return hash;
+}
+
+// ---------------------------------------------------------------------
+void StartupScanner::scanNames()
+{
+    SchNames = scanFiles(Paths, WorkDir, QStringList("*.sch"));
+    SpiceNames = scanFiles(Paths, WorkDir, SpiceExtensions);
+    emit namesReady();
+}
+
+// ---------------------------------------------------------------------
+void StartupScanner::registerModules()
+{
+    Module::registerModules();
+    Module::endRegistration();
+    emit modulesReady();
+}
+
+/*!
+ * \brief StartupScanner::warmIcons Decode the palette icons in the
+ *        background while the user is still looking around. Must be
+ *        called on the GUI thread, which takes the snapshot of the
+ *        registry; the worker only sees file names.
+ */
+void StartupScanner::warmIcons()
+{
+    Icons = ComponentIcons::snapshot();
+    if (Icons.icons.isEmpty()) return;
+    scanPool()->start(new StartupScanJob(this, &StartupScanner::decodeIcons));
+}
+
+// ---------------------------------------------------------------------
+void StartupScanner::decodeIcons()
+{
+    ComponentIcons::warm(Icons);
+}
+
+// ---------------------------------------------------------------------
+// Brings the library index up to date, so the library tree is built
+// from memory afterwards.
+void StartupScanner::scanLibraries()
+{
+    LibraryIndex::Library lib;
+
+    QDir LibDir(QucsSettings.LibDir);
+    QStringList LibFiles = LibDir.entryList(QStringList("*.lib"), QDir::Files, QDir::Name);
+    for (QString libPath : LibFiles) {
+        libPath.chop(4); // remove extension
+        LibraryIndex::library(libPath, lib);
+    }
+
+    QDir UserLibDir(QucsSettings.QucsHomeDir.canonicalPath() + "/user_lib/");
+    LibFiles = UserLibDir.entryList(QStringList("*.lib"), QDir::Files, QDir::Name);
+    for (const QString &file : LibFiles) {
+        QString libPath(UserLibDir.absoluteFilePath(file));
+        libPath.chop(4); // remove extension
+        LibraryIndex::library(libPath, lib);
+    }
+
+    emit librariesReady();
+}
@@ -0,0 +1,88 @@
+/***************************************************************************
+                             startupscanner.h
+                            ------------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef STARTUPSCANNER_H
+#define STARTUPSCANNER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QDir>
+
+#include "componenticons.h"
+
+/*!
+  \file startupscanner.h
+  \brief Declaration of the StartupScanner class
+*/
+
+/*!
+ * \brief The StartupScanner class runs the slow startup scans on worker
+ *        threads, so the main window is shown at once:
+ *
+ *          - the schematic and SPICE file name hashes of the path list,
+ *          - the registration of all components (Module::registerModules()),
+ *          - the decoding of their palette icons, started by warmIcons()
+ *            once the GUI thread has the registry,
+ *          - the library index of the system and user libraries.
+ *
+ *        Each scan emits its own ready signal in the GUI thread. The module
+ *        registry blocks lookups until registration is complete, so code
+ *        which needs components before modulesReady() simply waits.
+ *        The destructor waits for all scans.
+ */
+class StartupScanner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StartupScanner(QObject *parent = 0);
+    ~StartupScanner();
+
+    void start(const QStringList &paths, const QDir &workDir,
+               const QStringList &spiceExtensions);
+    void warmIcons();
+
+    QHash<QString, QString> schNames() const { return SchNames; }
+    QHash<QString, QString> spiceNames() const { return SpiceNames; }
+
+    static QHash<QString, QString> scanFiles(const QStringList &paths,
+                                             const QDir &workDir,
+                                             const QStringList &filters);
+
+signals:
+    void namesReady();
+    void modulesReady();
+    void librariesReady();
+
+private:
+    friend class StartupScanJob;
+
+    void scanNames();
+    void registerModules();
+    void decodeIcons();
+    void scanLibraries();
+
+    QStringList Paths;
+    QDir WorkDir;
+    QStringList SpiceExtensions;
+
+    QHash<QString, QString> SchNames;
+    QHash<QString, QString> SpiceNames;
+    ComponentIcons::Snapshot Icons;
+};
+
+#endif // STARTUPSCANNER_H
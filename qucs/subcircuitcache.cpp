@@ -0,0 +1,398 @@
+/***************************************************************************
+                            subcircuitcache.cpp
+                           ---------------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "subcircuitcache.h"
+#include "schematic.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QRunnable>
+
+#include <algorithm>
+
+/*!
+  \file subcircuitcache.cpp
+  \brief Implementation of the SubcircuitCache class
+*/
+
+QMutex SubcircuitCache::CacheMutex;
+QHash<QString, SubcircuitCache::DocEntry> SubcircuitCache::Documents;
+QHash<QString, SubcircuitCache::NetlistEntry> SubcircuitCache::Netlists;
+quint64 SubcircuitCache::UseCounter = 0;
+QMutex SubcircuitCache::PrefetchMutex;
+QSet<QString> SubcircuitCache::PrefetchClaimed;
+QSet<QString> SubcircuitCache::PrefetchRunning;
+QWaitCondition SubcircuitCache::PrefetchDone;
+QHash<QString, SubcircuitCache::PrefetchEntry> SubcircuitCache::Prefetched;
+QThreadPool SubcircuitCache::PrefetchPool;
+
+/*!
+ * \brief The SubcircuitPrefetchJob class reads one subcircuit file on a
+ *        worker thread and schedules the nested subcircuits it finds.
+ */
+class SubcircuitPrefetchJob : public QRunnable
+{
+public:
+    SubcircuitPrefetchJob(const QString &file, QThreadPool *pool)
+        : File(file), Pool(pool) {}
+    void run();
+
+private:
+    QString resolve(const QString &name, const QString &dir);
+
+    QString File;
+    QThreadPool *Pool;
+};
+
+void SubcircuitPrefetchJob::run()
+{
+    SubcircuitCache::PrefetchEntry entry;
+    QFile file(File);
+    if (!file.open(QIODevice::ReadOnly)) {
+        SubcircuitCache::storePrefetch(File, entry, false);
+        return;
+    }
+    entry.mtime = QFileInfo(File).lastModified();
+    QTextStream stream(&file);
+    entry.text = stream.readAll();
+    file.close();
+
+    // scan the components for nested subcircuits; the file name is the
+    // first property, i.e. the first quoted string of a "<Sub" line
+    QString dir = QFileInfo(File).canonicalPath();
+    QTextStream lines(&entry.text, QIODevice::ReadOnly);
+    bool inComponents = false;
+    while (!lines.atEnd()) {
+        QString Line = lines.readLine().trimmed();
+        if (Line == "<Components>") {
+            inComponents = true;
+            continue;
+        }
+        if (Line == "</Components>") break;
+        if (!inComponents || !Line.startsWith("<Sub ")) continue;
+
+        int start = Line.indexOf('"');
+        int end = Line.indexOf('"', start + 1);
+        if (start < 0 || end < 0) continue;
+        QString nested = resolve(Line.mid(start + 1, end - start - 1), dir);
+        if (!nested.isEmpty() && SubcircuitCache::claimPrefetch(nested)) {
+            Pool->start(new SubcircuitPrefetchJob(nested, Pool));
+        }
+    }
+
+    SubcircuitCache::storePrefetch(File, entry, true);
+}
+
+/*!
+ * \brief SubcircuitPrefetchJob::resolve Thread-safe subset of
+ *        Subcircuit::getSubcircuitFile(). Names which can only be found
+ *        through the search path hash are left to the GUI thread.
+ */
+QString SubcircuitPrefetchJob::resolve(const QString &name, const QString &dir)
+{
+    if (name.isEmpty()) return QString();
+    QFileInfo inf(name);
+    if (inf.exists()) return inf.absoluteFilePath();
+    if (inf.fileName() == name) {
+        QFileInfo local(dir + "/" + inf.completeBaseName() + ".sch");
+        if (local.exists()) return local.absoluteFilePath();
+    }
+    return QString();
+}
+
+/*!
+ * \brief SubcircuitCache::document Return the parsed schematic of a
+ *        subcircuit file. The file is loaded on the first request and
+ *        reloaded only if its modification time has changed.
+ * \param file Absolute subcircuit file name
+ * \return Cached schematic (owned by the cache) or nullptr if the file
+ *         cannot be loaded. Callers must not delete it. It stays valid
+ *         until the next trim() or clear().
+ */
+Schematic* SubcircuitCache::document(const QString &file)
+{
+    QMutexLocker lock(&CacheMutex);
+    return findDocument(file);
+}
+
+// Unlocked part of document(), also used by collectDependencies().
+Schematic* SubcircuitCache::findDocument(const QString &file)
+{
+    QDateTime mtime = QFileInfo(file).lastModified();
+
+    QHash<QString, DocEntry>::iterator it = Documents.find(file);
+    if (it != Documents.end()) {
+        if (it->mtime == mtime) {
+            // undo what the last netlisting left behind
+            it->doc->DocName = file;
+            it->doc->clearSignals();
+            it->used = ++UseCounter;
+            return it->doc;
+        }
+        delete it->doc;
+        Documents.erase(it);
+    }
+
+    PrefetchEntry pre;
+    bool havePrefetched = false;
+    PrefetchMutex.lock();
+    while (PrefetchRunning.contains(file)) PrefetchDone.wait(&PrefetchMutex);
+    QHash<QString, PrefetchEntry>::iterator pit = Prefetched.find(file);
+    if (pit != Prefetched.end()) {
+        if (pit->mtime == mtime) {
+            pre = *pit;
+            havePrefetched = true;
+        }
+        Prefetched.erase(pit);
+    }
+    PrefetchMutex.unlock();
+
+    Schematic *d = new Schematic(0, file);
+    bool loaded;
+    if (havePrefetched) {
+        QTextStream stream(&pre.text, QIODevice::ReadOnly);
+        loaded = d->loadDocument(stream);
+    } else {
+        loaded = d->loadDocument();
+    }
+    if (!loaded) {
+        delete d;
+        return nullptr;
+    }
+    DocEntry entry;
+    entry.doc = d;
+    entry.mtime = mtime;
+    entry.used = ++UseCounter;
+    Documents.insert(file, entry);
+    return d;
+}
+
+/*!
+ * \brief SubcircuitCache::netlist Look up a previously generated
+ *        subcircuit netlist.
+ * \param file Absolute subcircuit file name
+ * \param dialect Simulator dialect and subcircuit name the netlist was
+ *        generated for
+ * \param[out] text Netlist text including nested subcircuits
+ * \param[out] portTypes Signal types of the subcircuit ports
+ * \param[out] nested FileList entries of the subcircuits and files whose
+ *        definitions are part of the text. The caller must register them
+ *        so they are not emitted a second time.
+ * \return true if a netlist was found and none of the files it was built
+ *         from has been modified since
+ */
+bool SubcircuitCache::netlist(const QString &file, const QString &dialect,
+                              QString &text, QStringList &portTypes, SubMap &nested)
+{
+    QMutexLocker lock(&CacheMutex);
+    QHash<QString, NetlistEntry>::iterator it =
+            Netlists.find(file + '\n' + dialect);
+    if (it == Netlists.end()) return false;
+
+    if (!dependenciesValid(*it)) {
+        Netlists.erase(it);
+        return false;
+    }
+    it->used = ++UseCounter;
+    text = it->text;
+    portTypes = it->portTypes;
+    nested = it->nested;
+    return true;
+}
+
+bool SubcircuitCache::dependenciesValid(const NetlistEntry &entry)
+{
+    for (auto dep = entry.depends.constBegin(); dep != entry.depends.constEnd(); ++dep) {
+        if (QFileInfo(dep.key()).lastModified() != dep.value()) return false;
+    }
+    return true;
+}
+
+/*!
+ * \brief SubcircuitCache::storeNetlist Remember a generated subcircuit
+ *        netlist together with the modification times of the subcircuit
+ *        file and of all files it refers to (recursively).
+ */
+void SubcircuitCache::storeNetlist(const QString &file, const QString &dialect,
+                                   const QString &text, const QStringList &portTypes,
+                                   const SubMap &nested)
+{
+    QMutexLocker lock(&CacheMutex);
+    NetlistEntry entry;
+    entry.text = text;
+    entry.portTypes = portTypes;
+    entry.nested = nested;
+    entry.used = ++UseCounter;
+    collectDependencies(file, entry.depends);
+    Netlists.insert(file + '\n' + dialect, entry);
+}
+
+/*!
+ * \brief SubcircuitCache::clear Drop all cached documents and netlists.
+ */
+void SubcircuitCache::clear()
+{
+    QMutexLocker lock(&CacheMutex);
+    for (const DocEntry &entry : Documents) {
+        delete entry.doc;
+    }
+    Documents.clear();
+    Netlists.clear();
+    dropPrefetched();
+}
+
+/*!
+ * \brief SubcircuitCache::trim Drop the documents and netlists of files
+ *        which have been modified or deleted, then the least recently
+ *        used entries beyond MaxDocuments and MaxNetlists. Must not be
+ *        called while a document returned by document() is in use.
+ */
+void SubcircuitCache::trim()
+{
+    QMutexLocker lock(&CacheMutex);
+
+    for (auto it = Documents.begin(); it != Documents.end(); ) {
+        QFileInfo inf(it.key());
+        if (!inf.exists() || (inf.lastModified() != it->mtime)) {
+            delete it->doc;
+            it = Documents.erase(it);
+        } else ++it;
+    }
+    for (auto it = Netlists.begin(); it != Netlists.end(); ) {
+        if (!dependenciesValid(*it)) it = Netlists.erase(it);
+        else ++it;
+    }
+
+    if (Documents.size() > MaxDocuments) {
+        QList<quint64> stamps;
+        for (const DocEntry &entry : Documents) stamps.append(entry.used);
+        std::sort(stamps.begin(), stamps.end());
+        quint64 oldest = stamps.at(Documents.size() - MaxDocuments - 1);
+        for (auto it = Documents.begin(); it != Documents.end(); ) {
+            if (it->used <= oldest) {
+                delete it->doc;
+                it = Documents.erase(it);
+            } else ++it;
+        }
+    }
+    if (Netlists.size() > MaxNetlists) {
+        QList<quint64> stamps;
+        for (const NetlistEntry &entry : Netlists) stamps.append(entry.used);
+        std::sort(stamps.begin(), stamps.end());
+        quint64 oldest = stamps.at(Netlists.size() - MaxNetlists - 1);
+        for (auto it = Netlists.begin(); it != Netlists.end(); ) {
+            if (it->used <= oldest) it = Netlists.erase(it);
+            else ++it;
+        }
+    }
+}
+
+/*!
+ * \brief SubcircuitCache::prefetch Start reading all distinct subcircuit
+ *        files of the hierarchy below "top" on worker threads. Files whose
+ *        parsed document is still valid are skipped. Returns at once;
+ *        document() waits for a file which is still being read.
+ * \param top Schematic which is about to be netlisted
+ */
+void SubcircuitCache::prefetch(Schematic *top)
+{
+    dropPrefetched();
+
+    QStringList files;
+    for (Component *pc : top->DocComps) {
+        if (pc->Model != "Sub") continue;
+        pc->setSchematic(top);
+        QString f = pc->getSubcircuitFile();
+        if (!f.isEmpty() && !files.contains(f)) files.append(f);
+    }
+    if (files.isEmpty()) return;
+
+    CacheMutex.lock();
+    PrefetchMutex.lock();
+    PrefetchClaimed.clear();
+    for (auto it = Documents.constBegin(); it != Documents.constEnd(); ++it) {
+        if (QFileInfo(it.key()).lastModified() == it->mtime)
+            PrefetchClaimed.insert(it.key());
+    }
+    CacheMutex.unlock();
+    for (auto it = Prefetched.constBegin(); it != Prefetched.constEnd(); ++it) {
+        if (QFileInfo(it.key()).lastModified() == it->mtime)
+            PrefetchClaimed.insert(it.key());
+    }
+    PrefetchMutex.unlock();
+
+    for (const QString &f : files) {
+        if (claimPrefetch(f))
+            PrefetchPool.start(new SubcircuitPrefetchJob(f, &PrefetchPool));
+    }
+}
+
+/*!
+ * \brief SubcircuitCache::dropPrefetched Wait for the running reads and
+ *        free the file texts which were not turned into documents.
+ */
+void SubcircuitCache::dropPrefetched()
+{
+    PrefetchPool.waitForDone();
+    QMutexLocker lock(&PrefetchMutex);
+    Prefetched.clear();
+    PrefetchClaimed.clear();
+}
+
+/*!
+ * \brief SubcircuitCache::claimPrefetch Mark a file as being read.
+ * \return false if the file is already read or scheduled
+ */
+bool SubcircuitCache::claimPrefetch(const QString &file)
+{
+    QMutexLocker lock(&PrefetchMutex);
+    if (PrefetchClaimed.contains(file)) return false;
+    PrefetchClaimed.insert(file);
+    PrefetchRunning.insert(file);
+    return true;
+}
+
+void SubcircuitCache::storePrefetch(const QString &file, const PrefetchEntry &entry, bool ok)
+{
+    QMutexLocker lock(&PrefetchMutex);
+    if (ok) Prefetched.insert(file, entry);
+    PrefetchRunning.remove(file);
+    PrefetchDone.wakeAll();
+}
+
+/*!
+ * \brief SubcircuitCache::collectDependencies Collect the modification
+ *        times of a subcircuit file and of all subcircuit, SPICE and
+ *        library files used inside it.
+ */
+void SubcircuitCache::collectDependencies(const QString &file,
+                                          QHash<QString, QDateTime> &depends)
+{
+    if (depends.contains(file)) return; // already visited
+    depends.insert(file, QFileInfo(file).lastModified());
+
+    Schematic *d = findDocument(file);
+    if (d == nullptr) return;
+    for (Component *pc : d->DocComps) {
+        pc->setSchematic(d);
+        QString f = pc->getSubcircuitFile();
+        if (f.isEmpty()) continue;
+        if (pc->Model == "Sub") collectDependencies(f, depends);
+        else depends.insert(f, QFileInfo(f).lastModified());
+    }
+}
@@ -0,0 +1,118 @@
+/***************************************************************************
+                             subcircuitcache.h
+                            -------------------
+    begin                : 2024
+    copyright            : QUCS Developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SUBCIRCUITCACHE_H
+#define SUBCIRCUITCACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QDateTime>
+#include <QMutex>
+#include <QSet>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include "schematic.h"
+
+/*!
+  \file subcircuitcache.h
+  \brief Declaration of the SubcircuitCache class
+*/
+
+/*!
+ * \brief The SubcircuitCache class is a process-wide cache of parsed
+ *        subcircuit schematics and of the subcircuit netlists generated
+ *        from them. Documents are keyed by file path and validated by
+ *        modification time; netlists are additionally keyed by simulator
+ *        dialect and validated by the modification times of every file
+ *        they were built from. Netlisting and the XSPICE builder share it,
+ *        so every subcircuit file is parsed only once per change.
+ *
+ *        trim() is called before each netlist, when no cached document is
+ *        in use. It drops the entries of changed or deleted files and the
+ *        least recently used ones beyond MaxDocuments and MaxNetlists.
+ *
+ *        Before a SPICE netlist, prefetch() starts reading all distinct
+ *        subcircuit files of the hierarchy on a thread pool and returns.
+ *        Only the file input runs in parallel: schematics are widgets and
+ *        must be parsed on the GUI thread, so document() turns the text
+ *        into a Schematic in the usual netlisting order, waiting only for
+ *        the file it needs. The reads thus overlap with the parsing of
+ *        the files read before. dropPrefetched() frees the texts which
+ *        were not used.
+ */
+class SubcircuitCache
+{
+public:
+    static Schematic* document(const QString &file);
+    static bool netlist(const QString &file, const QString &dialect,
+                        QString &text, QStringList &portTypes, SubMap &nested);
+    static void storeNetlist(const QString &file, const QString &dialect,
+                             const QString &text, const QStringList &portTypes,
+                             const SubMap &nested);
+    static void clear();
+    static void trim();
+
+    static const int MaxDocuments = 64;
+    static const int MaxNetlists = 256;
+    static void prefetch(Schematic *top);
+    static void dropPrefetched();
+
+private:
+    struct DocEntry {
+        Schematic *doc;
+        QDateTime mtime;
+        quint64 used;    // for least recently used eviction
+    };
+    struct NetlistEntry {
+        QString text;
+        QStringList portTypes;
+        SubMap nested;   // subcircuits and files emitted inside the text
+        QHash<QString, QDateTime> depends; // file -> mtime at build time
+        quint64 used;
+    };
+
+    struct PrefetchEntry {
+        QString text;
+        QDateTime mtime;
+    };
+
+    friend class SubcircuitPrefetchJob;
+
+    static Schematic* findDocument(const QString &file);
+    static void collectDependencies(const QString &file,
+                                    QHash<QString, QDateTime> &depends);
+    static bool dependenciesValid(const NetlistEntry &entry);
+    static bool claimPrefetch(const QString &file);
+    static void storePrefetch(const QString &file, const PrefetchEntry &entry, bool ok);
+
+    // used on the GUI thread, guarded by CacheMutex all the same
+    static QMutex CacheMutex;
+    static QHash<QString, DocEntry> Documents;
+    static QHash<QString, NetlistEntry> Netlists;
+    static quint64 UseCounter;
+
+    // filled by the prefetch threads, guarded by PrefetchMutex
+    static QMutex PrefetchMutex;
+    static QSet<QString> PrefetchClaimed;
+    static QSet<QString> PrefetchRunning;   // claimed but not read yet
+    static QWaitCondition PrefetchDone;
+    static QHash<QString, PrefetchEntry> Prefetched;
+    static QThreadPool PrefetchPool;
+};
+
+#endif // SUBCIRCUITCACHE_H
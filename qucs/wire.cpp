@@ -15,6 +15,7 @@
  *                                                                         *
  ***************************************************************************/
 #include "wire.h"
+#include "linetokenizer.h"
 
 #include <QPainter>
 
@@ -167,41 +168,41 @@ QString Wire::save()
 bool Wire::load(const QString& _s)
 {
   bool ok;
-  QString s = _s;
 
-  if(s.at(0) != '<') return false;
-  if(s.at(s.length()-1) != '>') return false;
-  s = s.mid(1, s.length()-2);   // cut off start and end character
+  if(_s.at(0) != '<') return false;
+  if(_s.at(_s.length()-1) != '>') return false;
+  // cut off start and end character
+  LineTokenizer s(_s, 1, _s.length()-2);
 
   QString n;
-  n  = s.section(' ',0,0);    // x1
+  n  = s.fieldView(0);    // x1
   x1 = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',1,1);    // y1
+  n  = s.fieldView(1);    // y1
   y1 = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',2,2);    // x2
+  n  = s.fieldView(2);    // x2
   x2 = n.toInt(&ok);
   if(!ok) return false;
 
-  n  = s.section(' ',3,3);    // y2
+  n  = s.fieldView(3);    // y2
   y2 = n.toInt(&ok);
   if(!ok) return false;
 
-  n = s.section('"',1,1);
+  n = s.section(1);
   if(!n.isEmpty()) {     // is wire labeled ?
-    int nx = s.section(' ',5,5).toInt(&ok);   // x coordinate
+    int nx = s.toInt(5, &ok);   // x coordinate
     if(!ok) return false;
 
-    int ny = s.section(' ',6,6).toInt(&ok);   // y coordinate
+    int ny = s.toInt(6, &ok);   // y coordinate
     if(!ok) return false;
 
-    int delta = s.section(' ',7,7).toInt(&ok);// delta for x/y root coordinate
+    int delta = s.toInt(7, &ok);// delta for x/y root coordinate
     if(!ok) return false;
 
-    setName(n, s.section('"',3,3), delta, nx, ny);  // Wire Label
+    setName(n, s.section(3), delta, nx, ny);  // Wire Label
   }
 
   return true;